@@ -33,6 +33,7 @@
 // Coyote-specific includes
 #include <coyote/cBench.hpp>
 #include <coyote/cThread.hpp>
+#include <coyote/cRdmaStream.hpp>
 #include <constants.hpp>
 
 constexpr bool const IS_CLIENT = true;
@@ -86,11 +87,53 @@ double run_bench(
     return bench.getAvg() / (1. + (double) operation);
 }
 
+/* Streaming benchmark for RDMA WRITEs: instead of waiting for every message, the client keeps up to window WRITEs
+ * in flight, while the server consumes the messages from a ring of receive slots and returns credits for the free slots.
+ * Unlike run_bench(...), the data only travels one way (client to server).
+ */
+double run_stream_bench(
+    coyote::cThread &coyote_thread, int *mem, uint size, uint max_size, uint window, uint n_runs
+) {
+    // Both ends use the same layout: a credit word, followed by as many slots as fit into the ring
+    coyote::rdmaStreamCfg cfg;
+    cfg.window = window;
+    cfg.slot_size = size;
+    cfg.n_slots = STREAM_RING_SIZE(max_size) / size;
+    cfg.ring_offs = STREAM_RING_OFFS;
+    cfg.credit_offs = STREAM_CREDIT_OFFS;
+    cfg.credit_batch = std::max(cfg.n_slots / 4, 1u);
+    coyote::cRdmaStream stream(&coyote_thread, cfg);
+
+    // The messages are sent from the same slots in the local buffer; the server checks the payload
+    for (uint i = 0; i < STREAM_RING_SIZE(max_size) / sizeof(int); i++) {
+        mem[STREAM_RING_OFFS / sizeof(int) + i] = i % (size / sizeof(int));
+    }
+
+    // The server flushes its credit updates before the sync, so the stream can only be reset after it
+    auto prep_fn = [&]() {
+        coyote_thread.clearCompleted();
+        coyote_thread.connSync(IS_CLIENT);
+        stream.reset();
+    };
+
+    auto bench_fn = [&]() {
+        for (uint64_t i = 0; i < N_STREAM_REPS; i++) {
+            coyote::rdmaSg sg = { .local_offs = STREAM_RING_OFFS + (i % cfg.n_slots) * size, .len = size };
+            stream.post(sg);
+        }
+        stream.flush();
+    };
+
+    coyote::cBench bench(n_runs, 0);
+    bench.execute(bench_fn, prep_fn);
+    return bench.getAvg();
+}
+
 int main(int argc, char *argv[])  {
     // CLI arguments
     bool operation;
     std::string server_ip;
-    unsigned int min_size, max_size, n_runs;
+    unsigned int min_size, max_size, n_runs, window;
 
     boost::program_options::options_description runtime_options("Coyote Perf RDMA Options");
     runtime_options.add_options()
@@ -98,7 +141,8 @@ int main(int argc, char *argv[])  {
         ("operation,o", boost::program_options::value<bool>(&operation)->default_value(false), "Benchmark operation: READ(0) or WRITE(1)")
         ("runs,r", boost::program_options::value<unsigned int>(&n_runs)->default_value(N_RUNS_DEFAULT), "Number of times to repeat the test")
         ("min_size,x", boost::program_options::value<unsigned int>(&min_size)->default_value(MIN_TRANSFER_SIZE_DEFAULT), "Starting (minimum) transfer size")
-        ("max_size,X", boost::program_options::value<unsigned int>(&max_size)->default_value(MAX_TRANSFER_SIZE_DEFAULT), "Ending (maximum) transfer size");
+        ("max_size,X", boost::program_options::value<unsigned int>(&max_size)->default_value(MAX_TRANSFER_SIZE_DEFAULT), "Ending (maximum) transfer size")
+        ("stream,s", boost::program_options::value<unsigned int>(&window)->default_value(0), "Streaming WRITEs with a window of outstanding operations; 0 disables");
     boost::program_options::variables_map command_line_arguments;
     boost::program_options::store(boost::program_options::parse_command_line(argc, argv, runtime_options), command_line_arguments);
     boost::program_options::notify(command_line_arguments);
@@ -108,7 +152,12 @@ int main(int argc, char *argv[])  {
     std::cout << "Benchmark operation: " << (operation ? "WRITE" : "READ") << std::endl;
     std::cout << "Number of test runs: " << n_runs << std::endl;
     std::cout << "Starting transfer size: " << min_size << std::endl;
-    std::cout << "Ending transfer size: " << max_size << std::endl << std::endl;
+    std::cout << "Ending transfer size: " << max_size << std::endl;
+    std::cout << "Streaming window: " << window << std::endl << std::endl;
+
+    if (window && !operation) {
+        throw std::runtime_error("Streaming mode is only supported for WRITEs; exiting...");
+    }
 
     /* Coyote completely abstracts the complexity behind exchanging QPs and setting up an RDMA connection
      * Instead, given a cThread, the target RDMA buffer size and the remote server's TCP address,
@@ -116,7 +165,8 @@ int main(int argc, char *argv[])  {
      * Exchange the necessary information with the server; the server calls the equivalent function but without the IP address
      */
     coyote::cThread coyote_thread(DEFAULT_VFPGA_ID, getpid(), 0);
-    int *mem = (int *) coyote_thread.initRDMA(max_size, coyote::DEF_PORT, server_ip.c_str());
+    uint32_t buffer_size = window ? STREAM_RING_OFFS + STREAM_RING_SIZE(max_size) : max_size;
+    int *mem = (int *) coyote_thread.initRDMA(buffer_size, coyote::DEF_PORT, server_ip.c_str());
     if (!mem) { throw std::runtime_error("Could not allocate memory; exiting..."); }
 
     // Benchmark sweep of latency and throughput
@@ -124,6 +174,14 @@ int main(int argc, char *argv[])  {
     unsigned int curr_size = min_size;
     while(curr_size <= max_size) {
         std::cout << "Size: " << std::setw(8) << curr_size << "; ";
+
+        if (window) {
+            double stream_time = run_stream_bench(coyote_thread, mem, curr_size, max_size, window, n_runs);
+            double stream_throughput = ((double) N_STREAM_REPS * (double) curr_size) / (1024.0 * 1024.0 * stream_time * 1e-9);
+            std::cout << "Average streaming throughput: " << std::setw(8) << stream_throughput << " MB/s" << std::endl;
+            curr_size *= 2;
+            continue;
+        }
         
         coyote::rdmaSg sg = { .len = curr_size };
     
@@ -39,3 +39,9 @@
 #define MIN_TRANSFER_SIZE_DEFAULT   64
 #define MAX_TRANSFER_SIZE_DEFAULT   (1 * 1024 * 1024)
 
+
+// Streaming mode (--stream); the RDMA buffer holds a 64-bit credit word, followed by a ring of receive slots
+#define N_STREAM_REPS       1024
+#define STREAM_CREDIT_OFFS  0
+#define STREAM_RING_OFFS    64
+#define STREAM_RING_SIZE(max_size) (4 * (max_size))
@@ -32,6 +32,7 @@
 
 // Coyote-specific includes
 #include <coyote/cThread.hpp>
+#include <coyote/cRdmaStream.hpp>
 #include <constants.hpp>
 
 constexpr bool const IS_CLIENT = false;
@@ -74,17 +75,50 @@ void run_bench(
     }
 }
 
+// Receiving end of the streaming benchmark, see run_stream_bench(...) in client/main.cpp
+void run_stream_bench(coyote::cThread &coyote_thread, uint size, uint max_size, uint n_runs) {
+    coyote::rdmaStreamCfg cfg;
+    cfg.slot_size = size;
+    cfg.n_slots = STREAM_RING_SIZE(max_size) / size;
+    cfg.ring_offs = STREAM_RING_OFFS;
+    cfg.credit_offs = STREAM_CREDIT_OFFS;
+    cfg.credit_batch = std::max(cfg.n_slots / 4, 1u);
+    coyote::cRdmaStream stream(&coyote_thread, cfg);
+
+    for (uint r = 0; r < n_runs; r++) {
+        // Wait for the credit updates of the previous run, before the client resets its stream
+        stream.flush();
+        coyote_thread.clearCompleted();
+        stream.reset();
+        coyote_thread.connSync(IS_CLIENT);
+
+        // Check every message and hand its slot back to the client
+        uint64_t n_msgs = 0;
+        while (n_msgs < N_STREAM_REPS) {
+            uint32_t n_new = stream.receive();
+            for (uint32_t i = 0; i < n_new; i++) {
+                int *msg = (int *) stream.getSlot(n_msgs + i);
+                assert(msg[size / sizeof(int) - 1] == static_cast<int>(size / sizeof(int) - 1));
+            }
+            stream.release(n_new);
+            n_msgs += n_new;
+        }
+    }
+    stream.flush();
+}
+
 int main(int argc, char *argv[])  {
     // CLI arguments
     bool operation;
-    unsigned int min_size, max_size, n_runs;
+    unsigned int min_size, max_size, n_runs, window;
 
     boost::program_options::options_description runtime_options("Coyote Perf RDMA Options");
     runtime_options.add_options()
         ("operation,o", boost::program_options::value<bool>(&operation)->default_value(false), "Benchmark operation: READ(0) or WRITE(1)")
         ("runs,r", boost::program_options::value<unsigned int>(&n_runs)->default_value(N_RUNS_DEFAULT), "Number of times to repeat the test")
         ("min_size,x", boost::program_options::value<unsigned int>(&min_size)->default_value(MIN_TRANSFER_SIZE_DEFAULT), "Starting (minimum) transfer size")
-        ("max_size,X", boost::program_options::value<unsigned int>(&max_size)->default_value(MAX_TRANSFER_SIZE_DEFAULT), "Ending (maximum) transfer size");
+        ("max_size,X", boost::program_options::value<unsigned int>(&max_size)->default_value(MAX_TRANSFER_SIZE_DEFAULT), "Ending (maximum) transfer size")
+        ("stream,s", boost::program_options::value<unsigned int>(&window)->default_value(0), "Streaming WRITEs (any non-zero value, must match the client); 0 disables");
     boost::program_options::variables_map command_line_arguments;
     boost::program_options::store(boost::program_options::parse_command_line(argc, argv, runtime_options), command_line_arguments);
     boost::program_options::notify(command_line_arguments);
@@ -93,18 +127,26 @@ int main(int argc, char *argv[])  {
     std::cout << "Benchmark operation: " << (operation ? "WRITE" : "READ") << std::endl;
     std::cout << "Number of test runs: " << n_runs << std::endl;
     std::cout << "Starting transfer size: " << min_size << std::endl;
-    std::cout << "Ending transfer size: " << max_size << std::endl << std::endl;
+    std::cout << "Ending transfer size: " << max_size << std::endl;
+    std::cout << "Streaming: " << (window ? "ON" : "OFF") << std::endl << std::endl;
 
     // Allocate Coyothe threa and set-up RDMA connections, buffer etc.
     // initRDMA is explained in more detail in client/main.cpp
     coyote::cThread coyote_thread(DEFAULT_VFPGA_ID, getpid());
-    int *mem = (int *) coyote_thread.initRDMA(max_size, coyote::DEF_PORT);
+    uint32_t buffer_size = window ? STREAM_RING_OFFS + STREAM_RING_SIZE(max_size) : max_size;
+    int *mem = (int *) coyote_thread.initRDMA(buffer_size, coyote::DEF_PORT);
     if (!mem) { throw std::runtime_error("Could not allocate memory; exiting..."); }
 
     // Benchmark sweep; exactly like done in the client code
     HEADER("RDMA BENCHMARK: SERVER");
     unsigned int curr_size = min_size;
     while(curr_size <= max_size) {
+        if (window) {
+            run_stream_bench(coyote_thread, curr_size, max_size, n_runs);
+            curr_size *= 2;
+            continue;
+        }
+
         coyote::rdmaSg sg = { .len = curr_size };
         run_bench(coyote_thread, sg, mem, N_THROUGHPUT_REPS, n_runs, operation);
         run_bench(coyote_thread, sg, mem, N_LATENCY_REPS, n_runs, operation);
@@ -0,0 +1,525 @@
+/**
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_SOFT_VFPGA_HPP_
+#define _COYOTE_SOFT_VFPGA_HPP_
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <bitset>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include <sys/eventfd.h>
+
+#include <coyote/cDefs.hpp>
+
+namespace coyote {
+
+class SoftVfpga;
+
+/// @brief Shell features and timing parameters of a software vFPGA
+struct SoftVfpgaCnfg {
+    /// Completion counters are reported through the (modelled) writeback region
+    bool en_wb = { true };
+
+    /// Streams from host memory enabled
+    bool en_strm = { true };
+
+    /// Modelled DMA bandwidth per channel, in bytes per nanosecond (i.e., GB/s); 0 disables throttling
+    double bandwidth = { 0.0 };
+
+    /// Modelled fixed latency added to every command, in nanoseconds
+    uint32_t cmd_latency = { 0 };
+};
+
+/// @brief A chunk of data delivered to a software kernel by a LOCAL_READ (the equivalent of a transfer on axis_(host|card)_recv[dest])
+struct SoftPacket {
+    /// Coyote thread ID that issued the command
+    int32_t ctid;
+
+    /// Source stream: HOST or CARD
+    uint32_t stream;
+
+    /// AXI4 stream the data arrives on
+    uint32_t dest;
+
+    /// Set when the command was issued with last = true
+    bool last;
+
+    /// Pointer to the data, valid only for the duration of the kernel call
+    const char *data;
+
+    /// Length of the data, in bytes
+    uint32_t len;
+};
+
+/**
+ * @brief User logic of a software vFPGA
+ *
+ * Called by the read engine for every LOCAL_READ (or the read half of a LOCAL_TRANSFER). The kernel
+ * produces output by calling SoftVfpga::send(...), which makes the data available to subsequent
+ * LOCAL_WRITEs on the same stream and dest, and can access the user CSRs and raise user interrupts.
+ */
+using SoftKernel = std::function<void(const SoftPacket &in, SoftVfpga &vfpga)>;
+
+/**
+ * @brief In-process model of a vFPGA, used by the software backend of cThread
+ *
+ * The model replaces the shell and the user logic with host threads, so that everything
+ * above cThread can be exercised at realistic rates without a card or Vivado:
+ *  - Command FIFO: commands posted through cThread::postCmd() are split in a read and a write half
+ *    (as in the shell), each processed in order by a dedicated engine thread. The fill level is exposed
+ *    through fifoLevel(), the equivalent of reading CTRL_REG, so that CMD_FIFO_DEPTH/CMD_FIFO_THR backpressure behaves as on hardware.
+ *  - Writeback: per-ctid completion counters (RD_WBACK, WR_WBACK etc.), incremented for commands with last set.
+ *  - CSR space: a plain array of CTRL_REGION_SIZE bytes, mapped as cThread's ctrl_reg.
+ *  - User logic: a SoftKernel per vFPGA; the default one loops the data back to the same stream.
+ *
+ * One instance exists per (device, vFPGA) and is shared by all cThreads attached to it.
+ */
+class SoftVfpga {
+public:
+    /// Default kernel; sends the incoming data back on the same stream and dest
+    static void loopback(const SoftPacket &in, SoftVfpga &vfpga) {
+        vfpga.send(in.stream, in.dest, in.data, in.len);
+    }
+
+    /**
+     * @brief Registers the user logic for a vFPGA; applies to the running instance, if any, and all future ones
+     *
+     * @param vfid vFPGA ID
+     * @param kernel Kernel to be executed for every read command
+     * @param device Device number
+     */
+    static void registerKernel(int32_t vfid, SoftKernel kernel, uint32_t device = 0) {
+        std::lock_guard<std::mutex> guard(registryLock());
+        std::string id = key(device, vfid);
+        kernelRegistry()[id] = kernel;
+        auto it = instances().find(id);
+        if (it != instances().end()) {
+            if (auto vfpga = it->second.lock()) {
+                std::lock_guard<std::mutex> lock(vfpga->kernel_mtx);
+                vfpga->kernel = kernel;
+            }
+        }
+    }
+
+    /**
+     * @brief Sets the shell configuration for a vFPGA; only applies to instances created afterwards
+     */
+    static void setCnfg(int32_t vfid, SoftVfpgaCnfg cnfg, uint32_t device = 0) {
+        std::lock_guard<std::mutex> guard(registryLock());
+        cnfgRegistry()[key(device, vfid)] = cnfg;
+    }
+
+    /**
+     * @brief Returns the instance for (device, vfid), creating it if there is none
+     *
+     * The instance lives as long as at least one cThread holds the returned pointer.
+     */
+    static std::shared_ptr<SoftVfpga> attach(int32_t vfid, uint32_t device = 0) {
+        std::lock_guard<std::mutex> guard(registryLock());
+        std::string id = key(device, vfid);
+        auto it = instances().find(id);
+        if (it != instances().end()) {
+            if (auto vfpga = it->second.lock()) {
+                return vfpga;
+            }
+        }
+
+        SoftVfpgaCnfg cnfg;
+        if (cnfgRegistry().find(id) != cnfgRegistry().end()) {
+            cnfg = cnfgRegistry()[id];
+        }
+        SoftKernel kernel = loopback;
+        if (kernelRegistry().find(id) != kernelRegistry().end()) {
+            kernel = kernelRegistry()[id];
+        }
+
+        auto vfpga = std::make_shared<SoftVfpga>(cnfg, kernel);
+        instances()[id] = vfpga;
+        return vfpga;
+    }
+
+    SoftVfpga(SoftVfpgaCnfg cnfg, SoftKernel kernel) : cnfg(cnfg), kernel(kernel), csr(CTRL_REGION_SIZE / sizeof(uint64_t), 0) {
+        for (auto &cnt : wback) {
+            cnt.store(0, std::memory_order_relaxed);
+        }
+        for (auto &fd : irq_efd) {
+            fd = -1;
+        }
+
+        rd_engine = std::thread(&SoftVfpga::runEngine, this, true);
+        wr_engine = std::thread(&SoftVfpga::runEngine, this, false);
+    }
+
+    ~SoftVfpga() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            running = false;
+        }
+        cv.notify_all();
+        rd_engine.join();
+        wr_engine.join();
+    }
+
+    /// Getter: shell configuration
+    const SoftVfpgaCnfg& getCnfg() const { return cnfg; }
+
+    /// Obtains a free Coyote thread ID; returns -1 if all N_CTID_MAX are taken
+    int32_t registerCtid() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (int32_t i = 0; i < N_CTID_MAX; i++) {
+            if (!ctids.test(i)) {
+                ctids.set(i);
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /// Releases a Coyote thread ID; drops its outstanding commands and waits for the ones in flight
+    void unregisterCtid(int32_t ctid) {
+        std::unique_lock<std::mutex> lock(mtx);
+        for (auto *queue : {&rd_queue, &wr_queue}) {
+            for (auto it = queue->begin(); it != queue->end();) {
+                it = (cmdCtid(it->ctrl) == ctid) ? queue->erase(it) : std::next(it);
+            }
+        }
+        abort_ctid = ctid;
+        cv.notify_all();
+        cv.wait(lock, [&] { return rd_active != ctid && wr_active != ctid; });
+        abort_ctid = -1;
+
+        ctids.reset(ctid);
+        irq_efd[ctid] = -1;
+        irq_values[ctid].clear();
+    }
+
+    /// Base address of the user CSR space, mapped to cThread::ctrl_reg
+    uint64_t* getCsrBase() { return csr.data(); }
+
+    /// Reads a user CSR; intended for kernels
+    uint64_t getCSR(uint32_t offs) const { return reinterpret_cast<const volatile uint64_t*>(csr.data())[offs]; }
+
+    /// Writes a user CSR; intended for kernels
+    void setCSR(uint64_t val, uint32_t offs) { reinterpret_cast<volatile uint64_t*>(csr.data())[offs] = val; }
+
+    /**
+     * @brief Posts a command, with the same layout as the one written to CTRL_REG by cThread::postCmd()
+     *
+     * @param offs_3 Destination address
+     * @param offs_2 Destination control signals
+     * @param offs_1 Source address
+     * @param offs_0 Source control signals
+     */
+    void post(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (offs_0 & CTRL_START) {
+                rd_queue.push_back({offs_1, offs_0});
+                n_rd_cmds++;
+            }
+            if (offs_2 & CTRL_START) {
+                wr_queue.push_back({offs_3, offs_2});
+                n_wr_cmds++;
+            }
+        }
+        cv.notify_all();
+    }
+
+    /// Number of commands that are queued or in flight on the busier of the two channels; equivalent of reading CTRL_REG
+    uint32_t fifoLevel() {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint32_t rd_level = rd_queue.size() + (rd_active != -1 ? 1 : 0);
+        uint32_t wr_level = wr_queue.size() + (wr_active != -1 ? 1 : 0);
+        return std::max(rd_level, wr_level);
+    }
+
+    /// Reads a completion counter; idx is one of RD_WBACK, WR_WBACK, RD_RDMA_WBACK, WR_RDMA_WBACK
+    uint32_t getCompleted(int32_t ctid, uint32_t idx) const {
+        return wback[ctid + idx * N_CTID_MAX].load(std::memory_order_acquire);
+    }
+
+    /// Clears all completion counters for a Coyote thread
+    void clearCompleted(int32_t ctid) {
+        for (uint32_t i = 0; i < N_WBACKS; i++) {
+            wback[ctid + i * N_CTID_MAX].store(0, std::memory_order_release);
+        }
+    }
+
+    /// Makes data available on axis_(host|card)_send[dest]; intended for kernels
+    void send(uint32_t stream, uint32_t dest, const char *data, uint32_t len) {
+        if (len == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto &strm = streams[streamIdx(stream, dest)];
+            strm.chunks.emplace_back(data, data + len);
+            strm.available += len;
+        }
+        cv.notify_all();
+    }
+
+    /// Registers the eventfd used to wake up the user interrupt thread of a Coyote thread
+    void registerEventfd(int32_t ctid, int32_t efd) {
+        std::lock_guard<std::mutex> lock(mtx);
+        irq_efd[ctid] = efd;
+    }
+
+    /// Raises a user interrupt (notification) for a Coyote thread; intended for kernels
+    void notify(int32_t ctid, uint32_t value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        n_notifications++;
+        irq_values[ctid].push_back(value);
+        if (irq_efd[ctid] != -1) {
+            eventfd_write(irq_efd[ctid], 1);
+        }
+    }
+
+    /// Pops the oldest pending notification value for a Coyote thread; returns false if there is none
+    bool getNotification(int32_t ctid, uint32_t &value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (irq_values[ctid].empty()) {
+            return false;
+        }
+        value = irq_values[ctid].front();
+        irq_values[ctid].pop_front();
+        return true;
+    }
+
+    /// Tracks a buffer mapped by a Coyote thread; accesses to untracked memory are counted as page faults
+    void userMap(void *vaddr, uint32_t len) {
+        std::lock_guard<std::mutex> lock(mtx);
+        tlb[reinterpret_cast<uint64_t>(vaddr)] = len;
+    }
+
+    /// Removes a buffer from the tracked mappings; returns false if it was not mapped
+    bool userUnmap(void *vaddr) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return tlb.erase(reinterpret_cast<uint64_t>(vaddr)) > 0;
+    }
+
+    /// Getter: number of read commands received
+    uint64_t getReadCmds() const { return n_rd_cmds; }
+
+    /// Getter: number of write commands received
+    uint64_t getWriteCmds() const { return n_wr_cmds; }
+
+    /// Getter: number of commands which touched memory that was not mapped with userMap
+    uint64_t getPageFaults() const { return n_pfaults; }
+
+    /// Getter: number of notifications raised by the kernel
+    uint64_t getNotifications() const { return n_notifications; }
+
+private:
+    /// One half (read or write) of a command
+    struct SoftCmd {
+        uint64_t addr;
+        uint64_t ctrl;
+    };
+
+    /// Data produced by the kernel, waiting to be consumed by a LOCAL_WRITE
+    struct SoftStream {
+        std::deque<std::vector<char>> chunks;
+        size_t offset = { 0 };
+        size_t available = { 0 };
+    };
+
+    static constexpr uint32_t N_STRM_DESTS = CTRL_DEST_MASK + 1;
+
+    static std::string key(uint32_t device, int32_t vfid) { return std::to_string(device) + "-" + std::to_string(vfid); }
+
+    static std::mutex& registryLock() { static std::mutex lock; return lock; }
+
+    static std::map<std::string, std::weak_ptr<SoftVfpga>>& instances() { static std::map<std::string, std::weak_ptr<SoftVfpga>> m; return m; }
+
+    static std::map<std::string, SoftKernel>& kernelRegistry() { static std::map<std::string, SoftKernel> m; return m; }
+
+    static std::map<std::string, SoftVfpgaCnfg>& cnfgRegistry() { static std::map<std::string, SoftVfpgaCnfg> m; return m; }
+
+    static int32_t cmdCtid(uint64_t ctrl) { return (ctrl >> CTRL_PID_OFFS) & CTRL_PID_MASK; }
+
+    static uint32_t streamIdx(uint32_t stream, uint32_t dest) { return (stream & CTRL_STRM_MASK) * N_STRM_DESTS + (dest & CTRL_DEST_MASK); }
+
+    /// Checks whether [addr, addr + len) is covered by a single mapping; must be called with mtx held
+    bool isMapped(uint64_t addr, uint64_t len) const {
+        auto it = tlb.upper_bound(addr);
+        if (it == tlb.begin()) {
+            return false;
+        }
+        it--;
+        return addr + len <= it->first + it->second;
+    }
+
+    /// Delays the calling engine to match the configured bandwidth and latency
+    void throttle(std::chrono::steady_clock::time_point start, uint32_t len) const {
+        long delay = cnfg.cmd_latency;
+        if (cnfg.bandwidth > 0) {
+            delay += static_cast<long>(len / cnfg.bandwidth);
+        }
+        if (delay > 0) {
+            auto until = start + std::chrono::nanoseconds(delay);
+            while (std::chrono::steady_clock::now() < until) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /// Copies len bytes from a stream to dst; must be called with mtx held and enough data available
+    void popStream(SoftStream &strm, char *dst, size_t len) {
+        strm.available -= len;
+        while (len > 0) {
+            auto &chunk = strm.chunks.front();
+            size_t n = std::min(len, chunk.size() - strm.offset);
+            memcpy(dst, chunk.data() + strm.offset, n);
+            dst += n;
+            len -= n;
+            strm.offset += n;
+            if (strm.offset == chunk.size()) {
+                strm.chunks.pop_front();
+                strm.offset = 0;
+            }
+        }
+    }
+
+    /// Main loop of the read (rd = true) and write (rd = false) engines
+    void runEngine(bool rd) {
+        auto &queue = rd ? rd_queue : wr_queue;
+        auto &active = rd ? rd_active : wr_active;
+
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            cv.wait(lock, [&] { return !running || !queue.empty(); });
+            if (!running) {
+                return;
+            }
+
+            SoftCmd cmd = queue.front();
+            queue.pop_front();
+
+            int32_t ctid = cmdCtid(cmd.ctrl);
+            uint32_t len = (cmd.ctrl >> CTRL_LEN_OFFS) & CTRL_LEN_MASK;
+            uint32_t stream = (cmd.ctrl >> CTRL_STRM_OFFS) & CTRL_STRM_MASK;
+            uint32_t dest = (cmd.ctrl >> CTRL_DEST_OFFS) & CTRL_DEST_MASK;
+            bool last = cmd.ctrl & CTRL_LAST;
+            active = ctid;
+
+            if (!isMapped(cmd.addr, len)) {
+                n_pfaults++;
+            }
+            auto start = std::chrono::steady_clock::now();
+
+            if (rd) {
+                lock.unlock();
+                {
+                    std::lock_guard<std::mutex> guard(kernel_mtx);
+                    kernel({ctid, stream, dest, last, reinterpret_cast<const char*>(cmd.addr), len}, *this);
+                }
+                throttle(start, len);
+                lock.lock();
+            } else {
+                auto &strm = streams[streamIdx(stream, dest)];
+                cv.wait(lock, [&] { return !running || abort_ctid == ctid || strm.available >= len; });
+                if (!running) {
+                    return;
+                }
+                if (abort_ctid == ctid) {
+                    active = -1;
+                    cv.notify_all();
+                    continue;
+                }
+                popStream(strm, reinterpret_cast<char*>(cmd.addr), len);
+                lock.unlock();
+                throttle(start, len);
+                lock.lock();
+            }
+
+            if (last) {
+                wback[ctid + (rd ? RD_WBACK : WR_WBACK) * N_CTID_MAX].fetch_add(1, std::memory_order_release);
+            }
+            active = -1;
+            cv.notify_all();
+        }
+    }
+
+    /// Shell configuration
+    SoftVfpgaCnfg cnfg;
+
+    /// User logic; protected by its own lock so it can be swapped while the engines are running
+    SoftKernel kernel;
+    std::mutex kernel_mtx;
+
+    /// User CSR space
+    std::vector<uint64_t> csr;
+
+    /// Writeback region; same layout as the hardware one
+    std::atomic<uint32_t> wback[N_WBACKS * N_CTID_MAX];
+
+    /// Protects all of the state below
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool running = { true };
+
+    /// Read and write halves of the command FIFO, and the ctid of the command each engine is processing (-1 if idle)
+    std::deque<SoftCmd> rd_queue, wr_queue;
+    int32_t rd_active = { -1 }, wr_active = { -1 };
+
+    /// Set while a Coyote thread is being unregistered, so that its blocked writes are dropped
+    int32_t abort_ctid = { -1 };
+
+    /// Kernel output, indexed by (stream, dest)
+    SoftStream streams[(CTRL_STRM_MASK + 1) * N_STRM_DESTS];
+
+    /// Registered Coyote threads
+    std::bitset<N_CTID_MAX> ctids;
+
+    /// Mapped buffers (vaddr -> len)
+    std::map<uint64_t, uint64_t> tlb;
+
+    /// Pending user interrupts and the eventfd of each Coyote thread
+    std::deque<uint32_t> irq_values[N_CTID_MAX];
+    int32_t irq_efd[N_CTID_MAX];
+
+    /// Statistics, as reported by cThread::printDebug()
+    std::atomic<uint64_t> n_rd_cmds = { 0 }, n_wr_cmds = { 0 }, n_pfaults = { 0 }, n_notifications = { 0 };
+
+    std::thread rd_engine, wr_engine;
+};
+
+}
+
+#endif // _COYOTE_SOFT_VFPGA_HPP_
@@ -0,0 +1,833 @@
+/**
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cThread.hpp>
+#include <coyote/SoftVfpga.hpp>
+
+namespace coyote {
+
+class cThread::AdditionalState {
+public:
+    std::shared_ptr<SoftVfpga> vfpga;
+    uint32_t device;
+
+    AdditionalState(int32_t vfid, uint32_t device) : vfpga(SoftVfpga::attach(vfid, device)), device(device) {}
+};
+
+/// Event handler function which processes user interrupts raised by the software kernel in a dedicated thread
+static int softEventHandler(SoftVfpga *vfpga, int efd, int terminate_efd, std::function<void(int)> uisr, int32_t ctid) {
+    DBG1("cThread: Called softEventHandler");
+
+    struct epoll_event event, events[MAX_EVENTS];
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd == -1) {
+        throw std::runtime_error("ERROR: Failed to create epoll file\n");
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = efd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, efd, &event)) {
+        throw std::runtime_error("ERROR: Failed to add efd event to epoll");
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = terminate_efd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, terminate_efd, &event)) {
+        throw std::runtime_error("ERROR: Failed to add terminate_efd event to epoll");
+    }
+
+    bool running = true;
+    while (running) {
+        int event_count = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+
+        for (int i = 0; i < event_count; i++) {
+            if (events[i].data.fd == efd) {
+                eventfd_t val;
+                if (eventfd_read(efd, &val) != 0) {
+                    throw std::runtime_error("ERROR: Failed to read interrupt");
+                }
+
+                // The eventfd is a counter, so a single wake-up may cover several notifications
+                uint32_t isr_val;
+                while (vfpga->getNotification(ctid, isr_val)) {
+                    DBG1("cThread: Caught an event which is " << isr_val);
+                    uisr(isr_val);
+                }
+            } else if (events[i].data.fd == terminate_efd) {
+                DBG1("cThread: softEventHandler caught a termination event");
+                running = false;
+            }
+        }
+    }
+
+    close(epoll_fd);
+    return 0;
+}
+
+/// Control word of a local (host/card stream) command, as parsed by the vFPGA command FIFO
+static inline uint64_t localCtrlCmd(int32_t ctid, const localSg &sg, bool last) {
+    return
+        ((ctid & CTRL_PID_MASK) << CTRL_PID_OFFS) |
+        ((sg.dest & CTRL_DEST_MASK) << CTRL_DEST_OFFS) |
+        (last ? CTRL_LAST : 0x0) |
+        ((sg.stream & CTRL_STRM_MASK) << CTRL_STRM_OFFS) |
+        (CTRL_START) |
+        (static_cast<uint64_t>(sg.len) << CTRL_LEN_OFFS);
+}
+
+cThread::cThread(int32_t vfid, pid_t hpid, uint32_t device, std::function<void(int)> uisr):
+  hpid(hpid), vfid(vfid),
+  vlock(boost::interprocess::open_or_create, ("mutex_soft_dev_" + std::to_string(device) + "_vfpga_" + std::to_string(vfid) + "_" + std::to_string(getpid())).c_str()),
+  additional_state(std::make_unique<AdditionalState>(vfid, device)) {
+    DBG1("cThread: attaching to software vFPGA " << vfid << ", hpid " << hpid);
+
+    SoftVfpga *vfpga = additional_state->vfpga.get();
+    this->ctid = vfpga->registerCtid();
+    if (ctid == -1) {
+        throw std::runtime_error("ERROR: cThread instance could not be obtained, all ctids taken, vfid: " + std::to_string(vfid));
+    }
+    DBG1("cThread: registered ctid " << ctid);
+
+    // The software vFPGA exposes host streams and writeback; card memory and networking are not modelled
+    fcnfg.en_wb = vfpga->getCnfg().en_wb;
+    fcnfg.en_strm = vfpga->getCnfg().en_strm;
+    fcnfg.n_fpga_reg = 1;
+    fcnfg.ctrl_reg.pg_s_bits = PAGE_SHIFT;
+    fcnfg.ctrl_reg.pg_l_bits = HUGE_PAGE_SHIFT;
+
+    if (uisr) {
+        startEventThread(uisr);
+    }
+
+    qpair = std::make_unique<ibvQp>();
+
+    mmapFpga();
+
+    clearCompleted();
+
+    DBG1("cThread: constructor finished");
+}
+
+cThread::~cThread() {
+    DBG1("cThread: destructor, ctid: " << ctid << ", vfid: " << vfid << ", hpid: " << hpid);
+
+    if (lock_acquired) {
+        vlock.unlock();
+        lock_acquired = false;
+    }
+
+    // Drop outstanding commands first, so that the engines don't touch memory released below
+    additional_state->vfpga->unregisterCtid(ctid);
+
+    while (!mapped_pages.empty()) {
+        freeMem(mapped_pages.begin()->start);
+    }
+    for (uint64_t removed : reg_cache.clear()) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+    munmapFpga();
+
+    if (efd != -1) {
+        eventfd_write(terminate_efd, 1);
+        if (event_thread.joinable()) {
+            event_thread.join();
+        }
+
+        close(efd);
+        close(terminate_efd);
+    }
+
+    if (wait_efd != -1) {
+        close(wait_efd);
+    }
+
+    boost::interprocess::named_mutex::remove(
+        ("mutex_soft_dev_" + std::to_string(additional_state->device) + "_vfpga_" + std::to_string(vfid) + "_" + std::to_string(getpid())).c_str()
+    );
+}
+
+void cThread::startEventThread(std::function<void(int)> uisr) {
+    efd = eventfd(0, 0);
+    if (efd == -1) {
+        throw std::runtime_error("ERROR: cThread could not create eventfd");
+    }
+
+    terminate_efd = eventfd(0, 0);
+    if (terminate_efd == -1) {
+        throw std::runtime_error("ERROR: cThread could not create eventfd");
+    }
+
+    // Same as in hardware: interrupts also wake up blocked waiters, if enabled
+    auto handler = [this, uisr](int isr_val) {
+        if (uisr) {
+            uisr(isr_val);
+        }
+        if (irq_wakeup.load(std::memory_order_acquire)) {
+            eventfd_write(wait_efd, 1);
+        }
+    };
+    event_thread = std::thread(softEventHandler, additional_state->vfpga.get(), efd, terminate_efd, handler, ctid);
+    additional_state->vfpga->registerEventfd(ctid, efd);
+}
+
+uint32_t cThread::getCmdCredits() {
+    // Same credit scheme as in hardware; the FIFO level is read from the model instead of CTRL_REG
+    waitFor([this]() {
+        if (cmd_cnt > (CMD_FIFO_DEPTH - CMD_FIFO_THR)) {
+            cmd_cnt = additional_state->vfpga->fifoLevel();
+        }
+        return cmd_cnt <= (CMD_FIFO_DEPTH - CMD_FIFO_THR);
+    }, wait_policy, wait_stats, wait_efd);
+
+    return (CMD_FIFO_DEPTH - CMD_FIFO_THR) - cmd_cnt + 1;
+}
+
+void cThread::writeCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
+    additional_state->vfpga->post(offs_3, offs_2, offs_1, offs_0);
+}
+
+void cThread::postCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
+    DBG1(
+        "cThread: Called postCmd with offsets: " <<
+        std::hex << offs_3 << ", " << offs_2 << ", " << offs_1 << ", " << offs_0 << std::dec
+    );
+
+    getCmdCredits();
+    writeCmd(offs_3, offs_2, offs_1, offs_0);
+    cmd_cnt++;
+}
+
+void cThread::mmapFpga() {
+    DBG1("cThread: Called mmapFpga");
+
+    // Only the user CSRs are exposed directly; config registers and writeback are accessed through the model
+    ctrl_reg = additional_state->vfpga->getCsrBase();
+}
+
+void cThread::munmapFpga() {
+    DBG1("cThread: Called munmapFpga");
+
+    ctrl_reg = 0;
+}
+
+void cThread::mapBuffer(void *vaddr, uint32_t len) {
+    additional_state->vfpga->userMap(vaddr, len);
+}
+
+void cThread::unmapBuffer(void *vaddr) {
+    if (!additional_state->vfpga->userUnmap(vaddr)) {
+        throw std::runtime_error("ERROR: userUnmap called for a buffer that is not mapped");
+    }
+}
+
+void cThread::userMap(void *vaddr, uint32_t len) {
+    DBG1("cThread: Called userMap to map user buffer, vaddr " << vaddr << ", length " << len << " and ctid " << ctid);
+
+    if (!reg_cache.isEnabled()) {
+        mapBuffer(vaddr, len);
+        return;
+    }
+
+    // Registered ranges become a lookup; otherwise, map and cache the new registration, replacing 
+    // an unused shorter one at the same address, since the driver would not extend it
+    if (!reg_cache.acquire(reinterpret_cast<uint64_t>(vaddr), len)) {
+        if (reg_cache.remove(reinterpret_cast<uint64_t>(vaddr))) {
+            unmapBuffer(vaddr);
+        }
+        mapBuffer(vaddr, len);
+        reg_cache.insert(reinterpret_cast<uint64_t>(vaddr), len);
+        for (uint64_t evicted : reg_cache.evict()) {
+            unmapBuffer(reinterpret_cast<void*>(evicted));
+        }
+    }
+}
+
+void cThread::userUnmap(void *vaddr) {
+    DBG1("cThread: Called userUnmap to unmap user buffers");
+
+    // Cached registrations are only released, and unmapped lazily; a disabled cache may still hold registrations in use
+    if (reg_cache.release(reinterpret_cast<uint64_t>(vaddr))) {
+        for (uint64_t evicted : reg_cache.evict()) {
+            unmapBuffer(reinterpret_cast<void*>(evicted));
+        }
+    } else {
+        unmapBuffer(vaddr);
+    }
+}
+
+void cThread::setRegCacheBudget(uint64_t bytes) {
+    reg_cache.setBudget(bytes);
+    for (uint64_t evicted : reg_cache.evict()) {
+        unmapBuffer(reinterpret_cast<void*>(evicted));
+    }
+}
+
+void cThread::invalidateRegCache(void *vaddr, uint64_t len) {
+    for (uint64_t removed : reg_cache.invalidate(reinterpret_cast<uint64_t>(vaddr), len)) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+}
+
+void cThread::flushRegCache() {
+    for (uint64_t removed : reg_cache.flush()) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+}
+
+regCacheStats cThread::getRegCacheStats() const { return reg_cache.getStats(); }
+
+void cThread::setNumaPlacement(bool mem_bind, bool thread_affinity) {
+    // Only recorded; the software vFPGA is not attached to a NUMA node, so numa_node stays -1
+    numa_mem = mem_bind;
+    numa_affinity = thread_affinity;
+}
+
+int32_t cThread::getNumaNode() const { return numa_node; }
+
+std::vector<operStats> cThread::getOperStats() const {
+    #ifdef EN_OPER_STATS
+    return oper_stats.snapshot();
+    #else
+    return {};
+    #endif
+}
+
+void cThread::resetOperStats() {
+    #ifdef EN_OPER_STATS
+    oper_stats.reset();
+    #endif
+}
+
+void* cThread::getMem(CoyoteAlloc&& alloc) {
+    DBG1("cThread: Called getMem to obtain memory with size " << alloc.size);
+
+    // CoyoteAlloc::populate is ignored: the software vFPGA accesses buffers directly and never page faults
+    void *mem = nullptr;
+
+    if (alloc.size > 0) {
+        switch (alloc.alloc) {
+            case CoyoteAllocType::REG : {
+                mem = mmap(NULL, alloc.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (mem == MAP_FAILED) {
+                    throw std::runtime_error("ERROR: cThread::getMem() - Failed to allocate regular pages");
+                }
+                userMap(mem, alloc.size);
+                break;
+            }
+
+            case CoyoteAllocType::THP : {
+                if (posix_memalign(&mem, HUGE_PAGE_SIZE, alloc.size) != 0) {
+                    std::cerr << "ERROR: cThread::getMem() - Failed to allocate transparent hugepages!" << std::endl;
+                    return nullptr;
+                }
+                userMap(mem, alloc.size);
+                break;
+            }
+
+            // CI machines often have no hugepages reserved; fall back to THP so that the same code runs everywhere
+            case CoyoteAllocType::HPF : {
+                mem = mmap(NULL, alloc.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (mem == MAP_FAILED) {
+                    DBG1("cThread: Hugepage allocation failed, falling back to transparent huge pages");
+                    if (posix_memalign(&mem, HUGE_PAGE_SIZE, alloc.size) != 0) {
+                        throw std::runtime_error("Hugepage allocation failed");
+                    }
+                    alloc.alloc = CoyoteAllocType::THP;
+                }
+                userMap(mem, alloc.size);
+                break;
+            }
+
+            default:
+                throw std::runtime_error("ERROR: cThread::getMem() - allocation type not supported by the software vFPGA");
+        }
+
+        if (!alloc.mem) {
+            alloc.mem = mem;
+        }
+        // An allocation that cannot be recorded (e.g., overlapping a stale entry) could never be freed, so it's released right away
+        if (!mapped_pages.insert(mem, alloc.size, alloc)) {
+            releaseMem(mem, alloc);
+            throw std::runtime_error("ERROR: cThread::getMem() - allocation overlaps an existing one, at vaddr " + std::to_string(reinterpret_cast<uint64_t>(mem)));
+        }
+        DBG1("Mapped mem at: " << std::hex << reinterpret_cast<uint64_t>(mem) << std::dec);
+
+        if (alloc.remote) {
+            qpair->local.vaddr = mem;
+            qpair->local.size = alloc.size;
+        }
+    }
+
+    return mem;
+}
+
+void cThread::releaseMem(void *vaddr, const CoyoteAlloc &alloc) {
+    switch (alloc.alloc) {
+        case CoyoteAllocType::REG : case CoyoteAllocType::HPF : {
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            munmap(vaddr, alloc.size);
+            break;
+        }
+        case CoyoteAllocType::THP : {
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            free(vaddr);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void cThread::freeMem(void* vaddr) {
+    DBG1("cThread: Releasing memory at vaddr " << vaddr);
+
+    if (mapped_pages.find(vaddr)) {
+        auto mapped = *mapped_pages.find(vaddr);
+
+        releaseMem(vaddr, mapped);
+
+        if (mapped.remote) {
+            qpair->local.vaddr = 0;
+            qpair->local.size = 0;
+        }
+
+        mapped_pages.erase(vaddr);
+    }
+}
+
+const CoyoteAlloc* cThread::findAlloc(const void *addr, uint64_t len) const {
+    auto entry = mapped_pages.findContaining(addr, len);
+    return entry ? &entry->value : nullptr;
+}
+
+bool cThread::isMapped(const void *addr, uint64_t len) const {
+    return mapped_pages.findContaining(addr, len) != nullptr;
+}
+
+void cThread::setCSR(uint64_t val, uint32_t offs) {
+    ctrl_reg[offs] = val;
+}
+
+uint64_t cThread::getCSR(uint32_t offs) const {
+    return ctrl_reg[offs];
+}
+
+void cThread::invoke(CoyoteOper, syncSg) {
+    throw std::runtime_error("ERROR: cThread::invoke() called for a sync/offload operation, but the software vFPGA does not model card memory, exiting...");
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
+    DBG1("cThread: Call invoke for a one-side local operation with address " << sg.addr << ", length " << sg.len);
+
+    if (!isLocalRead(oper) && !isLocalWrite(oper)) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with localSg flags, but the operation is not a LOCAL_READ or LOCAL_WRITE; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invoke() called for a local operation, but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    if (sg.len > MAX_TRANSFER_SIZE) {
+        throw std::runtime_error("ERROR: cThread::invoke() - transfers over 128MB are currently not supported in Coyote, exiting...");
+    }
+
+    uint64_t ctrl_cmd = localCtrlCmd(ctid, sg, last);
+    uint64_t addr_cmd = reinterpret_cast<uint64_t>(sg.addr);
+
+    if (oper == CoyoteOper::LOCAL_READ) {
+        postCmd(0, 0, addr_cmd, ctrl_cmd);
+    } else {
+        postCmd(addr_cmd, ctrl_cmd, 0, 0);
+    }
+
+    return nextCmplSeq(oper, last, sg.len);
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last) {
+    DBG1(
+        "cThread: Call invoke for a two-sided local operation with source address "
+        << src_sg.addr << ", source length " << src_sg.len << "destination address "
+        << dst_sg.addr << ", destination length " << dst_sg.len
+    );
+
+    if (!(isLocalRead(oper) && isLocalWrite(oper))) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with two localSg flags, but the operation is not a LOCAL_TRANSFER; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invoke() called for a local operation but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    if (src_sg.len > MAX_TRANSFER_SIZE || dst_sg.len > MAX_TRANSFER_SIZE) {
+        throw std::runtime_error("ERROR: cThread::invoke() - transfers over 128MB are currently not supported in Coyote, exiting...");
+    }
+
+    postCmd(
+        reinterpret_cast<uint64_t>(dst_sg.addr), localCtrlCmd(ctid, dst_sg, last),
+        reinterpret_cast<uint64_t>(src_sg.addr), localCtrlCmd(ctid, src_sg, last)
+    );
+
+    return nextCmplSeq(oper, last, src_sg.len);
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, const localSgList &sgl) {
+    // Argument checks
+    DBG1("cThread: Call invoke for a one-sided local operation on a list of " << sgl.segs.size() << " segments, total length " << sgl.totalLen());
+
+    if (oper != CoyoteOper::LOCAL_READ && oper != CoyoteOper::LOCAL_WRITE) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with a localSgList, but the operation is not a LOCAL_READ or LOCAL_WRITE; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invoke() called for a local operation, but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    std::vector<localSg> chunks = sgl.chunks();
+    if (chunks.empty()) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with an empty localSgList, exiting...");
+    }
+
+    // Trigger the operation; descriptors are written as long as there are FIFO credits, only the final one is marked last
+    size_t i = 0;
+    while (i < chunks.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < chunks.size(); credits--, i++) {
+            uint64_t ctrl_cmd = localCtrlCmd(ctid, chunks[i], i == chunks.size() - 1);
+            uint64_t addr_cmd = reinterpret_cast<uint64_t>(chunks[i].addr);
+
+            if (oper == CoyoteOper::LOCAL_READ) {
+                writeCmd(0, 0, addr_cmd, ctrl_cmd);
+            } else {
+                writeCmd(addr_cmd, ctrl_cmd, 0, 0);
+            }
+            cmd_cnt++;
+        }
+    }
+
+    return nextCmplSeq(oper, true, sgl.totalLen());
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, const localSgList &src_sgl, const localSgList &dst_sgl) {
+    // Argument checks
+    DBG1(
+        "cThread: Call invoke for a two-sided local operation on lists with source length " 
+        << src_sgl.totalLen() << " and destination length " << dst_sgl.totalLen()
+    );
+
+    if (oper != CoyoteOper::LOCAL_TRANSFER) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with two localSgLists, but the operation is not a LOCAL_TRANSFER; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invoke() called for a local operation but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    std::vector<localSg> src_chunks = src_sgl.chunks();
+    std::vector<localSg> dst_chunks = dst_sgl.chunks();
+    if (src_chunks.empty() || dst_chunks.empty()) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with an empty localSgList, exiting...");
+    }
+
+    // Trigger the operation; the read and write halves of a command are independent, so a half is left empty once its list is exhausted
+    size_t n = std::max(src_chunks.size(), dst_chunks.size());
+    size_t i = 0;
+    while (i < n) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < n; credits--, i++) {
+            uint64_t addr_cmd_src = 0, ctrl_cmd_src = 0, addr_cmd_dst = 0, ctrl_cmd_dst = 0;
+            if (i < src_chunks.size()) {
+                addr_cmd_src = reinterpret_cast<uint64_t>(src_chunks[i].addr);
+                ctrl_cmd_src = localCtrlCmd(ctid, src_chunks[i], i == src_chunks.size() - 1);
+            }
+            if (i < dst_chunks.size()) {
+                addr_cmd_dst = reinterpret_cast<uint64_t>(dst_chunks[i].addr);
+                ctrl_cmd_dst = localCtrlCmd(ctid, dst_chunks[i], i == dst_chunks.size() - 1);
+            }
+
+            writeCmd(addr_cmd_dst, ctrl_cmd_dst, addr_cmd_src, ctrl_cmd_src);
+            cmd_cnt++;
+        }
+    }
+
+    return nextCmplSeq(oper, true, src_sgl.totalLen());
+}
+
+uint32_t cThread::invoke(CoyoteOper, rdmaSg, bool) {
+    throw std::runtime_error("ERROR: cThread::invoke() called for an RDMA operation, but networking is not modelled by the software vFPGA, exiting...");
+}
+
+uint32_t cThread::invoke(CoyoteOper, tcpSg, bool) {
+    throw std::runtime_error("ERROR: cThread::invoke() called for a TCP operation, but networking is not modelled by the software vFPGA, exiting...");
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<localSg> &sgs, bool last) {
+    DBG1("cThread: Call invokeBatch for " << sgs.size() << " one-sided local operations");
+
+    if (oper != CoyoteOper::LOCAL_READ && oper != CoyoteOper::LOCAL_WRITE) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called with localSg flags, but the operation is not a LOCAL_READ or LOCAL_WRITE; exiting...");
+    }
+
+    for (const localSg &sg : sgs) {
+        if (sg.len > MAX_TRANSFER_SIZE) {
+            throw std::runtime_error("ERROR: cThread::invokeBatch() - transfers over 128MB are currently not supported in Coyote, exiting...");
+        }
+    }
+
+    size_t i = 0;
+    while (i < sgs.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < sgs.size(); credits--, i++) {
+            uint64_t ctrl_cmd = localCtrlCmd(ctid, sgs[i], last);
+            uint64_t addr_cmd = reinterpret_cast<uint64_t>(sgs[i].addr);
+
+            if (oper == CoyoteOper::LOCAL_READ) {
+                writeCmd(0, 0, addr_cmd, ctrl_cmd);
+            } else {
+                writeCmd(addr_cmd, ctrl_cmd, 0, 0);
+            }
+            cmd_cnt++;
+            nextCmplSeq(oper, last, sgs[i].len);
+        }
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<localSg> &src_sgs, const std::vector<localSg> &dst_sgs, bool last) {
+    DBG1("cThread: Call invokeBatch for " << src_sgs.size() << " two-sided local operations");
+
+    if (oper != CoyoteOper::LOCAL_TRANSFER) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called with two localSg lists, but the operation is not a LOCAL_TRANSFER; exiting...");
+    }
+
+    if (src_sgs.size() != dst_sgs.size()) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() - source and destination lists must have the same number of entries, exiting...");
+    }
+
+    for (size_t i = 0; i < src_sgs.size(); i++) {
+        if (src_sgs[i].len > MAX_TRANSFER_SIZE || dst_sgs[i].len > MAX_TRANSFER_SIZE) {
+            throw std::runtime_error("ERROR: cThread::invokeBatch() - transfers over 128MB are currently not supported in Coyote, exiting...");
+        }
+    }
+
+    size_t i = 0;
+    while (i < src_sgs.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < src_sgs.size(); credits--, i++) {
+            writeCmd(
+                reinterpret_cast<uint64_t>(dst_sgs[i].addr), localCtrlCmd(ctid, dst_sgs[i], last),
+                reinterpret_cast<uint64_t>(src_sgs[i].addr), localCtrlCmd(ctid, src_sgs[i], last)
+            );
+            cmd_cnt++;
+            nextCmplSeq(oper, last, src_sgs[i].len);
+        }
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper, const std::vector<rdmaSg> &, bool) {
+    throw std::runtime_error("ERROR: cThread::invokeBatch() called for an RDMA operation, but networking is not modelled by the software vFPGA, exiting...");
+}
+
+uint32_t cThread::nextCmplSeq(CoyoteOper oper, bool last, [[maybe_unused]] uint64_t bytes) {
+    int32_t idx = getWbackIndex(oper);
+    if (idx == -1) {
+        return 0;
+    }
+
+    // LOCAL_TRANSFERs increment both the read and the write counter
+    if (last) {
+        if (isLocalRead(oper) && isLocalWrite(oper)) {
+            cmpl_seq[RD_WBACK]++;
+        }
+        cmpl_seq[idx]++;
+    }
+
+    #ifdef EN_OPER_STATS
+    oper_stats.submit(oper, cmpl_seq[idx], last, bytes);
+    #endif
+
+    return cmpl_seq[idx];
+}
+
+uint32_t cThread::checkCompleted(CoyoteOper coper) const {
+    uint32_t completed = readCompleted(coper);
+
+    #ifdef EN_OPER_STATS
+    oper_stats.observe(getWbackIndex(coper), completed);
+    #endif
+
+    return completed;
+}
+
+uint32_t cThread::readCompleted(CoyoteOper coper) const {
+    // Same order as in hardware: writes before reads, since LOCAL_TRANSFER is both
+    if (isLocalWrite(coper)) {
+        return additional_state->vfpga->getCompleted(ctid, WR_WBACK);
+    } else if (isLocalRead(coper)) {
+        return additional_state->vfpga->getCompleted(ctid, RD_WBACK);
+    } else if (isRemoteRead(coper)) {
+        return additional_state->vfpga->getCompleted(ctid, RD_RDMA_WBACK);
+    } else if (isRemoteWriteOrSend(coper)) {
+        return additional_state->vfpga->getCompleted(ctid, WR_RDMA_WBACK);
+    } else {
+        return 0;
+    }
+}
+
+bool cThread::isCompleted(CoyoteOper oper, uint32_t seq) const {
+    return static_cast<int32_t>(checkCompleted(oper) - seq) >= 0;
+}
+
+void cThread::waitCompleted(CoyoteOper oper, uint32_t seq) {
+    waitFor([&]() { return isCompleted(oper, seq); }, wait_policy, wait_stats, wait_efd);
+}
+
+void cThread::setWaitPolicy(waitPolicy policy) {
+    if (policy.irq_wakeup && policy.mode != CoyoteWait::SPIN_BLOCK) {
+        throw std::runtime_error("ERROR: cThread::setWaitPolicy() - irq_wakeup requires the CoyoteWait::SPIN_BLOCK mode");
+    }
+
+    if (policy.mode == CoyoteWait::SPIN_BLOCK && wait_efd == -1) {
+        wait_efd = eventfd(0, EFD_NONBLOCK);
+        if (wait_efd == -1) {
+            throw std::runtime_error("ERROR: cThread could not create eventfd");
+        }
+    }
+
+    if (policy.irq_wakeup && efd == -1) {
+        startEventThread(nullptr);
+    }
+
+    wait_policy = policy;
+    irq_wakeup.store(policy.irq_wakeup, std::memory_order_release);
+}
+
+waitPolicy cThread::getWaitPolicy() const { return wait_policy; }
+
+waitStats cThread::getWaitStats() const { return wait_stats; }
+
+void cThread::wakeWaiters() {
+    if (wait_efd != -1) {
+        eventfd_write(wait_efd, 1);
+    }
+}
+
+void cThread::clearCompleted() {
+    DBG1("cThread: Called clearCompleted");
+
+    for (uint32_t i = 0; i < N_WBACKS; i++) {
+        cmpl_seq[i] = 0;
+    }
+
+    #ifdef EN_OPER_STATS
+    oper_stats.discardInFlight();
+    #endif
+
+    additional_state->vfpga->clearCompleted(ctid);
+}
+
+void cThread::doArpLookup(uint32_t, bool) {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+void cThread::writeQpContext(uint32_t) {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+uint32_t cThread::readAck() {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+void cThread::sendAck(uint32_t) {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+void cThread::connSync(bool) {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+void* cThread::initRDMA(uint32_t, uint16_t, const char*) {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+void cThread::closeConn() {
+    throw std::runtime_error("ERROR: Networking is not modelled by the software vFPGA");
+}
+
+void cThread::lock() {
+    DBG3("cThread: Called lock");
+    if (!lock_acquired) {
+        vlock.lock();
+        lock_acquired = true;
+    }
+}
+
+void cThread::unlock() {
+    DBG3("cThread: Called unlock");
+    if (lock_acquired) {
+        vlock.unlock();
+        lock_acquired = false;
+    }
+}
+
+int32_t cThread::getVfid() const { return vfid; };
+
+int32_t cThread::getCtid() const { return ctid; };
+
+pid_t cThread::getHpid() const { return hpid; };
+
+ibvQp* cThread::getQpair() const { return qpair.get(); }
+
+void cThread::printDebug() const {
+    SoftVfpga *vfpga = additional_state->vfpga.get();
+
+    std::cout << "-- STATISTICS - ID: cThread ID" << ctid << ", vFPGA ID" << vfid << " (software vFPGA)" << std::endl;
+    std::cout << "-----------------------------------------------" << std::endl;
+    std::cout << std::setw(35) << "Sent local reads: \t" << vfpga->getReadCmds() << std::endl;
+    std::cout << std::setw(35) << "Sent local writes: \t" << vfpga->getWriteCmds() << std::endl;
+    std::cout << std::setw(35) << "Sent remote reads: \t" << 0 << std::endl;
+    std::cout << std::setw(35) << "Sent remote writes: \t" << 0 << std::endl;
+
+    std::cout << std::setw(35) << "Invalidations received: \t" << 0 << std::endl;
+    std::cout << std::setw(35) << "Page faults received: \t" << vfpga->getPageFaults() << std::endl;
+    std::cout << std::setw(35) << "Notifications received: \t" << vfpga->getNotifications() << std::endl;
+
+    std::cout << std::setw(35) << "Waits (spin/yield/block): \t" << wait_stats.n_waits << " (" << wait_stats.spin_hits << "/" << wait_stats.yield_hits << "/" << wait_stats.block_hits << ")" << std::endl;
+
+    for (const operStats &stats : getOperStats()) {
+        std::cout << std::setw(35) << std::string(operName(stats.oper)) + " (p50/p99/p999 us): \t" 
+                  << stats.p50_us << "/" << stats.p99_us << "/" << stats.p999_us << ", " << stats.count << " ops, " 
+                  << stats.throughput_gbps << " GB/s" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+}
@@ -0,0 +1,214 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Smoke test of the software vFPGA backend; built and registered with CTest when EN_SOFT_VFPGA is set
+ *
+ * (1) cThread: a loopback transfer, completed through the writeback counters, and the CSR space
+ * (2) cService/cConn: a daemon with two functions of distinct bitstreams (so the scheduler reconfigures
+ *     between them), serving tasks over the socket and over the shared-memory queues; both for a single vFPGA
+ *     and for two vFPGAs of the device, where the device scheduler places the tasks; as well as a function
+ *     writing into a shared buffer (cBuffer) and returning a slice of it
+ */
+
+#include <string>
+#include <vector>
+#include <future>
+#include <fstream>
+#include <cstring>
+#include <iostream>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <coyote/cThread.hpp>
+#include <coyote/cService.hpp>
+#include <coyote/cConn.hpp>
+#include <coyote/cFunc.hpp>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { std::cerr << "FAILED: " #cond " (line " << __LINE__ << ")" << std::endl; return 1; } \
+} while (false)
+
+constexpr uint32_t TRANSFER_SIZE = 64 * 1024;
+constexpr int N_TASKS = 100;
+constexpr int SERVICE_TIMEOUT = 5000; // ms
+constexpr int BUFFER_LEN = 1024; // ints
+
+int testThread() {
+    coyote::cThread coyote_thread(0, getpid());
+
+    char *src = (char *) coyote_thread.getMem({coyote::CoyoteAllocType::REG, TRANSFER_SIZE});
+    char *dst = (char *) coyote_thread.getMem({coyote::CoyoteAllocType::REG, TRANSFER_SIZE});
+    CHECK(src != nullptr && dst != nullptr);
+    for (uint32_t i = 0; i < TRANSFER_SIZE; i++) {
+        src[i] = i * 13;
+        dst[i] = 0;
+    }
+
+    coyote::localSg src_sg = { .addr = src, .len = TRANSFER_SIZE };
+    coyote::localSg dst_sg = { .addr = dst, .len = TRANSFER_SIZE };
+    coyote_thread.invoke(coyote::CoyoteOper::LOCAL_TRANSFER, src_sg, dst_sg);
+    while (coyote_thread.checkCompleted(coyote::CoyoteOper::LOCAL_TRANSFER) != 1) {}
+    CHECK(memcmp(src, dst, TRANSFER_SIZE) == 0);
+
+    coyote_thread.setCSR(0xc0ffee, 3);
+    CHECK(coyote_thread.getCSR(3) == 0xc0ffee);
+
+    coyote_thread.freeMem(src);
+    coyote_thread.freeMem(dst);
+    std::cout << "cThread: OK" << std::endl;
+    return 0;
+}
+
+int testService(bool device_level) {
+    std::string name = "soft-smoke-" + std::to_string(getpid());
+    std::string sock_name = device_level ? "/tmp/coyote-daemon-dev-0-" + name : "/tmp/coyote-daemon-dev-0-vfid-0-" + name;
+    std::vector<int32_t> vfids = device_level ? std::vector<int32_t>{0, 1} : std::vector<int32_t>{0};
+
+    // One bitstream per (function, vFPGA)
+    auto bitstreamPath = [&](int32_t fid, int32_t vfid) {
+        return "/tmp/" + name + "-" + std::to_string(fid) + "-" + std::to_string(vfid) + ".bin";
+    };
+    for (int32_t fid = 1; fid <= 3; fid++) {
+        for (int32_t vfid : vfids) {
+            std::ofstream(bitstreamPath(fid, vfid), std::ios::binary) << bitstreamPath(fid, vfid);
+        }
+    }
+
+    // The service daemonizes; its (intermediate) parent exits once the daemon is forked
+    pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0) {
+        coyote::cService *service = device_level ? 
+            coyote::cService::getDeviceInstance(name, false, vfids, 0) : coyote::cService::getInstance(name, false, 0, 0);
+        service->addFunction([&](int32_t vfid) {
+            return std::unique_ptr<coyote::bFunc>(new coyote::cFunc<int, int, int>(
+                1, bitstreamPath(1, vfid), [](coyote::cThread *, int a, int b) -> int { return a + b; }
+            ));
+        });
+        service->addFunction([&](int32_t vfid) {
+            return std::unique_ptr<coyote::bFunc>(new coyote::cFunc<int, int, int>(
+                2, bitstreamPath(2, vfid), [](coyote::cThread *, int a, int b) -> int { return a * b; }
+            ));
+        });
+        // Fills a buffer with multiples of k and returns its second half
+        service->addFunction([&](int32_t vfid) {
+            return std::unique_ptr<coyote::bFunc>(new coyote::cFunc<coyote::cBuffer, coyote::cBuffer, int>(
+                3, bitstreamPath(3, vfid), [](coyote::cThread *, coyote::cBuffer buf, int k) -> coyote::cBuffer { 
+                    for (uint64_t i = 0; i < buf.size / sizeof(int); i++) {
+                        buf.as<int>()[i] = i * k;
+                    }
+                    return buf.slice(buf.size / 2, buf.size / 2);
+                }
+            ));
+        });
+        service->start();
+        _exit(EXIT_FAILURE);
+    }
+    waitpid(pid, nullptr, 0);
+
+    // Wait for the daemon to listen, and find its process ID, to stop it at the end
+    pid_t daemon_pid = -1;
+    for (int t = 0; t < SERVICE_TIMEOUT && daemon_pid == -1; t += 10) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, sock_name.c_str());
+        struct ucred cred;
+        socklen_t cred_len = sizeof(cred);
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0 && getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == 0) {
+            daemon_pid = cred.pid;
+        } else {
+            usleep(10000);
+        }
+        close(fd);
+    }
+    CHECK(daemon_pid != -1);
+
+    int ret = 0;
+    for (int shm_ring = 0; shm_ring < 2 && ret == 0; shm_ring++) {
+        ret = [&]() {
+            coyote::cConn conn(sock_name, shm_ring);
+            CHECK(conn.hasShmRing() == (bool) shm_ring);
+
+            // Alternating functions, so the scheduler keeps switching bitstreams
+            std::vector<std::future<int>> results;
+            for (int i = 0; i < N_TASKS; i++) {
+                results.push_back(conn.fTask<int>(1 + i % 2, i, 3));
+            }
+            for (int i = 0; i < N_TASKS; i++) {
+                CHECK(results[i].get() == (i % 2 ? i * 3 : i + 3));
+            }
+            CHECK(conn.task<int>(1, 40, 2) == 42);
+
+            // Shared buffer, written by the function; the returned slice points into the client's mapping
+            coyote::cBuffer buf = conn.allocBuffer(BUFFER_LEN * sizeof(int));
+            coyote::cBuffer half = conn.task<coyote::cBuffer>(3, buf, 7);
+            CHECK(half.region == buf.region && half.size == buf.size / 2);
+            CHECK(half.data == buf.as<char>() + buf.size / 2);
+            for (int i = 0; i < BUFFER_LEN; i++) {
+                CHECK(buf.as<int>()[i] == i * 7);
+            }
+            CHECK(half.as<int>()[0] == BUFFER_LEN / 2 * 7);
+
+            // Slices are passed by location; one exceeding the region is rejected by the service
+            CHECK(conn.task<coyote::cBuffer>(3, buf.slice(0, 2 * sizeof(int)), 1).size == sizeof(int));
+            CHECK(buf.as<int>()[1] == 1 && buf.as<int>()[2] == 14);
+            coyote::cBuffer out_of_bounds = buf.slice(buf.size / 2, buf.size / 2);
+            out_of_bounds.size = buf.size;
+            bool rejected = false;
+            try {
+                conn.task<coyote::cBuffer>(3, out_of_bounds, 1);
+            } catch (const std::exception &) {
+                rejected = true;
+            }
+            CHECK(rejected);
+            conn.freeBuffer(buf);
+            return 0;
+        }();
+        std::cout << (device_level ? "cService, device-level" : "cService") << " (" << (shm_ring ? "shared-memory queues" : "socket") << "): " 
+                  << (ret ? "FAILED" : "OK") << std::endl;
+    }
+
+    kill(daemon_pid, SIGTERM);
+    for (int32_t fid = 1; fid <= 3; fid++) {
+        for (int32_t vfid : vfids) {
+            unlink(bitstreamPath(fid, vfid).c_str());
+        }
+    }
+    return ret;
+}
+
+int main() {
+    if (testThread() || testService(false) || testService(true)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
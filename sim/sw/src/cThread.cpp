@@ -157,7 +157,7 @@ cThread::cThread(int32_t vfid, pid_t hpid, uint32_t device, std::function<void(i
 
     // Events - check if there's a pointer provided for user-defined interrupt service routine
     if (uisr) {
-        additional_state->irq_thread = std::thread([&output_reader, uisr] {
+        additional_state->irq_thread = std::thread([this, &output_reader, uisr] {
             bool status(true);
             uint32_t value;
             while (status) {
@@ -167,6 +167,9 @@ cThread::cThread(int32_t vfid, pid_t hpid, uint32_t device, std::function<void(i
                     return;
                 }
                 uisr(value);
+                if (irq_wakeup.load(std::memory_order_acquire)) {
+                    eventfd_write(wait_efd, 1);
+                }
             }
         });
     }
@@ -179,9 +182,12 @@ cThread::cThread(int32_t vfid, pid_t hpid, uint32_t device, std::function<void(i
 cThread::~cThread() {
     // Memory: Free the memory and clear the mapped pages 
 	while (!mapped_pages.empty()) {
-		freeMem((*mapped_pages.begin()).first);
+		freeMem(mapped_pages.begin()->start);
 	}
 	mapped_pages.clear();
+    for (uint64_t removed : reg_cache.clear()) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
 
     additional_state->input_writer.close();
 
@@ -190,12 +196,25 @@ cThread::~cThread() {
 
     if (additional_state->irq_thread.joinable())
         additional_state->irq_thread.join();
+
+    if (wait_efd != -1) {
+        close(wait_efd);
+    }
 }
 
 void cThread::postCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
     // Do nothing because protected function
 }
 
+uint32_t cThread::getCmdCredits() {
+    // Do nothing because protected function
+    return CMD_FIFO_DEPTH;
+}
+
+void cThread::writeCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
+    // Do nothing because protected function
+}
+
 void cThread::mmapFpga() {
     // Do nothing because protected function
 }
@@ -204,14 +223,14 @@ void cThread::munmapFpga() {
     // Do nothing because protected function
 }
 
-void cThread::userMap(void *vaddr, uint32_t len) {
+void cThread::mapBuffer(void *vaddr, uint32_t len) {
     additional_state->tlb_pages.emplace(vaddr, len);
     additional_state->executeUnlessCrash([&] { 
         additional_state->input_writer.userMap(reinterpret_cast<uint64_t>(vaddr), len);
     });
 }
 
-void cThread::userUnmap(void *vaddr) {
+void cThread::unmapBuffer(void *vaddr) {
     auto status = additional_state->tlb_pages.erase(vaddr);
     if (status < 1) {
         ERROR("Tried to userUnmap non-existent page at vaddr " << vaddr)
@@ -221,6 +240,80 @@ void cThread::userUnmap(void *vaddr) {
     });
 }
 
+void cThread::userMap(void *vaddr, uint32_t len) {
+    DEBUG("cThread: Called userMap to map user buffer, vaddr " << vaddr << ", length " << len << " and ctid " << ctid)
+
+    if (!reg_cache.isEnabled()) {
+        mapBuffer(vaddr, len);
+        return;
+    }
+
+    // Registered ranges become a lookup; otherwise, map and cache the new registration
+    if (!reg_cache.acquire(reinterpret_cast<uint64_t>(vaddr), len)) {
+        mapBuffer(vaddr, len);
+        reg_cache.insert(reinterpret_cast<uint64_t>(vaddr), len);
+        for (uint64_t evicted : reg_cache.evict()) {
+            unmapBuffer(reinterpret_cast<void*>(evicted));
+        }
+    }
+}
+
+void cThread::userUnmap(void *vaddr) {
+    DEBUG("cThread: Called userUnmap to unmap user buffers")
+
+    // Cached registrations are only released, and unmapped lazily; a disabled cache may still hold registrations in use
+    if (reg_cache.release(reinterpret_cast<uint64_t>(vaddr))) {
+        for (uint64_t evicted : reg_cache.evict()) {
+            unmapBuffer(reinterpret_cast<void*>(evicted));
+        }
+    } else {
+        unmapBuffer(vaddr);
+    }
+}
+
+void cThread::setRegCacheBudget(uint64_t bytes) {
+    reg_cache.setBudget(bytes);
+    for (uint64_t evicted : reg_cache.evict()) {
+        unmapBuffer(reinterpret_cast<void*>(evicted));
+    }
+}
+
+void cThread::invalidateRegCache(void *vaddr, uint64_t len) {
+    for (uint64_t removed : reg_cache.invalidate(reinterpret_cast<uint64_t>(vaddr), len)) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+}
+
+void cThread::flushRegCache() {
+    for (uint64_t removed : reg_cache.flush()) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+}
+
+regCacheStats cThread::getRegCacheStats() const { return reg_cache.getStats(); }
+
+void cThread::setNumaPlacement(bool mem_bind, bool thread_affinity) {
+    // Only recorded; the simulated vFPGA is not attached to a NUMA node, so numa_node stays -1
+    numa_mem = mem_bind;
+    numa_affinity = thread_affinity;
+}
+
+int32_t cThread::getNumaNode() const { return numa_node; }
+
+std::vector<operStats> cThread::getOperStats() const {
+    #ifdef EN_OPER_STATS
+    return oper_stats.snapshot();
+    #else
+    return {};
+    #endif
+}
+
+void cThread::resetOperStats() {
+    #ifdef EN_OPER_STATS
+    oper_stats.reset();
+    #endif
+}
+
 void* cThread::getMem(CoyoteAlloc&& alloc) {
     if (alloc.remote) {ASSERT("Networking not implemented in simulation target")}
 
@@ -260,7 +353,14 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
 		}
         
         // Store the mapping in mapped_pages (pointers to memory and details of mapping as indicated in the cs_alloc struct in the beginning)
-        mapped_pages.emplace(mem, alloc);
+        if (!alloc.mem) {
+            alloc.mem = mem;
+        }
+        // An allocation that cannot be recorded (e.g., overlapping a stale entry) could never be freed, so it's released right away
+        if (!mapped_pages.insert(mem, alloc.size, alloc)) {
+            releaseMem(mem, alloc);
+            throw std::runtime_error("ERROR: cThread::getMem() - allocation overlaps an existing one, at vaddr " + std::to_string(reinterpret_cast<uint64_t>(mem)));
+        }
         DEBUG("Mapped mem at " << std::hex << reinterpret_cast<uint64_t>(mem) << std::dec)
 	}
 
@@ -269,31 +369,46 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
 	return mem;
 }
 
-void cThread::freeMem(void* vaddr) {
-	if (mapped_pages.find(vaddr) != mapped_pages.end()) {
-		auto mapped = mapped_pages[vaddr];
-		
-		switch (mapped.alloc) {
-            case CoyoteAllocType::REG: case CoyoteAllocType::THP: {
-                userUnmap(vaddr);
-                free(vaddr);
+void cThread::releaseMem(void *vaddr, const CoyoteAlloc &alloc) {
+	switch (alloc.alloc) {
+        case CoyoteAllocType::REG: case CoyoteAllocType::THP: {
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            free(vaddr);
 
-                break;
-            }
-            case CoyoteAllocType::HPF: {
-                userUnmap(vaddr);
-                munmap(vaddr, mapped.size);
+            break;
+        }
+        case CoyoteAllocType::HPF: {
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            munmap(vaddr, alloc.size);
 
-                break;
-            }
-            default: break;
-		}
+            break;
+        }
+        default: break;
+	}
+}
+
+void cThread::freeMem(void* vaddr) {
+	if (mapped_pages.find(vaddr)) {
+		auto mapped = *mapped_pages.find(vaddr);
+		
+		releaseMem(vaddr, mapped);
 
         mapped_pages.erase(vaddr);
 	}
     DEBUG("freeMem(" << reinterpret_cast<uint64_t>(vaddr) << ") finished")
 }
 
+const CoyoteAlloc* cThread::findAlloc(const void *addr, uint64_t len) const {
+    auto entry = mapped_pages.findContaining(addr, len);
+    return entry ? &entry->value : nullptr;
+}
+
+bool cThread::isMapped(const void *addr, uint64_t len) const {
+    return mapped_pages.findContaining(addr, len) != nullptr;
+}
+
 void cThread::setCSR(uint64_t val, uint32_t offs) {
     additional_state->executeUnlessCrash([&] { 
         additional_state->input_writer.setCSR(offs, val);
@@ -361,7 +476,7 @@ void cThread::invoke(CoyoteOper oper, syncSg sg) {
     DEBUG("invoke(...) finished")
 }
 
-void cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
     // Argument checks
     DEBUG("cThread: Call invoke for a one-side local operation with address " << sg.addr << ", length " << sg.len)
 
@@ -404,9 +519,11 @@ void cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
     }
 
     DEBUG("invoke(...) finished")
+
+    return nextCmplSeq(oper, last, sg.len);
 }
 
-void cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last) {
     // Argument checks
     DEBUG(
         "cThread: Call invoke for a two-sided local operation with source address " 
@@ -448,17 +565,117 @@ void cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last)
             last
         );
     });
+
+    return nextCmplSeq(oper, last, src_sg.len);
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, const localSgList &sgl) {
+    if (oper != CoyoteOper::LOCAL_READ && oper != CoyoteOper::LOCAL_WRITE) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with a localSgList, but the operation is not a LOCAL_READ or LOCAL_WRITE; exiting...");
+    }
+
+    std::vector<localSg> chunks = sgl.chunks();
+    if (chunks.empty()) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with an empty localSgList, exiting...");
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        invoke(oper, chunks[i], i == chunks.size() - 1);
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, const localSgList &src_sgl, const localSgList &dst_sgl) {
+    if (oper != CoyoteOper::LOCAL_TRANSFER) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with two localSgLists, but the operation is not a LOCAL_TRANSFER; exiting...");
+    }
+
+    std::vector<localSg> src_chunks = src_sgl.chunks();
+    std::vector<localSg> dst_chunks = dst_sgl.chunks();
+    if (src_chunks.empty() || dst_chunks.empty()) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with an empty localSgList, exiting...");
+    }
+
+    // The read and write halves are issued separately, since the lists don't have to line up; 
+    // together, the two final descriptors increment both counters, like a LOCAL_TRANSFER
+    for (size_t i = 0; i < std::max(src_chunks.size(), dst_chunks.size()); i++) {
+        if (i < src_chunks.size()) {
+            invoke(CoyoteOper::LOCAL_READ, src_chunks[i], i == src_chunks.size() - 1);
+        }
+        if (i < dst_chunks.size()) {
+            invoke(CoyoteOper::LOCAL_WRITE, dst_chunks[i], i == dst_chunks.size() - 1);
+        }
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, rdmaSg sg, bool last) {
+    ASSERT("Networking not implemented in simulation target!")
+    return 0;
 }
 
-void cThread::invoke(CoyoteOper oper, rdmaSg sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, tcpSg sg, bool last) {
     ASSERT("Networking not implemented in simulation target!")
+    return 0;
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<localSg> &sgs, bool last) {
+    // The simulation has no command FIFO credits to amortize, so a batch is simply issued entry by entry
+    for (const localSg &sg : sgs) {
+        invoke(oper, sg, last);
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<localSg> &src_sgs, const std::vector<localSg> &dst_sgs, bool last) {
+    if (src_sgs.size() != dst_sgs.size()) {ASSERT("Source and destination lists of invokeBatch must have the same number of entries")}
+    for (size_t i = 0; i < src_sgs.size(); i++) {
+        invoke(oper, src_sgs[i], dst_sgs[i], last);
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
 }
 
-void cThread::invoke(CoyoteOper oper, tcpSg sg, bool last) {
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<rdmaSg> &sgs, bool last) {
     ASSERT("Networking not implemented in simulation target!")
+    return 0;
+}
+
+uint32_t cThread::nextCmplSeq(CoyoteOper oper, bool last, uint64_t bytes) {
+    int32_t idx = getWbackIndex(oper);
+    if (idx == -1) {
+        return 0;
+    }
+
+    // LOCAL_TRANSFERs increment both the read and the write counter
+    if (last) {
+        if (isLocalRead(oper) && isLocalWrite(oper)) {
+            cmpl_seq[RD_WBACK]++;
+        }
+        cmpl_seq[idx]++;
+    }
+
+    #ifdef EN_OPER_STATS
+    oper_stats.submit(oper, cmpl_seq[idx], last, bytes);
+    #endif
+
+    return cmpl_seq[idx];
 }
 
 uint32_t cThread::checkCompleted(CoyoteOper oper) const {
+    uint32_t completed = readCompleted(oper);
+
+    #ifdef EN_OPER_STATS
+    oper_stats.observe(getWbackIndex(oper), completed);
+    #endif
+
+    return completed;
+}
+
+uint32_t cThread::readCompleted(CoyoteOper oper) const {
     if (isRemoteRdma(oper)) {ASSERT("Networking not implemented in simulation target!")}
     if (isRemoteTcp(oper)) {ASSERT("Networking not implemented in simulation target!")}
 
@@ -476,14 +693,57 @@ uint32_t cThread::checkCompleted(CoyoteOper oper) const {
     return result;
 }
 
+bool cThread::isCompleted(CoyoteOper oper, uint32_t seq) const {
+    return static_cast<int32_t>(checkCompleted(oper) - seq) >= 0;
+}
+
+void cThread::waitCompleted(CoyoteOper oper, uint32_t seq) {
+    waitFor([&]() { return isCompleted(oper, seq); }, wait_policy, wait_stats, wait_efd);
+}
+
+void cThread::setWaitPolicy(waitPolicy policy) {
+    if (policy.irq_wakeup && policy.mode != CoyoteWait::SPIN_BLOCK) {
+        throw std::runtime_error("ERROR: cThread::setWaitPolicy() - irq_wakeup requires the CoyoteWait::SPIN_BLOCK mode");
+    }
+
+    if (policy.mode == CoyoteWait::SPIN_BLOCK && wait_efd == -1) {
+        wait_efd = eventfd(0, EFD_NONBLOCK);
+        if (wait_efd == -1) {
+            throw std::runtime_error("ERROR: cThread could not create eventfd");
+        }
+    }
+
+    // Interrupts are only read from the simulation if a uisr was passed to the constructor; otherwise, waiters wake up on the timeout
+    wait_policy = policy;
+    irq_wakeup.store(policy.irq_wakeup, std::memory_order_release);
+}
+
+waitPolicy cThread::getWaitPolicy() const { return wait_policy; }
+
+waitStats cThread::getWaitStats() const { return wait_stats; }
+
+void cThread::wakeWaiters() {
+    if (wait_efd != -1) {
+        eventfd_write(wait_efd, 1);
+    }
+}
+
 void cThread::clearCompleted() {
+    for (uint32_t i = 0; i < N_WBACKS; i++) {
+        cmpl_seq[i] = 0;
+    }
+
+    #ifdef EN_OPER_STATS
+    oper_stats.discardInFlight();
+    #endif
+
     additional_state->executeUnlessCrash([&] { 
         additional_state->input_writer.clearCompleted();
     });
     DEBUG("clearCompleted() finished")
 }
 
-void cThread::doArpLookup(uint32_t ip_addr) {
+void cThread::doArpLookup(uint32_t ip_addr, bool wait) {
     ASSERT("Networking not implemented in simulation target")
 }
 
@@ -31,6 +31,7 @@
 #include <vector>
 
 #include <coyote/cThread.hpp>
+#include <coyote/cBuffer.hpp>
 
 namespace coyote {
 
@@ -65,6 +66,10 @@ public:
     virtual std::vector<size_t> getArgumentSizes() const = 0;
     
     virtual size_t getReturnSize() const = 0;
+
+    virtual std::vector<bool> getBufferArguments() const = 0;
+
+    virtual bool returnsBuffer() const = 0;
 };
 
 }
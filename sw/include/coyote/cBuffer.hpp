@@ -0,0 +1,105 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CBUFFER_HPP_
+#define _COYOTE_CBUFFER_HPP_
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace coyote {
+
+/**
+ * @brief A contiguous, variable-size buffer, passed to and returned from Coyote functions (cFunc) by reference
+ *
+ * Scalar function arguments are serialized and copied to the service. Buffers, instead, live in shared memory,
+ * allocated by the client with cConn::allocBuffer(...) and mapped by the service once, when allocated.
+ * Only the location of the buffer (region, offset, size) is sent with a task, and the service hands the function
+ * a pointer into its own mapping of the region, so the contents are never copied. Similarly, a function can 
+ * return a buffer, e.g., a slice of one of its buffer arguments, whose contents it has written.
+ *
+ * The service's mapping is only valid for the CPU: the cThread of a task belongs to the client process (the driver
+ * pins the client's pages), so FPGA transfers on a buffer must use the client's address instead, see fpgaAddr().
+ *
+ * When functions are executed directly through the scheduler (cSched), without a service, 
+ * data simply points to local memory and region is -1.
+ */
+struct cBuffer {
+    /// Start of the buffer, in the address space of the current process
+    void *data = { nullptr };
+
+    /// Size of the buffer, in bytes
+    uint64_t size = { 0 };
+
+    /// ID of the shared memory region holding the buffer; -1 if the buffer is not shared
+    int32_t region = { -1 };
+
+    /// Offset of the buffer in the shared memory region
+    uint64_t offset = { 0 };
+
+    /// Start of the buffer in the address space of the client process, as set by the service; nullptr if the same as data
+    void *client_data = { nullptr };
+
+    /// Returns the start of the buffer as a pointer to T
+    template<typename T>
+    T* as() const { return static_cast<T*>(data); }
+
+    /**
+     * @brief Returns the start of the buffer for FPGA transfers through the task's cThread, e.g., in a localSg of cThread::invoke(...)
+     *
+     * In a service, this is the client's address of the buffer, since the cThread (and, therefore, the FPGA) 
+     * operates on the address space of the client process; otherwise, it is the same as data.
+     */
+    void* fpgaAddr() const { return client_data != nullptr ? client_data : data; }
+
+    /**
+     * @brief Returns a part of the buffer
+     *
+     * @param offs Offset of the part, relative to the start of the buffer
+     * @param len Size of the part
+     * @note Throws a runtime_error if the part exceeds the buffer
+     */
+    cBuffer slice(uint64_t offs, uint64_t len) const {
+        if (offs > size || len > size - offs) {
+            throw std::runtime_error("ERROR: Buffer slice out of bounds");
+        }
+        return cBuffer{ 
+            static_cast<char*>(data) + offs, len, region, offset + offs, 
+            client_data != nullptr ? static_cast<char*>(client_data) + offs : nullptr 
+        };
+    }
+};
+
+static_assert(std::is_trivially_copyable<cBuffer>::value, "cBuffer is serialized with memcpy");
+
+/// True if T is a buffer argument or return value (cBuffer)
+template<typename T>
+constexpr bool is_buffer_v = std::is_same<std::decay_t<T>, cBuffer>::value;
+
+}
+
+#endif // _COYOTE_CBUFFER_HPP_
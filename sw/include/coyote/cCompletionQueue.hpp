@@ -0,0 +1,153 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CCOMPLETIONQUEUE_HPP_
+#define _COYOTE_CCOMPLETIONQUEUE_HPP_
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <future>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include <coyote/cThread.hpp>
+
+namespace coyote {
+
+/**
+ * @brief Asynchronous completion harvesting for many cThreads from a single poller thread
+ *
+ * Instead of every caller spinning on cThread::checkCompleted() and comparing a cumulative counter
+ * against an expected value, operations are registered with the completion sequence number returned
+ * by cThread::invoke(...). A single poller thread reads each (cThread, writeback counter) pair at most once
+ * per pass and fires the callbacks / fulfils the futures of all operations that have completed.
+ * When there is nothing pending, the poller sleeps on a condition variable.
+ *
+ * Example:
+ *     cCompletionQueue cq;
+ *     uint32_t seq = thread->invoke(CoyoteOper::LOCAL_TRANSFER, src_sg, dst_sg);
+ *     std::future<void> done = cq.add(thread, CoyoteOper::LOCAL_TRANSFER, seq);
+ *     ...
+ *     done.wait();
+ *
+ * @note Callbacks are executed on the poller thread and should therefore be short and must not throw
+ * @note Registered cThreads must not be destroyed or have their counters cleared (clearCompleted()) while they have pending operations; see remove(...)
+ */
+class cCompletionQueue {
+
+private:
+    /// A pending operation
+    struct cqEntry {
+        uint32_t seq;
+        std::function<void()> callback;
+    };
+
+    /// Pending operations, grouped by (cThread, writeback counter), so that each counter is read once per poll pass
+    std::map<std::pair<cThread*, int32_t>, std::vector<cqEntry>> pending;
+
+    /// Number of pending operations (across all groups)
+    std::atomic<uint32_t> n_pending;
+
+    /// Number of completed operations since construction
+    std::atomic<uint64_t> n_completed;
+
+    /// Protects pending
+    std::mutex mtx;
+
+    /// Wakes up the poller when new operations are added or on termination
+    std::condition_variable cv;
+
+    /// Poll interval when there are pending operations; zero yields the CPU between passes
+    std::chrono::nanoseconds poll_interval;
+
+    /// Set to stop the poller thread
+    bool stop;
+
+    /// Poller thread
+    std::thread poller;
+
+    /// Poller thread function
+    void pollLoop();
+
+public:
+    /**
+     * @brief Default constructor; starts the poller thread
+     * @param poll_interval Time the poller waits between passes while there are pending operations (default: 0, i.e., only yield)
+     */
+    cCompletionQueue(std::chrono::nanoseconds poll_interval = std::chrono::nanoseconds(0));
+
+    /// Default destructor; stops the poller, pending futures are left with a broken promise
+    ~cCompletionQueue();
+
+    cCompletionQueue(const cCompletionQueue&) = delete;
+    cCompletionQueue& operator=(const cCompletionQueue&) = delete;
+
+    /**
+     * @brief Registers an operation, whose callback is fired on the poller thread once it completes
+     *
+     * @param thread cThread the operation was issued on
+     * @param oper Issued operation
+     * @param seq Completion sequence number, as returned by invoke(...)
+     * @param callback Function to be called on completion
+     */
+    void add(cThread *thread, CoyoteOper oper, uint32_t seq, std::function<void()> callback);
+
+    /**
+     * @brief Registers an operation and returns a future, which is ready once the operation completes
+     *
+     * @param thread cThread the operation was issued on
+     * @param oper Issued operation
+     * @param seq Completion sequence number, as returned by invoke(...)
+     * @return Future, fulfilled on completion
+     */
+    std::future<void> add(cThread *thread, CoyoteOper oper, uint32_t seq);
+
+    /**
+     * @brief Drops all pending operations of a cThread, e.g., before it is destroyed
+     *
+     * Callbacks of dropped operations are not called, and the corresponding futures are left with a broken promise
+     * @param thread cThread whose operations should be dropped
+     */
+    void remove(cThread *thread);
+
+    /// Blocks until there are no pending operations
+    void drain();
+
+    /// Returns the number of pending operations
+    uint32_t getPending() const;
+
+    /// Returns the number of completed operations since construction
+    uint64_t getCompleted() const;
+};
+
+}
+
+#endif // _COYOTE_CCOMPLETIONQUEUE_HPP_
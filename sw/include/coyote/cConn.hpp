@@ -27,16 +27,27 @@
 #ifndef _COYOTE_CCONN_HPP_
 #define _COYOTE_CCONN_HPP_
 
+#include <map>
+#include <tuple>
+#include <mutex>
 #include <atomic>
+#include <future>
+#include <thread>
+#include <functional>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <unistd.h>
 #include <sys/un.h>
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <poll.h>
 
 #include <coyote/cTask.hpp>
 #include <coyote/cDefs.hpp>
+#include <coyote/cShmRing.hpp>
+#include <coyote/cBuffer.hpp>
 
 namespace coyote {
 
@@ -44,33 +55,172 @@ namespace coyote {
  * @brief Coyote connection class
  * 
  * A utility class that allows clients to connect to a Coyote background service
- * and submit tasks to be executed on the server side. The class supports both
- * blocking and non-blocking tasks.
+ * and submit tasks to be executed on the server side. The class supports blocking 
+ * tasks, non-blocking tasks whose completion is queried (iTask), as well as tasks
+ * whose result is delivered through a std::future (fTask, fTasks) or a callback (cbTask).
+ *
+ * All the methods are thread-safe. Completions are received by a single thread, 
+ * so one client thread can keep many tasks in flight without polling.
+ *
+ * Large or variable-size data is passed as cBuffer arguments (and return values), allocated
+ * with allocBuffer(...) in memory shared with the service, so that it is not copied.
  */
 class cConn {
 
 private: 
 
+    /// Handles the completion of a task; called with the task ID, the return code and the return value
+    using cmplHandler = std::function<void(int32_t, int32_t, const std::vector<char>&)>;
+
+    /// A task submitted with a future or a callback
+    struct pendingTask {
+        /// Size of the return value, in bytes
+        size_t ret_size;
+
+        /// Called on the completion thread, once the task completes
+        cmplHandler handler;
+    };
+
     /// Connection socket file descriptor
     int sockfd = -1;
 
     /// An atomic variable; used for generating unique IDs for tasks
     std::atomic<int32_t> task_counter;
 
-    /// A map of submitted tasks
+    /// A map of the tasks submitted with iTask(...) or task(...), whose completion is queried by the user
     std::map<int32_t, std::unique_ptr<cTask>> tasks;
 
-    /// A dedicated thread that periodically checks for completed tasks
+    /// Tasks submitted with a future or a callback; removed once completed
+    std::unordered_map<int32_t, pendingTask> pending;
+
+    /// Protects tasks and pending, which are accessed by the users and the completion thread
+    std::mutex tlock;
+
+    /// A dedicated thread that receives the completions
     std::thread completion_thread;
 
     /// Set to true when the completion thread is running
-    bool run_thread;
+    std::atomic<bool> run_thread;
+
+    /// Shared-memory submission and completion queues; nullptr if the server did not provide them
+    std::unique_ptr<cShmRing> ring;
+
+    /// Serializes submissions, since the shared-memory submission queue has a single producer
+    std::mutex submit_lock;
+
+    /// Bytes received on the socket, not yet parsed into responses; only accessed by the completion thread
+    std::vector<char> recv_buf;
+
+    /// Shared memory regions allocated with allocBuffer(...), by region ID
+    std::map<int32_t, cBuffer> regions;
+
+    /// Used for generating unique region IDs
+    std::atomic<int32_t> region_counter;
+
+    /// Protects regions
+    std::mutex region_lock;
 
     /**
-     * @brief Periodically checks for completed tasks and update the task map
+     * @brief Receives the completions and updates the tasks or calls their handlers
+     *
+     * Completions are received on the socket or, if set up, on the shared-memory completion queue
      */
     void checkCompletedTasks();
 
+    /**
+     * @brief Requests shared-memory queues from the server (DEF_OP_SHM_RING) and maps them
+     * 
+     * Blocks until the server responds. If the server cannot provide them, tasks are submitted over the socket;
+     * the server only completes tasks through the queues if they were submitted through them, see cService::setupRing(...)
+     */
+    void setupRing();
+
+    /**
+     * @brief Sends tasks of the same function to the server
+     *
+     * The tasks are submitted through the shared-memory queue if possible (with a single eventfd kick), 
+     * the rest over the socket, in a single write. If sending fails, the tasks are dropped.
+     *
+     * @param fid Function ID
+     * @param reqs Task IDs and the corresponding serialized function arguments
+     */
+    void submitTasks(int32_t fid, const std::vector<std::pair<int32_t, std::vector<char>>> &reqs);
+
+    /// Registers a task with a completion handler; returns the task ID
+    int32_t addHandler(size_t ret_size, cmplHandler handler);
+
+    /// Marks a task as completed or calls its handler
+    void completeTask(int32_t tid, int32_t ret_code, const std::vector<char> &ret_val);
+
+    /// Returns the size of the return value of a submitted task; 0 if the task is not found
+    size_t getRetValSize(int32_t tid);
+
+    /**
+     * @brief Sends a control request (e.g., DEF_OP_REG_BUFFER) and waits for the response
+     *
+     * @param opcode Request opcode
+     * @param arg Request argument, sent in place of the function ID
+     * @param fd If not -1, file descriptor passed to the server (SCM_RIGHTS)
+     * @return Return code sent by the server
+     */
+    int32_t sendControl(int32_t opcode, int32_t arg, int fd = -1);
+
+    /// Points a buffer returned by the server (region, offset, size) to the local mapping of its region
+    void resolveBuffer(cBuffer &buf);
+
+    /// Deserializes a return value; returned buffers are resolved to the local mapping
+    template<typename ret>
+    ret unpackReturn(const std::vector<char> &ret_val) {
+        ret val;
+        memcpy(&val, ret_val.data(), sizeof(ret));
+        if constexpr (is_buffer_v<ret>) {
+            resolveBuffer(val);
+        }
+        return val;
+    }
+
+    /// Error for tasks for which the server returned a non-zero code
+    static std::runtime_error retCodeError(int32_t tid) {
+        return std::runtime_error(
+            std::string("ERROR: Server returned non-zero code for task with tid: ") + std::to_string(tid) +
+            std::string("; please ensure the function ID is correct and registered with the server, ") +
+            std::string("as well as that the correct number and type of arguments is being transmitted.")
+        );
+    }
+
+    /// Serializes the function arguments into a single byte array; buffers are sent by location (region, offset, size)
+    template<typename... args>
+    static std::vector<char> packArguments(args... msg) {
+        std::vector<char> buf;
+        auto f_wr = [&](auto& x) {
+            if constexpr (is_buffer_v<decltype(x)>) {
+                if (x.region == -1) {
+                    throw std::runtime_error("ERROR: Buffer arguments must be allocated with cConn::allocBuffer()");
+                }
+            }
+            const char *p = reinterpret_cast<const char*>(&x);
+            buf.insert(buf.end(), p, p + sizeof(x));
+        };
+        (f_wr(msg), ...);
+        return buf;
+    }
+
+    /// Creates a completion handler which fulfils a promise with the return value, or sets an exception on a non-zero return code
+    template<typename ret>
+    cmplHandler futureHandler(std::shared_ptr<std::promise<ret>> promise) {
+        return [this, promise](int32_t tid, int32_t ret_code, const std::vector<char> &ret_val) {
+            if (ret_code != 0 || ret_val.size() < sizeof(ret)) {
+                promise->set_exception(std::make_exception_ptr(retCodeError(tid)));
+                return;
+            }
+            try {
+                promise->set_value(unpackReturn<ret>(ret_val));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        };
+    }
+
 public:
 
     /** 
@@ -79,20 +229,47 @@ public:
      * When called, this constructor create a local connection to a Coyote service, as implemented in cService.hpp
      *
      * @param sock_name The name of the Coyote socket, as registed by the server
+     * @param shm_ring If true, tasks are exchanged through shared-memory queues, if the server supports them (see cShmRing)
      */
-    cConn(std::string sock_name);
+    cConn(std::string sock_name, bool shm_ring = true);
 
-    /// Default destructor; sends a request to close the connection
+    /**
+     * @brief Default destructor; sends a request to close the connection
+     *
+     * Tasks submitted with a future or a callback which have not completed yet are completed with a non-zero return code
+     */
     ~cConn();
 
     /**
      * @brief Checks if a task with the given ID is completed
      *
-     * @param tid Task ID to check
+     * @param tid Task ID to check, as obtained from iTask()
      * @return true if the task is completed, false otherwise
      */
     bool isTaskCompleted(int32_t tid);
 
+    /// Returns true if tasks are exchanged with the server through shared-memory queues
+    bool hasShmRing() const { return ring != nullptr; }
+
+    /**
+     * @brief Allocates a buffer in memory shared with the service, to be passed to functions as a cBuffer argument
+     *
+     * The buffer is backed by its own memfd, which is mapped by the service once, here; afterwards, tasks only 
+     * carry the location of the buffer (or of a slice of it), and the function accesses the same memory.
+     *
+     * @param size Size of the buffer, in bytes
+     * @return The buffer, mapped into the client
+     * @note Throws a runtime_error if the buffer cannot be allocated or the service cannot map it
+     */
+    cBuffer allocBuffer(size_t size);
+
+    /**
+     * @brief Releases a buffer allocated with allocBuffer(...), in the client and the service
+     * @param buf The buffer, as returned by allocBuffer(...)
+     * @note No task using the buffer must be in flight
+     */
+    void freeBuffer(const cBuffer &buf);
+
     /**
      * @brief Submits a task to the Coyote service; blocking - waits until the task is completed
      *
@@ -110,58 +287,7 @@ public:
     template<typename ret, typename... args>
     ret task(int32_t fid, args... msg) {        
         DBG1("cConn: Submitting a blocking task; fid" << fid); 
-       
-        /*
-         * Add task to the map with a unique ID. In general, the cTask consturctor 
-         * expects the function arguments and a cThread; here, however, they are not needed, 
-         * since the function is executed on the server side. The purpose of the cTask
-         * in this class is to poll on its completion and return the result.
-        */
-        int32_t tid = task_counter++;
-
-        tasks.emplace(tid, std::make_unique<cTask>(tid, fid, sizeof(ret)));
-                
-        // Send opcode, function ID and task ID to server
-        int32_t req[3];
-        req[0] = DEF_OP_SUBMIT_TASK;
-        req[1] = fid;
-        req[2] = tid;
-        if (write(sockfd, &req, 3 * sizeof(int32_t)) != 3 * sizeof(int32_t)) {
-            throw std::runtime_error("ERROR: Failed to send request to server");
-        }
-
-        // Send the payload using parameter pack expansion and a lambda function 
-        auto f_wr = [&](auto& x){
-            using arg_type = decltype(x);
-            size_t arg_size = sizeof(arg_type);
-
-            if (write(sockfd, &x, arg_size) != arg_size) {
-                throw std::runtime_error("ERROR: Failed to send function arguments to server");
-            }
-        };
-        (f_wr(msg), ...);
-
-        // Wait until the task has been marked as completed
-        while (!tasks[tid]->isCompleted()) {
-            std::this_thread::sleep_for(std::chrono::microseconds(SLEEP_INTERVAL_CLIENT_CONN_MANAGER)); 
-        }
-
-        // Check return code & if zero, parse return value
-        int32_t ret_code = tasks[tid]->getRetCode();
-        if (ret_code != 0) {
-            throw std::runtime_error(
-                std::string("ERROR: Server returned non-zero code for task with tid: ") + std::to_string(tid) +
-                std::string("; please ensure the function ID is correct and registered with the server, ") +
-                std::string("as well as that the correct number and type of arguments is being transmitted.").c_str()
-            );
-        }
-
-        ret ret_val;
-        std::vector<char> tmp = tasks[tid]->getRetVal();
-        memcpy(&ret_val, tmp.data(), sizeof(ret));
-
-        DBG1("cConn: Request completed; return code" << ret_code << " return value: " << ret_val); 
-        return ret_val;
+        return fTask<ret>(fid, msg...).get();
     }
 
     /**
@@ -185,29 +311,92 @@ public:
     int32_t iTask(int32_t fid, args... msg) {        
         DBG1("cConn: Submitting a non-blocking task; fid" << fid); 
        
+        /*
+         * Add task to the map with a unique ID. In general, the cTask consturctor 
+         * expects the function arguments and a cThread; here, however, they are not needed, 
+         * since the function is executed on the server side. The purpose of the cTask
+         * in this class is to track its completion and store the result.
+        */
         int32_t tid = task_counter++;
-        tasks.emplace(tid, std::make_unique<cTask>(tid, fid, sizeof(ret)));
-        int32_t req[3];
-        req[0] = DEF_OP_SUBMIT_TASK;
-        req[1] = fid;
-        req[2] = tid;
-        if (write(sockfd, &req, 3 * sizeof(int32_t)) != 3 * sizeof(int32_t)) {
-            throw std::runtime_error("ERROR: Failed to send request to server");
+        {
+            std::lock_guard<std::mutex> lck(tlock);
+            tasks.emplace(tid, std::make_unique<cTask>(tid, fid, sizeof(ret)));
         }
+        submitTasks(fid, {{tid, packArguments(msg...)}});
 
-        auto f_wr = [&](auto& x){
-            using arg_type = decltype(x);
-            size_t arg_size = sizeof(arg_type);
+        return tid;
+    }
 
-            if (write(sockfd, &x, arg_size) != arg_size) {
-                throw std::runtime_error("ERROR: Failed to send function arguments to server");
-            }
-        };
-        (f_wr(msg), ...);
+    /**
+     * @brief Submits a task to the Coyote service; non-blocking - the result is delivered through a future
+     *
+     * @param fid Function ID of the request
+     * @param msg Variable number of arguments to be sent to the server
+     * @return Future holding the return value of the function; it holds a runtime_error if the server returns a non-zero code
+     *
+     * @note Implemnted in the header file, since it is a template function.
+     */
+    template<typename ret, typename... args>
+    std::future<ret> fTask(int32_t fid, args... msg) {
+        auto promise = std::make_shared<std::promise<ret>>();
+        std::future<ret> result = promise->get_future();
+        int32_t tid = addHandler(sizeof(ret), futureHandler<ret>(promise));
+        submitTasks(fid, {{tid, packArguments(msg...)}});
+        return result;
+    }
 
-        return tid;
+    /**
+     * @brief Submits a batch of tasks of the same function; the requests are sent together (a single write or eventfd kick)
+     *
+     * @param fid Function ID of the requests
+     * @param batch Arguments of each task
+     * @return Futures holding the return values, in the order of the batch
+     *
+     * @note Implemnted in the header file, since it is a template function.
+     */
+    template<typename ret, typename... args>
+    std::vector<std::future<ret>> fTasks(int32_t fid, const std::vector<std::tuple<args...>> &batch) {
+        std::vector<std::future<ret>> results;
+        std::vector<std::pair<int32_t, std::vector<char>>> reqs;
+        results.reserve(batch.size());
+        reqs.reserve(batch.size());
+        for (const std::tuple<args...> &msg : batch) {
+            auto promise = std::make_shared<std::promise<ret>>();
+            results.push_back(promise->get_future());
+            int32_t tid = addHandler(sizeof(ret), futureHandler<ret>(promise));
+            reqs.emplace_back(tid, std::apply([](auto... x) { return packArguments(x...); }, msg));
+        }
+        submitTasks(fid, reqs);
+        return results;
     }
 
+    /**
+     * @brief Submits a task to the Coyote service; non-blocking - the callback is called once the task completes
+     *
+     * @param fid Function ID of the request
+     * @param callback Called with the return code and the return value (only valid if the return code is zero)
+     * @param msg Variable number of arguments to be sent to the server
+     * @return Unique task ID
+     *
+     * @note Implemnted in the header file, since it is a template function.
+     * @note The callback is executed on the completion thread, so it should be short; it may submit further tasks
+     */
+    template<typename ret, typename... args>
+    int32_t cbTask(int32_t fid, std::function<void(int32_t, ret)> callback, args... msg) {
+        int32_t tid = addHandler(sizeof(ret), [this, callback](int32_t tid, int32_t ret_code, const std::vector<char> &ret_val) {
+            ret val = {};
+            if (ret_code == 0 && ret_val.size() >= sizeof(ret)) {
+                try {
+                    val = unpackReturn<ret>(ret_val);
+                } catch (const std::exception &e) {
+                    ret_code = 1;
+                }
+            }
+            callback(ret_code, val);
+        });
+        submitTasks(fid, {{tid, packArguments(msg...)}});
+        return tid;
+    }
 
     /**
      * @brief Obtains the task return value from the server
@@ -228,29 +417,26 @@ public:
      */
     template<typename ret>
     ret getTaskReturnValue(int32_t tid) {
-        if (tasks.find(tid) == tasks.end()) {
-            throw std::runtime_error(
-                std::string("ERROR: Task with id: ") + std::to_string(tid) +
-                std::string("not found when getting return value").c_str()
-            );
+        int32_t ret_code;
+        std::vector<char> tmp;
+        {
+            std::lock_guard<std::mutex> lck(tlock);
+            if (tasks.find(tid) == tasks.end()) {
+                throw std::runtime_error(
+                    std::string("ERROR: Task with id: ") + std::to_string(tid) +
+                    std::string("not found when getting return value").c_str()
+                );
+            }
+            ret_code = tasks[tid]->getRetCode();
+            tmp = tasks[tid]->getRetVal();
         }
         
-        int32_t ret_code = tasks[tid]->getRetCode();
         if (ret_code != 0) {
-            throw std::runtime_error(
-                std::string("ERROR: Server returned non-zero code for task with tid: ") + std::to_string(tid) +
-                std::string("; please ensure the function ID is correct and registered with the server, ") +
-                std::string("as well as that the correct number and type of arguments is being transmitted.").c_str()
-            );
+            throw retCodeError(tid);
         }
 
-        ret ret_val;
-        std::vector<char> tmp = tasks[tid]->getRetVal();
-        memcpy(&ret_val, tmp.data(), sizeof(ret));
-
-        DBG1("cConn: Request completed; return code" << ret_code << " return value: " << ret_val); 
-        return ret_val;
-
+        DBG1("cConn: Request completed; return code" << ret_code); 
+        return unpackReturn<ret>(tmp);
     }
 
 };
@@ -0,0 +1,379 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CCORO_HPP_
+#define _COYOTE_CCORO_HPP_
+
+// The library itself is built as C++17; the coroutine support is header-only and available to applications built with C++20
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include <deque>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+
+#include <coyote/cWait.hpp>
+#include <coyote/cThread.hpp>
+
+namespace coyote {
+
+class cCoroExecutor;
+
+/**
+ * @brief Lazily-started coroutine task, the return type of coroutines that co_await Coyote operations
+ *
+ * A cCoro is either co_awaited from another cCoro (which resumes once it finishes and receives its result),
+ * or handed to cCoroExecutor::spawn(...). Exceptions thrown in the coroutine are rethrown to the awaiter.
+ *
+ * @tparam T Result type of the coroutine
+ */
+template <typename T = void>
+class cCoro;
+
+namespace detail {
+
+/// Common part of the cCoro promises: continuation and exception
+struct coroPromiseBase {
+    /// Coroutine to resume once this one finishes; if null, control returns to whoever resumed it (the executor)
+    std::coroutine_handle<> continuation = { nullptr };
+
+    /// Exception thrown by the coroutine, if any
+    std::exception_ptr exception = { nullptr };
+
+    /// Symmetric transfer to the continuation, so that long chains of coroutines don't grow the stack
+    struct finalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            std::coroutine_handle<> cont = h.promise().continuation;
+            return cont ? cont : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    finalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct coroPromise : coroPromiseBase {
+    std::optional<T> value;
+
+    cCoro<T> get_return_object() noexcept;
+    void return_value(T v) { value.emplace(std::move(v)); }
+
+    T result() {
+        if (exception) { std::rethrow_exception(exception); }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct coroPromise<void> : coroPromiseBase {
+    cCoro<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+
+    void result() {
+        if (exception) { std::rethrow_exception(exception); }
+    }
+};
+
+}
+
+template <typename T>
+class cCoro {
+public:
+    using promise_type = detail::coroPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    cCoro() = default;
+    explicit cCoro(handle_type h): handle(h) {}
+    cCoro(cCoro &&other) noexcept: handle(std::exchange(other.handle, nullptr)) {}
+    cCoro& operator=(cCoro &&other) noexcept {
+        if (this != &other) {
+            if (handle) { handle.destroy(); }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    cCoro(const cCoro&) = delete;
+    cCoro& operator=(const cCoro&) = delete;
+    ~cCoro() { if (handle) { handle.destroy(); } }
+
+    /// Returns true once the coroutine has run to completion
+    bool done() const { return !handle || handle.done(); }
+
+    /// Awaiting a cCoro starts it and resumes the awaiter, with its result, once it finishes
+    auto operator co_await() && noexcept {
+        struct awaiter {
+            handle_type h;
+            bool await_ready() const noexcept { return !h || h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                h.promise().continuation = awaiting;
+                return h;
+            }
+            T await_resume() { return h.promise().result(); }
+        };
+        return awaiter{handle};
+    }
+
+private:
+    friend class cCoroExecutor;
+    handle_type handle = { nullptr };
+};
+
+namespace detail {
+
+template <typename T>
+inline cCoro<T> coroPromise<T>::get_return_object() noexcept { 
+    return cCoro<T>(std::coroutine_handle<coroPromise<T>>::from_promise(*this)); 
+}
+
+inline cCoro<void> coroPromise<void>::get_return_object() noexcept { 
+    return cCoro<void>(std::coroutine_handle<coroPromise<void>>::from_promise(*this)); 
+}
+
+}
+
+/**
+ * @brief Single-threaded executor, which resumes coroutines as their Coyote operations complete
+ *
+ * Operations are issued immediately through the usual cThread::invoke(...), which returns a completion
+ * sequence number; the awaiting coroutine is then parked until the corresponding writeback counter reaches it.
+ * Each pass of poll() reads every (cThread, writeback counter) pair with parked coroutines once and resumes
+ * the coroutines in completion order, so hundreds of outstanding operations can be served from one core
+ * without a thread or a blocking checkCompleted() loop per request.
+ *
+ * Example (compiled with -std=c++20):
+ *     cCoro<> serve(cCoroExecutor &exec, cThread *thread, localSg src, localSg dst) {
+ *         co_await exec.transfer(thread, src, dst);
+ *         co_await exec.rdmaWrite(thread, rdma_sg);
+ *     }
+ *     ...
+ *     for (int i = 0; i < N; i++) { exec.spawn(serve(exec, thread, src[i], dst[i])); }
+ *     exec.run();
+ *
+ * @note Not thread-safe; all coroutines of an executor must be spawned and run from the same thread.
+ * @note Completion tracking relies on the cumulative counters, so the cThreads must not have clearCompleted() 
+ *       called on them while there are parked coroutines.
+ */
+class cCoroExecutor {
+
+public:
+    /// Awaitable for a completion sequence number of an operation on a cThread
+    struct opAwaiter {
+        cCoroExecutor *exec;
+        cThread *thread;
+        CoyoteOper oper;
+        uint32_t seq;
+
+        bool await_ready() const { return getWbackIndex(oper) == -1 || thread->isCompleted(oper, seq); }
+        void await_suspend(std::coroutine_handle<> h) { exec->park(thread, oper, seq, h); }
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @brief Constructs an executor
+     * @param policy Wait policy of run() when no coroutine can make progress; spinning and yielding by default
+     */
+    explicit cCoroExecutor(waitPolicy policy = { CoyoteWait::SPIN_YIELD }): policy(policy) {}
+
+    cCoroExecutor(const cCoroExecutor&) = delete;
+    cCoroExecutor& operator=(const cCoroExecutor&) = delete;
+
+    /// Takes ownership of a top-level coroutine and schedules it; it starts running in the next poll()
+    void spawn(cCoro<void> &&coro) {
+        if (coro.done()) {
+            return;
+        }
+        ready.push_back(coro.handle);
+        tasks.push_back(std::move(coro));
+    }
+
+    /// Awaitable for an already issued operation, given the completion sequence number returned by invoke(...)
+    opAwaiter wait(cThread *thread, CoyoteOper oper, uint32_t seq) {
+        return opAwaiter{this, thread, oper, seq};
+    }
+
+    /// Issues an operation with cThread::invoke(...) and returns an awaitable for its completion
+    template <typename... Args>
+    opAwaiter invoke(cThread *thread, CoyoteOper oper, Args&&... args) {
+        uint32_t seq = thread->invoke(oper, std::forward<Args>(args)...);
+        return opAwaiter{this, thread, oper, seq};
+    }
+
+    /// co_await exec.transfer(thread, src, dst): LOCAL_TRANSFER from src to dst
+    opAwaiter transfer(cThread *thread, localSg src, localSg dst) { 
+        return invoke(thread, CoyoteOper::LOCAL_TRANSFER, src, dst); 
+    }
+
+    /// co_await exec.read(thread, sg): LOCAL_READ of sg into the vFPGA
+    opAwaiter read(cThread *thread, localSg sg) { return invoke(thread, CoyoteOper::LOCAL_READ, sg); }
+
+    /// co_await exec.write(thread, sg): LOCAL_WRITE of the vFPGA output to sg
+    opAwaiter write(cThread *thread, localSg sg) { return invoke(thread, CoyoteOper::LOCAL_WRITE, sg); }
+
+    /// co_await exec.rdmaWrite(thread, sg): REMOTE_RDMA_WRITE on the thread's queue pair
+    opAwaiter rdmaWrite(cThread *thread, rdmaSg sg) { return invoke(thread, CoyoteOper::REMOTE_RDMA_WRITE, sg); }
+
+    /// co_await exec.rdmaRead(thread, sg): REMOTE_RDMA_READ on the thread's queue pair
+    opAwaiter rdmaRead(cThread *thread, rdmaSg sg) { return invoke(thread, CoyoteOper::REMOTE_RDMA_READ, sg); }
+
+    /**
+     * @brief Single pass: resumes all runnable coroutines and those whose operations have completed
+     *
+     * Exceptions escaping a spawned coroutine are rethrown from here, after the coroutine has been released.
+     * @return Number of coroutines resumed
+     */
+    uint32_t poll() {
+        // Each counter is read once per pass; completed coroutines are resumed in the order they were parked
+        for (auto &group : parked) {
+            if (group.waiters.empty()) {
+                continue;
+            }
+
+            uint32_t completed = group.thread->checkCompleted(group.oper);
+            auto done = std::stable_partition(group.waiters.begin(), group.waiters.end(), [completed](const auto &w) {
+                return static_cast<int32_t>(completed - w.first) < 0;
+            });
+            for (auto w = done; w != group.waiters.end(); w++) {
+                ready.push_back(w->second);
+            }
+            n_parked -= group.waiters.end() - done;
+            group.waiters.erase(done, group.waiters.end());
+        }
+
+        // Coroutines resumed here may make further ones runnable; those are picked up in the next pass
+        uint32_t n_resumed = 0;
+        for (size_t n = ready.size(); n > 0; n--, n_resumed++) {
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+
+        // Release finished top-level coroutines
+        std::exception_ptr exception = nullptr;
+        for (auto it = tasks.begin(); it != tasks.end();) {
+            if (it->done()) {
+                if (it->handle.promise().exception && !exception) {
+                    exception = it->handle.promise().exception;
+                }
+                it = tasks.erase(it);
+            } else {
+                it++;
+            }
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+
+        return n_resumed;
+    }
+
+    /// Runs until all spawned coroutines have finished, waiting according to the wait policy when none can make progress
+    void run() {
+        while (!tasks.empty()) {
+            if (poll() == 0 && !tasks.empty()) {
+                waitFor([this] { return !ready.empty() || anyCompleted(); }, policy, stats);
+            }
+        }
+    }
+
+    /// Returns the number of spawned coroutines that have not finished yet
+    size_t getActive() const { return tasks.size(); }
+
+    /// Returns the number of coroutines waiting for an operation to complete
+    size_t getParked() const { return n_parked; }
+
+    /// Returns the counters of how often run() had to wait, and in which phase it was woken up
+    waitStats getWaitStats() const { return stats; }
+
+private:
+    /// Coroutines parked on one writeback counter of a cThread, with their sequence numbers, in issue order
+    struct parkGroup {
+        cThread *thread;
+        CoyoteOper oper;
+        int32_t idx;
+        std::vector<std::pair<uint32_t, std::coroutine_handle<>>> waiters;
+    };
+
+    /// Wait policy of run()
+    waitPolicy policy;
+
+    /// Wait statistics of run()
+    waitStats stats;
+
+    /// Spawned top-level coroutines, owned by the executor until they finish
+    std::vector<cCoro<void>> tasks;
+
+    /// Coroutines that can be resumed
+    std::deque<std::coroutine_handle<>> ready;
+
+    /// Parked coroutines; the number of (cThread, counter) pairs is small, hence a flat vector
+    std::vector<parkGroup> parked;
+
+    /// Total number of parked coroutines
+    size_t n_parked = { 0 };
+
+    void park(cThread *thread, CoyoteOper oper, uint32_t seq, std::coroutine_handle<> h) {
+        int32_t idx = getWbackIndex(oper);
+        if (idx == -1) {
+            throw std::runtime_error("ERROR: cCoroExecutor: awaited operation has no completion counter");
+        }
+
+        for (auto &group : parked) {
+            if (group.thread == thread && group.idx == idx) {
+                group.waiters.emplace_back(seq, h);
+                n_parked++;
+                return;
+            }
+        }
+        parked.push_back({thread, oper, idx, {{seq, h}}});
+        n_parked++;
+    }
+
+    /// Waiters of a group are in issue order, so only the oldest one needs to be checked; one counter read per group
+    bool anyCompleted() const {
+        for (const auto &group : parked) {
+            if (!group.waiters.empty() && group.thread->isCompleted(group.oper, group.waiters.front().first)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+}
+
+#endif // __cplusplus >= 202002L
+
+#endif // _COYOTE_CCORO_HPP_
@@ -272,6 +272,9 @@ constexpr unsigned long const HUGE_PAGE_SHIFT = 21UL;
 // Maximum number of Coyote threads per vFPGA
 constexpr int const N_CTID_MAX = 64;
 
+// Default amount of pinned memory the scheduler may use for cached app bitstreams; see cSched::setCacheBudget
+constexpr unsigned long long const DEF_BITSTREAM_CACHE_BUDGET = (1ULL << 30); // B
+
 /**
  * Size and offset of memory mapped regions (vFPGA control regions):
  * vFPGA CSRs; accessed through getCSR and setCSR
@@ -314,14 +317,15 @@ constexpr unsigned long const DEF_PORT = 18488;
 
 // Background daemons
 constexpr unsigned long const RECV_BUFF_SIZE = 1024;
-constexpr unsigned long const DAEMON_CLEAN_CONNS_SLEEP = 500; // us
-constexpr unsigned long const DAEMON_ACCEPT_CONN_SLEEP = 50; // us
-constexpr unsigned long const DAEMON_PROCESS_REQUESTS_SLEEP = 10; // us
 constexpr unsigned long const MAX_NUM_CLIENTS = 64;
 constexpr unsigned long const DEF_OP_CLOSE_CONN = 0;
 constexpr unsigned long const DEF_OP_SUBMIT_TASK = 1;
-constexpr unsigned long const SLEEP_INTERVAL_CLIENT_CONN_MANAGER = 500; // us
-static constexpr struct timeval SERVER_RECV_TIMEOUT = {.tv_sec = 0, .tv_usec = 5000}; 
+constexpr unsigned long const DEF_OP_SHM_RING = 2;
+constexpr unsigned long const DEF_OP_REG_BUFFER = 3;
+constexpr unsigned long const DEF_OP_UNREG_BUFFER = 4;
+constexpr unsigned long const SHM_RING_DEPTH = 256;
+constexpr unsigned long const SHM_RING_SLOT_SIZE = 256; // B
+constexpr int const CLIENT_POLL_TIMEOUT = 100; // ms
 static constexpr struct timeval CLIENT_RECV_TIMEOUT = {.tv_sec = 0, .tv_usec = 500}; 
 
 /// @brief RDMA Queue (QP) --- keeps all the necessary information of a single node in RDMA connections
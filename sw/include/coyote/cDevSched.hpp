@@ -0,0 +1,213 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CDEVSCHED_HPP_
+#define _COYOTE_CDEVSCHED_HPP_
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <coyote/bFunc.hpp>
+#include <coyote/cTask.hpp>
+#include <coyote/cSched.hpp>
+#include <coyote/cThread.hpp>
+
+namespace coyote {
+
+/**
+ * @brief Device-wide Coyote scheduler, placing tasks on any vFPGA of the device
+ *
+ * A cSched only manages a single vFPGA, so a task submitted to it waits for a reconfiguration, even when another
+ * vFPGA holds the task's bitstream and is idle. The device scheduler sits above the cSched instances of a set of vFPGAs
+ * and routes each task to a vFPGA, as follows:
+ *   1. vFPGAs holding the task's bitstream (or with queued tasks of the same function, which will load it) are preferred; 
+ *      among them, the least loaded one is picked
+ *   2. If there is no such vFPGA, the least loaded vFPGA is picked, and its cSched reconfigures it
+ * Optionally, an idle vFPGA is reconfigured even when all the matching vFPGAs are busy, see setRcnfgLoadThreshold().
+ * The cSched instances still order and execute the tasks, following their scheduling policy.
+ *
+ * Since a task is executed on a cThread of the vFPGA it is placed on, the tasks are submitted without a cThread, 
+ * together with the ID of the client process; the device scheduler creates one cThread per (vFPGA, client process).
+ *
+ * @note Application bitstreams are specific to a vFPGA, so functions are added through a factory, called once per vFPGA
+ */
+class cDevSched {
+
+private:
+    /// Instances of the device schedulers; one per device, since the cSched instances are also unique
+    static std::map<uint32_t, cDevSched*> dev_schedulers;
+
+    /// Device number
+    uint32_t device;
+
+    /// Schedulers of the managed vFPGAs, by vFPGA ID
+    std::map<int32_t, cSched*> regions;
+
+    /// Placement of a task
+    struct taskPlacement {
+        int32_t vfid;
+        pid_t hpid;
+    };
+
+    /// Placement of the submitted, not yet released, tasks, by task ID
+    std::map<int32_t, taskPlacement> placements;
+
+    /// Released tasks that were still running, as (task ID, vFPGA ID), by client process; their cThreads must outlive them
+    std::map<pid_t, std::vector<std::pair<int32_t, int32_t>>> draining;
+
+    /// cThreads for executing the tasks, by (vFPGA ID, client process ID)
+    std::map<std::pair<int32_t, pid_t>, std::unique_ptr<cThread>> cthreads;
+
+    /// Minimum load of all matching vFPGAs, for an idle vFPGA to be reconfigured instead
+    uint32_t rcnfg_load_thr;
+
+    /// epoll instance over the completion events of the managed vFPGAs; -1 until requested through getCompletionFd()
+    int cmpl_fd;
+
+    /// Protects placements, draining and cthreads; also serializes the routing decisions
+    std::mutex mtx;
+
+    /// Default constructor; private to ensure the class is implemented as a singleton
+    cDevSched(uint32_t device, std::vector<int32_t> vfids, bool reorder);
+
+    /**
+     * @brief Picks the vFPGA for a task of a function; mtx must be held
+     * @param fid Function ID
+     * @return vFPGA ID, or -1 if the function isn't registered with any vFPGA
+     */
+    int32_t route(int32_t fid);
+
+public:
+    /**
+     * @brief Creates the device scheduler, or returns the existing instance
+     *
+     * @param device Device number
+     * @param vfids IDs of the vFPGAs to manage; ignored if the instance already exists
+     * @param reorder Scheduling policy of the underlying cSched instances, see cSched::getInstance(...)
+     * @return Pointer to the cDevSched instance
+     */
+    static cDevSched* getInstance(uint32_t device, std::vector<int32_t> vfids = {}, bool reorder = true) {
+        if (dev_schedulers.find(device) == dev_schedulers.end() || dev_schedulers[device] == nullptr) {
+            dev_schedulers[device] = new cDevSched(device, vfids, reorder);
+        }
+        return dev_schedulers[device];
+    }
+
+    /// Starts the schedulers of all the managed vFPGAs
+    void start();
+
+    /// Stops the schedulers of all the managed vFPGAs
+    void stop();
+
+    /**
+     * @brief Adds a user function to all the managed vFPGAs
+     *
+     * @param make_fn Factory, returning the function for a given vFPGA ID (e.g., with the bitstream built for that vFPGA)
+     * @return 0 if the function was added to all the vFPGAs, otherwise the first non-zero return code of cSched::addFunction(...)
+     */
+    int addFunction(std::function<std::unique_ptr<bFunc>(int32_t)> make_fn);
+
+    /**
+     * @brief Places a task on a vFPGA and submits it to the vFPGA's scheduler
+     *
+     * @param task Task; its cThread is set to the cThread of the client process on the chosen vFPGA
+     * @param hpid ID of the client process, whose memory the task operates on
+     * @return ID of the vFPGA the task was placed on, or -1 if the task could not be added
+     */
+    int32_t addTask(std::unique_ptr<cTask> task, pid_t hpid = getpid());
+
+    /**
+     * @brief Returns a file descriptor which becomes readable when a task completes on any managed vFPGA
+     *
+     * Same as cSched::getCompletionFd(), for all the managed vFPGAs at once: the descriptor is an epoll 
+     * instance over their completion events, so it can itself be waited on with poll/epoll (see cService).
+     *
+     * @return Non-blocking file descriptor; owned by the device scheduler
+     */
+    int getCompletionFd();
+
+    /**
+     * @brief Collects the IDs of the tasks completed on any managed vFPGA since the last call; requires getCompletionFd()
+     * @note Also consumes the completion events, unlike cSched::takeCompleted()
+     */
+    std::vector<int32_t> takeCompleted();
+
+    /**
+     * @brief Returns a user function, as registered with the managed vFPGAs
+     *
+     * The instances of a function on different vFPGAs only differ in their bitstreams, so the one of any 
+     * vFPGA describes the arguments and the return value of the function.
+     *
+     * @param fid Function ID
+     * @return Pointer to the function, or nullptr if it isn't registered
+     */
+    bFunc* getFunction(int32_t fid);
+
+    /// Checks if a task with a given ID is completed; see cSched::isTaskCompleted(...)
+    bool isTaskCompleted(int32_t tid);
+
+    /// Gets the task with the given ID; see cSched::getTask(...)
+    cTask* getTask(int32_t tid);
+
+    /// Releases a task, once its result is no longer needed; see cSched::releaseTask(...)
+    bool releaseTask(int32_t tid);
+
+    /**
+     * @brief Releases all the tasks and cThreads of a client process, e.g., once it disconnects
+     *
+     * @param hpid ID of the client process
+     * @return true if all resources were released; false if some tasks were still running, in which case the 
+     *         cThreads are kept and the call should be repeated later
+     */
+    bool releaseClient(pid_t hpid);
+
+    /**
+     * @brief Sets the load (queued and running tasks) that all vFPGAs holding a task's bitstream must reach, 
+     * for an idle vFPGA to be reconfigured for the task instead
+     * @param thr Load threshold; the default, UINT32_MAX, only reconfigures when no vFPGA holds the bitstream
+     */
+    void setRcnfgLoadThreshold(uint32_t thr);
+
+    /// Returns the currently loaded bitstream of each managed vFPGA, by vFPGA ID
+    std::map<int32_t, std::string> getBitstreams();
+
+    /// Returns the scheduler of a managed vFPGA, or nullptr if the vFPGA isn't managed
+    cSched* getScheduler(int32_t vfid);
+};
+
+}
+
+#endif // _COYOTE_CDEVSCHED_HPP_
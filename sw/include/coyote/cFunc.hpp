@@ -49,6 +49,11 @@ namespace coyote {
  * to be used in conjuction with Coyote services (cService) and requests (cReq).
  * For an example, refer to Example 9 in examples/.
  *
+ * Arguments and the return value are trivially copyable types, which are copied between the 
+ * client and the service. Large or variable-size data should be passed as a cBuffer instead, 
+ * which is shared with the client and not copied; e.g., cFunc<cBuffer, cBuffer, int> takes a
+ * buffer and an integer, and returns a buffer, such as a slice of its input, to the client.
+ *
  * @note Since this class is a template, it must be implemented in the header file
  * Otherwise, it leads to compilatiation errors. An alternative is to use
  * template specialization, but it is not applicable in this case, since the
@@ -105,7 +110,7 @@ public:
      * Each char buffer is then unpacked into the corresponding argument. There are alternatives
      * to this implementation (e.g., using std::any); however, using char buffer provides one of the
      * simplest solutions, with no reliance on complex data types. Additionally, when the function
-     * arguments are received in the server (processRequests() function), they are naurally written to a 
+     * arguments are received in the server (cService::processRequest() function), they are naurally written to a 
      * char buffer, since they are contigious, byte-addressable and easily cast to other data types. 
      */
     std::vector<char> run(cThread* coyote_thread, const std::vector<std::vector<char>>& x) override {
@@ -154,6 +159,16 @@ public:
     /// Similar to above, returns the size of the return value of the function
     size_t getReturnSize() const override { return sizeof(ret); }
 
+    /** 
+     * @brief Returns a vector of flags, one for each of the function arguments, set for buffer arguments (cBuffer)
+     * 
+     * Buffer arguments are not copied by the cService; instead, it maps the buffer location into its own address space
+     */ 
+    std::vector<bool> getBufferArguments() const override { return { is_buffer_v<args>... }; }
+
+    /// Returns true if the function returns a buffer (cBuffer)
+    bool returnsBuffer() const override { return is_buffer_v<ret>; }
+
     /// Getter: Function ID
     int32_t getFid() const override { return fid; }
 
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CINTERVALMAP_HPP_
+#define _COYOTE_CINTERVALMAP_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace coyote {
+
+/**
+ * @brief Ordered map of non-overlapping address intervals to values
+ *
+ * Implemented as a flat vector sorted by start address, so that the owning interval of any (interior) pointer
+ * is found with a binary search, in O(log n), and iteration is cache-friendly. Insertions and removals are O(n),
+ * which is fine for the intended use (buffer allocations, where lookups on the data path dominate).
+ *
+ * @tparam T Value type, e.g., CoyoteAlloc
+ */
+template <typename T>
+class cIntervalMap {
+
+public:
+    /// An interval [start, start + len) and its value
+    struct entry {
+        /// Start address
+        void *start;
+
+        /// Length, in bytes
+        uint64_t len;
+
+        /// Value attached to the interval
+        T value;
+    };
+
+    using iterator = typename std::vector<entry>::iterator;
+    using const_iterator = typename std::vector<entry>::const_iterator;
+
+private:
+    std::vector<entry> entries;
+
+    static uint64_t addr(const void *ptr) { return reinterpret_cast<uint64_t>(ptr); }
+
+    /// First entry starting strictly after the address
+    const_iterator after(const void *ptr) const {
+        return std::upper_bound(entries.begin(), entries.end(), addr(ptr), [](uint64_t a, const entry &e) { return a < addr(e.start); });
+    }
+
+    iterator after(const void *ptr) {
+        return std::upper_bound(entries.begin(), entries.end(), addr(ptr), [](uint64_t a, const entry &e) { return a < addr(e.start); });
+    }
+
+public:
+    /**
+     * @brief Inserts an interval
+     * @return False if the interval is empty or overlaps an existing one, in which case the map is unchanged
+     */
+    bool insert(void *start, uint64_t len, T value) {
+        if (len == 0 || overlaps(start, len)) {
+            return false;
+        }
+        entries.insert(after(start), entry{start, len, std::move(value)});
+        return true;
+    }
+
+    /**
+     * @brief Removes the interval starting at the given address
+     * @return False if there is no interval starting at start
+     */
+    bool erase(void *start) {
+        auto it = after(start);
+        if (it == entries.begin() || (--it)->start != start) {
+            return false;
+        }
+        entries.erase(it);
+        return true;
+    }
+
+    /// Returns the value of the interval starting exactly at the given address; nullptr if there is none
+    T* find(const void *start) {
+        auto it = after(start);
+        return (it != entries.begin() && (--it)->start == start) ? &it->value : nullptr;
+    }
+
+    const T* find(const void *start) const {
+        auto it = after(start);
+        return (it != entries.begin() && (--it)->start == start) ? &it->value : nullptr;
+    }
+
+    /**
+     * @brief Returns the interval fully containing [ptr, ptr + len); nullptr if there is none
+     * @note Since intervals don't overlap, at most one interval can contain the range
+     */
+    const entry* findContaining(const void *ptr, uint64_t len = 1) const {
+        auto it = after(ptr);
+        if (it == entries.begin()) {
+            return nullptr;
+        }
+        --it;
+        return (addr(ptr) + len <= addr(it->start) + it->len) ? &(*it) : nullptr;
+    }
+
+    /// Returns true if [start, start + len) overlaps any interval
+    bool overlaps(const void *start, uint64_t len) const {
+        auto it = after(start);
+
+        // The preceding interval may extend into the range, the following one may start within it
+        if (it != entries.begin() && addr(std::prev(it)->start) + std::prev(it)->len > addr(start)) {
+            return true;
+        }
+        return it != entries.end() && addr(it->start) < addr(start) + len;
+    }
+
+    /// Number of intervals
+    size_t size() const { return entries.size(); }
+
+    /// Returns true if there are no intervals
+    bool empty() const { return entries.empty(); }
+
+    /// Removes all intervals
+    void clear() { entries.clear(); }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+};
+
+}
+
+#endif // _COYOTE_CINTERVALMAP_HPP_
@@ -0,0 +1,147 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CMEMARENA_HPP_
+#define _COYOTE_CMEMARENA_HPP_
+
+#include <memory>
+#include <cstdint>
+
+#include <coyote/cThread.hpp>
+
+namespace coyote {
+
+/// Default size of a region obtained from cThread::getMem() by the arena (a multiple of the huge page size)
+constexpr uint32_t const ARENA_REGION_SIZE = 32 * 1024 * 1024;
+
+/// Default maximum number of regions an arena can grow to
+constexpr uint32_t const ARENA_MAX_REGIONS = 64;
+
+/// @brief Memory arena statistics
+struct arenaStats {
+    /// Bytes obtained from cThread::getMem() (and hence mapped to the vFPGA), including large allocations
+    uint64_t reserved = { 0 };
+
+    /// Bytes currently handed out to users, rounded up to the size class
+    uint64_t in_use = { 0 };
+
+    /// Maximum of in_use since the arena was created
+    uint64_t high_water = { 0 };
+
+    /// Bytes of the allocations larger than a slab, included in reserved and in_use
+    uint64_t large_bytes = { 0 };
+
+    /// Bytes carved into slabs; slabs are assigned to a size class and not returned until the arena is destroyed
+    uint64_t slab_bytes = { 0 };
+
+    /// Bytes requested by users over the lifetime of the arena
+    uint64_t total_requested = { 0 };
+
+    /// Bytes handed out over the lifetime of the arena (i.e., total_requested, rounded up to the size classes)
+    uint64_t total_allocated = { 0 };
+
+    /// Number of regions obtained from cThread::getMem()
+    uint32_t n_regions = { 0 };
+
+    /// Number of allocations served
+    uint64_t n_allocs = { 0 };
+
+    /// Number of allocations larger than a slab, served by cThread::getMem() directly
+    uint64_t n_large_allocs = { 0 };
+
+    /// Internal fragmentation: fraction of handed-out bytes lost to size-class rounding
+    double internalFragmentation() const { return total_allocated ? 1.0 - (double) total_requested / total_allocated : 0.0; }
+
+    /// External fragmentation: fraction of the slab bytes that are currently free (in the arena or in thread caches)
+    double externalFragmentation() const { return slab_bytes ? 1.0 - (double) (in_use - large_bytes) / slab_bytes : 0.0; }
+};
+
+/**
+ * @brief Size-classed memory allocator for buffers used by a cThread
+ *
+ * cThread::getMem() does an mmap and maps the buffer to the vFPGA TLB (IOCTL_MAP_USER_MEM) on every call,
+ * and freeMem() undoes both, which is too expensive for per-request buffers. The arena instead obtains large
+ * regions (HPF, falling back to THP) from cThread::getMem() once and carves them into 2MB slabs,
+ * each serving blocks of one power-of-two size class (64B to 2MB). Allocation and release then happen in user space only;
+ * each (OS) thread keeps a small cache per size class, so that the arena lock is only taken to refill or drain a cache.
+ * Allocations larger than a slab are passed through to cThread::getMem()/freeMem().
+ *
+ * @note The arena must be destroyed before the cThread it allocates from; all blocks are released with it
+ * @note Regions are obtained from the cThread under the arena lock; the arena should be the only user of the cThread's getMem()/freeMem() while it grows
+ */
+class cMemArena {
+
+private:
+    struct arenaState;
+    std::shared_ptr<arenaState> state;
+
+    friend struct threadCache;
+
+public:
+    /**
+     * @brief Creates an arena on top of a cThread; no memory is obtained until the first allocation
+     *
+     * @param thread cThread the memory is obtained from and mapped to
+     * @param type Type of the regions, HPF or THP; HPF falls back to THP if no hugepages are available
+     * @param region_size Size of each region, rounded up to a multiple of the huge page size
+     * @param max_regions Maximum number of regions; allocations fail (return nullptr) once exhausted
+     */
+    cMemArena(cThread *thread, CoyoteAllocType type = CoyoteAllocType::HPF, uint32_t region_size = ARENA_REGION_SIZE, uint32_t max_regions = ARENA_MAX_REGIONS);
+
+    /// Releases all regions back to the cThread
+    ~cMemArena();
+
+    cMemArena(const cMemArena&) = delete;
+    cMemArena& operator=(const cMemArena&) = delete;
+
+    /**
+     * @brief Allocates a buffer which is already mapped to the vFPGA
+     *
+     * @param size Size of the buffer, in bytes
+     * @return Pointer to the buffer, aligned to its (power-of-two) size class; nullptr if size is 0 or the arena is exhausted
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Returns a buffer to the arena; the memory stays mapped to the vFPGA
+     *
+     * @param ptr Buffer obtained from allocate(...); nullptr is ignored
+     */
+    void free(void *ptr);
+
+    /// Returns true if the pointer was allocated from a slab of this arena
+    bool owns(const void *ptr) const;
+
+    /// Returns all blocks cached by the calling thread to the arena
+    void flushThreadCache();
+
+    /// Getter: arena statistics
+    arenaStats getStats() const;
+};
+
+}
+
+#endif // _COYOTE_CMEMARENA_HPP_
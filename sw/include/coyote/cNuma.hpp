@@ -0,0 +1,83 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CNUMA_HPP_
+#define _COYOTE_CNUMA_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <pthread.h>
+
+namespace coyote {
+
+/*
+ * NUMA utilities, used by cThread to place host buffers and helper threads on the FPGA's NUMA node
+ * Implemented on top of sysfs and the raw mbind / sched_setaffinity system calls, so that no dependency on libnuma is required
+ */
+
+/**
+ * @brief Returns the NUMA node the FPGA is attached to, as reported by the kernel for its PCI device
+ *
+ * The driver assigns device IDs in probe order, i.e., in PCI address order of the devices bound to it.
+ * @param device Coyote device ID, as passed to the cThread constructor
+ * @return NUMA node of the device, or -1 if it cannot be determined (no such device, non-NUMA host, simulation etc.)
+ */
+int32_t getDeviceNumaNode(uint32_t device);
+
+/**
+ * @brief Returns the CPUs of a NUMA node
+ * @param node NUMA node
+ * @return CPU IDs, empty if the node does not exist
+ */
+std::vector<int> getNodeCpus(int32_t node);
+
+/**
+ * @brief Sets a preferred NUMA node for a memory range, moving any pages already allocated elsewhere
+ *
+ * Must be called before the pages are touched (e.g., before they are pinned by the driver) to take full effect.
+ * The policy is a preference, so allocations fall back to other nodes if the node is out of (huge) pages.
+ * @param mem Start of the range; rounded down to the page boundary
+ * @param size Size of the range, in bytes
+ * @param node NUMA node
+ * @return true on success
+ */
+bool bindMemToNode(void *mem, uint64_t size, int32_t node);
+
+/**
+ * @brief Restricts a thread to the given CPUs
+ *
+ * Example, pinning the calling thread next to the FPGA:
+ *     setThreadAffinity(pthread_self(), getNodeCpus(thread->getNumaNode()));
+ *
+ * @param thread Native handle of the thread, e.g., std::thread::native_handle() or pthread_self()
+ * @param cpus CPU IDs; if empty, the call has no effect
+ * @return true on success
+ */
+bool setThreadAffinity(pthread_t thread, const std::vector<int> &cpus);
+
+}
+
+#endif // _COYOTE_CNUMA_HPP_
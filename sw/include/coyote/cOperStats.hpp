@@ -0,0 +1,220 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_COPERSTATS_HPP_
+#define _COYOTE_COPERSTATS_HPP_
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include <coyote/cDefs.hpp>
+#include <coyote/cOps.hpp>
+
+namespace coyote {
+
+/// Number of CoyoteOper values, i.e., number of per-operation histograms
+constexpr int32_t N_OPERS = static_cast<int32_t>(CoyoteOper::REMOTE_TCP_SEND) + 1;
+
+/// Printable name of an operation, e.g., for the operation statistics
+inline const char* operName(CoyoteOper oper) {
+    switch (oper) {
+        case CoyoteOper::NOOP: return "NOOP";
+        case CoyoteOper::LOCAL_READ: return "LOCAL_READ";
+        case CoyoteOper::LOCAL_WRITE: return "LOCAL_WRITE";
+        case CoyoteOper::LOCAL_TRANSFER: return "LOCAL_TRANSFER";
+        case CoyoteOper::LOCAL_OFFLOAD: return "LOCAL_OFFLOAD";
+        case CoyoteOper::LOCAL_SYNC: return "LOCAL_SYNC";
+        case CoyoteOper::REMOTE_RDMA_READ: return "REMOTE_RDMA_READ";
+        case CoyoteOper::REMOTE_RDMA_WRITE: return "REMOTE_RDMA_WRITE";
+        case CoyoteOper::REMOTE_RDMA_SEND: return "REMOTE_RDMA_SEND";
+        case CoyoteOper::REMOTE_TCP_SEND: return "REMOTE_TCP_SEND";
+        default: return "UNKNOWN";
+    }
+}
+
+/// @brief Latency and throughput summary of one operation type, see cThread::getOperStats()
+struct operStats {
+    /// Operation
+    CoyoteOper oper = { CoyoteOper::NOOP };
+
+    /// Number of completed operations
+    uint64_t count = { 0 };
+
+    /// Number of bytes moved by the completed operations
+    uint64_t bytes = { 0 };
+
+    /// Operations that were not timed, since too many were outstanding at once
+    uint64_t dropped = { 0 };
+
+    /// Mean submit-to-completion latency, in us
+    double mean_us = { 0.0 };
+
+    /// Median latency, in us
+    double p50_us = { 0.0 };
+
+    /// 99th percentile latency, in us
+    double p99_us = { 0.0 };
+
+    /// 99.9th percentile latency, in us
+    double p999_us = { 0.0 };
+
+    /// Maximum latency, in us
+    double max_us = { 0.0 };
+
+    /// Bytes moved over the time from the first submission to the last completion, in GB/s
+    double throughput_gbps = { 0.0 };
+};
+
+/**
+ * @brief Lock-free log-linear latency histogram
+ *
+ * Values (in TSC cycles) below 2^HIST_SUB_BITS have their own bin; larger values are binned by their power of two, 
+ * which is further split into 2^HIST_SUB_BITS linear bins, bounding the relative error to 1 / 2^HIST_SUB_BITS.
+ */
+class cLatencyHistogram {
+
+public:
+    /// Linear sub-bins per power of two (as a power of two)
+    static constexpr uint32_t HIST_SUB_BITS = 4;
+
+    /// Largest binned value, as a power of two; larger values are clamped (2^44 cycles are more than an hour)
+    static constexpr uint32_t HIST_MAX_BITS = 44;
+
+    /// Number of bins
+    static constexpr uint32_t HIST_BINS = (HIST_MAX_BITS - HIST_SUB_BITS + 1) << HIST_SUB_BITS;
+
+    /// Adds a value
+    void record(uint64_t cycles);
+
+    /// Returns the (approximate) value at quantile q, in cycles
+    uint64_t quantile(double q) const;
+
+    /// Returns the number of values
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+
+    /// Returns the sum of all the values, in cycles
+    uint64_t getSum() const { return sum.load(std::memory_order_relaxed); }
+
+    /// Returns the maximum value, in cycles
+    uint64_t getMax() const { return max.load(std::memory_order_relaxed); }
+
+    /// Clears the histogram
+    void reset();
+
+private:
+    std::atomic<uint64_t> bins[HIST_BINS] = {};
+    std::atomic<uint64_t> count = { 0 };
+    std::atomic<uint64_t> sum = { 0 };
+    std::atomic<uint64_t> max = { 0 };
+
+    static uint32_t binIndex(uint64_t cycles);
+    static uint64_t binValue(uint32_t idx);
+};
+
+/**
+ * @brief Per-cThread submit-to-completion latency instrumentation, enabled with EN_OPER_STATS
+ *
+ * cThread timestamps (rdtsc) each operation with a completion sequence number when it is invoked, and pushes it 
+ * to a small ring per writeback counter. Whenever the counter is read (checkCompleted() and everything built on it),
+ * all operations up to the read value are popped from the ring and their latency is added to the histogram of their
+ * operation type. The latency is therefore observed, i.e., it includes the time until the application polled.
+ *
+ * Submission is single-producer (the thread invoking operations, as for cThread itself); completions can be
+ * observed from any thread (e.g., a cCompletionQueue poller), without locks.
+ */
+class cOperStats {
+
+public:
+    /// Number of outstanding timed operations per writeback counter; further ones are counted as dropped
+    static constexpr uint32_t RING_SIZE = 256;
+
+    /**
+     * @brief Records an issued operation; called by cThread after the command(s) were written
+     *
+     * Operations issued with last = false are accumulated (bytes, and the time of the first one) into the next one with last = true
+     * @param oper Operation
+     * @param seq Completion sequence number
+     * @param last Whether the operation increments the completion counter
+     * @param bytes Number of bytes moved by the operation
+     */
+    void submit(CoyoteOper oper, uint32_t seq, bool last, uint64_t bytes);
+
+    /**
+     * @brief Records the completion of all the operations up to a counter value
+     * @param idx Writeback counter index (RD_WBACK, WR_WBACK etc.)
+     * @param completed Counter value just read
+     */
+    void observe(int32_t idx, uint32_t completed);
+
+    /// Returns a summary of all the operation types with at least one completed operation
+    std::vector<operStats> snapshot() const;
+
+    /// Clears the histograms; operations in flight are still timed
+    void reset();
+
+    /// Drops all operations in flight without timing them; called when the completion counters are cleared
+    void discardInFlight();
+
+    /// TSC frequency, calibrated on first use, in cycles per ns
+    static double tscPerNs();
+
+private:
+    /// An operation in flight
+    struct ringEntry {
+        std::atomic<uint64_t> tsc = { 0 };
+        std::atomic<uint64_t> bytes = { 0 };
+        std::atomic<uint32_t> seq = { 0 };
+        std::atomic<int32_t> oper = { 0 };
+    };
+
+    /// Single-producer, multi-consumer ring of the operations in flight on one writeback counter
+    struct opRing {
+        ringEntry entries[RING_SIZE];
+        std::atomic<uint64_t> head = { 0 };
+        std::atomic<uint64_t> tail = { 0 };
+
+        /// Producer-only: time and bytes of the operations issued with last = false since the last one with last = true
+        uint64_t pending_tsc = { 0 };
+        uint64_t pending_bytes = { 0 };
+    };
+
+    /// Per-operation counters, besides the histogram
+    struct operCounters {
+        cLatencyHistogram hist;
+        std::atomic<uint64_t> bytes = { 0 };
+        std::atomic<uint64_t> dropped = { 0 };
+        std::atomic<uint64_t> first_tsc = { 0 };
+        std::atomic<uint64_t> last_tsc = { 0 };
+    };
+
+    opRing rings[N_WBACKS];
+    operCounters opers[N_OPERS];
+};
+
+}
+
+#endif // _COYOTE_COPERSTATS_HPP_
@@ -27,6 +27,10 @@
 #ifndef _COYOTE_COPS_HPP_
 #define _COYOTE_COPS_HPP_
 
+#include <vector>
+#include <utility>
+#include <algorithm>
+
 #include <coyote/cDefs.hpp>
 
 namespace coyote {
@@ -90,6 +94,11 @@ inline constexpr bool isRemoteWriteOrSend(CoyoteOper oper) { return oper == Coyo
 
 inline constexpr bool isRemoteTcp(CoyoteOper oper) { return oper == CoyoteOper::REMOTE_TCP_SEND; }
 
+/// Index of the writeback (completion) counter incremented by an operation, in the same order as checked by cThread::checkCompleted(); -1 if there is none
+inline constexpr int32_t getWbackIndex(CoyoteOper oper) { 
+    return isLocalWrite(oper) ? WR_WBACK : isLocalRead(oper) ? RD_WBACK : isRemoteRead(oper) ? RD_RDMA_WBACK : isRemoteWriteOrSend(oper) ? WR_RDMA_WBACK : -1; 
+}
+
 ///////////////////////////////////////////////////
 //                 COYOTE MEMORY                //
 //////////////////////////////////////////////////
@@ -131,6 +140,12 @@ struct CoyoteAlloc {
 
     /// Pointer to the allocated memory; the struct keeps track of it so that it can be freed automatically after use
     void *mem = { nullptr };
+
+    /**
+     * Populate the buffer on allocation (REG, THP and HPF only): all pages are faulted in (THP buffers are also advised to use huge pages) 
+     * before the buffer is mapped to the vFPGA, so that the first transfer doesn't stall on page faults handled by the driver
+     */
+    bool populate = { false };
 };
 
 ///////////////////////////////////////////////////
@@ -166,6 +181,48 @@ struct localSg {
     uint32_t dest = { 0 };
 };
 
+/**
+ * @brief Scatter-gather list for local operations (LOCAL_READ, LOCAL_WRITE, LOCAL_TRANSFER)
+ *
+ * Describes a buffer made of several segments and/or longer than MAX_TRANSFER_SIZE, which cThread::invoke(...)
+ * splits into descriptors of at most MAX_TRANSFER_SIZE bytes; the whole list completes as a single operation.
+ */
+struct localSgList {
+    /// Segments, as (address, length in bytes) pairs, in transfer order
+    std::vector<std::pair<void*, uint64_t>> segs;
+
+    /// Buffer stream: HOST or CARD
+    uint32_t stream = { STRM_HOST };
+
+    /// Target AXI4 destination stream in the vFPGA; a value of i will use the to axis_(host|card)_(recv|send)[i] in the vFPGA
+    uint32_t dest = { 0 };
+
+    /// Total length of all the segments, in bytes
+    uint64_t totalLen() const {
+        uint64_t len = 0;
+        for (const auto &seg : segs) {
+            len += seg.second;
+        }
+        return len;
+    }
+
+    /// Splits the list into descriptors of at most max_len bytes, skipping empty segments
+    std::vector<localSg> chunks(uint64_t max_len = MAX_TRANSFER_SIZE) const {
+        std::vector<localSg> out;
+        for (const auto &seg : segs) {
+            for (uint64_t offs = 0; offs < seg.second; offs += max_len) {
+                localSg sg;
+                sg.addr = static_cast<char*>(seg.first) + offs;
+                sg.len = static_cast<uint32_t>(std::min(max_len, seg.second - offs));
+                sg.stream = stream;
+                sg.dest = dest;
+                out.push_back(sg);
+            }
+        }
+        return out;
+    }
+};
+
 /** 
  * @brief Scatter-gather entry for RDMA operations (REMOTE_READ, REMOTE_WRITE)
  * NOTE: No field for source/dest address, since these are defined when exchanging queue pair information
@@ -28,13 +28,22 @@
 #define _COYOTE_CRCNFG_HPP_
 
 #include <atomic>
+#include <algorithm>
+#include <vector>
+#include <cstring>
 #include <fcntl.h> 
+#include <endian.h>
 #include <fstream>
 #include <unistd.h> 
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unordered_map> 
 #include <boost/interprocess/sync/named_mutex.hpp>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 #include <coyote/cOps.hpp>
 #include <coyote/cDefs.hpp>
 
@@ -92,11 +101,22 @@ protected:
 	/**
 	 * @brief Read bitstream from a file stream, that can be used for reconfiguration
 	 * 
-	 * @param fb File input stream, corresponding to a .bin file (most likely shell_top.bin)
+	 * @param fb File input stream, corresponding to a .bin file (most likely shell_top.bin), positioned at its end (std::ios::ate)
 	 * @return bitstream, an in-memory object of type bitstream with virtual address and length
 	 */
 	bitstream_t readBitstream(std::ifstream& fb);
 
+	/**
+	 * @brief Read bitstream from a file, that can be used for reconfiguration
+	 *
+	 * The file is memory mapped and converted to the word order expected by the FPGA directly into the bitstream memory,
+	 * one hugepage at a time, while the kernel reads ahead the next one. Faster than the stream variant for large bitstreams.
+	 * 
+	 * @param bitstream_path Path to the .bin file
+	 * @return bitstream, an in-memory object of type bitstream with virtual address and length
+	 */
+	bitstream_t readBitstream(const std::string &bitstream_path);
+
 	/**
 	 * @brief Base reconfiguration function, can be used to reconfigure the whole shell or individual vFPGAs
 	 * 
@@ -105,6 +125,12 @@ protected:
 	 */
     void reconfigureBase(bitstream_t bitstream, uint32_t vfid = -1);
 
+	/**
+	 * @brief Checks whether the shell supports partial reconfiguration of the vFPGAs (app bitstreams)
+	 * @return true if enabled; always true for the software vFPGA, where reconfiguration is a no-op
+	 */
+	bool isPrEnabled();
+
 	/**
 	 * @brief Allocates a buffer for storing partial bitstream
 	 * @param alloc Allocation parameters; most importantly number of pages for the buffer
@@ -113,7 +139,7 @@ protected:
 
 	/**
 	 * @brief Releases dynamically allocated memory (allocated using the above function)
-	 * Similar to the standard C/C++ free() function
+	 * Similar to the standard C/C++ free() function; can also be used to release a bitstream obtained from readBitstream
 	 * 
 	 * @param vaddr corresponding to the buffer to be freed 
 	 */
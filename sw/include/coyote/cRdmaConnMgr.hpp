@@ -0,0 +1,176 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CRDMACONNMGR_HPP_
+#define _COYOTE_CRDMACONNMGR_HPP_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unistd.h>
+
+#include <coyote/cDefs.hpp>
+#include <coyote/cOps.hpp>
+#include <coyote/cThread.hpp>
+
+namespace coyote {
+
+/// @brief A remote node to set up RDMA queue pairs with, see cRdmaConnMgr::addPeer()
+struct rdmaPeer {
+    /// Name of the peer; its QPs are exposed as connections "<name>/0" ... "<name>/<n_qps - 1>", and "<name>" for the first one
+    std::string name;
+
+    /// Address of the remote node; if empty, this node accepts the out-of-band connection from the peer instead
+    std::string address;
+
+    /// Out-of-band TCP port; ports of accepted peers must be unique
+    uint16_t port = { 0 };
+
+    /// Number of QPs to the peer; must match on both sides
+    uint32_t n_qps = { 1 };
+
+    /// Size of the RDMA buffer allocated for each QP, in bytes
+    uint32_t buffer_size = { 0 };
+};
+
+/**
+ * @brief Sets up many RDMA queue pairs to many peers in parallel, and addresses them by connection name
+ *
+ * In Coyote, each QP belongs to exactly one cThread (its QPN is derived from the vFPGA ID and the ctid), so the manager
+ * creates one cThread per QP. Compared to calling cThread::initRDMA() for every QP, connect():
+ *   - exchanges the QP contexts of all the QPs to a peer in a single out-of-band message,
+ *   - talks to all the peers concurrently (one set-up thread per peer), retrying until the peer is listening,
+ *   - issues one ARP lookup per remote node, concurrently for all nodes.
+ * Operations are then issued with rdmaSgConn, whose connection field names the QP.
+ *
+ * Example (node "amy", talking to "rose" with 4 QPs):
+ *     cRdmaConnMgr mgr(0);
+ *     mgr.addPeer({"rose", "10.1.212.171", 18488, 4, 1 << 20});
+ *     mgr.connect();
+ *     rdmaSgConn sg = { .connection = "rose/2", .len = 4096 };
+ *     uint32_t seq = mgr.invoke(CoyoteOper::REMOTE_RDMA_WRITE, sg);
+ *     mgr.getThread("rose/2")->waitCompleted(CoyoteOper::REMOTE_RDMA_WRITE, seq);
+ */
+class cRdmaConnMgr {
+
+private:
+    /// A configured peer, with its QPs (cThreads) and out-of-band socket
+    struct peerState {
+        rdmaPeer cnfg;
+        std::vector<std::unique_ptr<cThread>> threads;
+        std::vector<void*> buffers;
+        int connfd = { -1 };
+        int listenfd = { -1 };
+    };
+
+    /// vFPGA ID all the QPs are created on
+    int32_t vfid;
+
+    /// FPGA device ID
+    uint32_t device;
+
+    /// Host process ID the cThreads are registered with
+    pid_t hpid;
+
+    /// Configured peers, in the order they were added
+    std::vector<std::unique_ptr<peerState>> peers;
+
+    /// Connection name to (peer, QP index)
+    std::map<std::string, std::pair<peerState*, uint32_t>> connections;
+
+    /// Set once connect() succeeded
+    bool connected = { false };
+
+    /// Time a client keeps retrying to reach a peer that isn't listening yet, in ms
+    uint32_t connect_timeout_ms;
+
+    /// Out-of-band exchange with one peer; runs on a dedicated thread
+    void exchange(peerState &peer);
+
+    /// Looks up a connection name
+    std::pair<peerState*, uint32_t> lookup(const std::string &connection) const;
+
+public:
+    /**
+     * @brief Constructs a connection manager; no QPs are created until connect()
+     *
+     * @param vfid vFPGA ID the QPs are created on
+     * @param device FPGA device ID
+     * @param hpid Host process ID
+     * @param connect_timeout_ms Time to retry reaching a peer that isn't listening yet, in ms
+     */
+    cRdmaConnMgr(int32_t vfid, uint32_t device = 0, pid_t hpid = getpid(), uint32_t connect_timeout_ms = 30000);
+
+    /// Default destructor; closes the out-of-band connections and releases the QPs
+    ~cRdmaConnMgr();
+
+    cRdmaConnMgr(const cRdmaConnMgr&) = delete;
+    cRdmaConnMgr& operator=(const cRdmaConnMgr&) = delete;
+
+    /**
+     * @brief Adds a peer; must be called before connect()
+     * @param peer Peer configuration
+     * @throws std::runtime_error on duplicate names or ports of accepted peers, or if already connected
+     */
+    void addPeer(const rdmaPeer &peer);
+
+    /**
+     * @brief Creates all the QPs and connects them to all the peers
+     * @throws std::runtime_error if any peer could not be connected; the exception of the first failing peer is rethrown
+     */
+    void connect();
+
+    /**
+     * @brief Issues an RDMA operation on a named connection
+     *
+     * @param oper REMOTE_RDMA_READ, REMOTE_RDMA_WRITE or REMOTE_RDMA_SEND
+     * @param sg Scatter-gather entry; sg.connection selects the QP
+     * @param last Whether this is the last operation in a sequence, see cThread::invoke(...)
+     * @return Completion sequence number, to be checked on getThread(sg.connection)
+     */
+    uint32_t invoke(CoyoteOper oper, const rdmaSgConn &sg, bool last = true);
+
+    /// Returns the cThread (QP) of a connection, e.g., to check completions
+    cThread* getThread(const std::string &connection) const;
+
+    /// Returns the RDMA buffer of a connection
+    void* getBuffer(const std::string &connection) const;
+
+    /// Returns the names of all the connections ("<peer>/<i>"; "<peer>" aliases are not included)
+    std::vector<std::string> getConnections() const;
+
+    /**
+     * @brief Barrier with a peer over its out-of-band connection
+     * @param peer Peer name
+     */
+    void sync(const std::string &peer);
+};
+
+}
+
+#endif // _COYOTE_CRDMACONNMGR_HPP_
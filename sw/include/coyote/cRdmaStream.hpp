@@ -0,0 +1,228 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CRDMASTREAM_HPP_
+#define _COYOTE_CRDMASTREAM_HPP_
+
+#include <cstdint>
+
+#include <coyote/cDefs.hpp>
+#include <coyote/cOps.hpp>
+#include <coyote/cWait.hpp>
+#include <coyote/cThread.hpp>
+
+namespace coyote {
+
+/// @brief Configuration of a cRdmaStream; both ends of a stream must use the same configuration
+struct rdmaStreamCfg {
+    /// Maximum number of outstanding (issued, but not yet completed) operations on the QP
+    uint32_t window = { 16 };
+
+    /// Size of a receive slot in the remote RDMA buffer, in bytes
+    uint32_t slot_size = { 4096 };
+
+    /// Number of receive slots in the remote RDMA buffer; 0 disables the credit-based flow control
+    uint32_t n_slots = { 0 };
+
+    /// Offset of the first receive slot in the RDMA buffer
+    uint64_t ring_offs = { 0 };
+
+    /// Offset of the 64-bit credit word in the RDMA buffer; must not overlap with the receive slots
+    uint64_t credit_offs = { 0 };
+
+    /// The receiver returns credits to the sender once this many slots have been released
+    uint32_t credit_batch = { 1 };
+};
+
+/// @brief Counters of a cRdmaStream
+struct rdmaStreamStats {
+    /// Number of operations posted
+    uint64_t n_posted = { 0 };
+
+    /// Number of times post(...) had to wait, because the window was full
+    uint64_t window_stalls = { 0 };
+
+    /// Number of times post(...) had to wait for credits from the receiver
+    uint64_t credit_stalls = { 0 };
+
+    /// Number of messages received (receiver only)
+    uint64_t n_received = { 0 };
+
+    /// Number of credit updates sent to the sender (receiver only)
+    uint64_t credit_updates = { 0 };
+};
+
+/**
+ * @brief Streams RDMA operations over a single QP with a window of outstanding operations and credit-based flow control
+ *
+ * Waiting on checkCompleted() after every invoke(...) leaves the QP idle for a full round-trip per message, so that
+ * small messages never get close to line rate. post(...) instead only waits when the window of outstanding operations is
+ * full; completions are retired in bulk, by reading the RDMA writeback counter (RD_RDMA_WBACK / WR_RDMA_WBACK) once.
+ *
+ * With rdmaStreamCfg::n_slots set, WRITEs and SENDs are placed in a ring of receive slots in the remote buffer; every 
+ * message takes one slot, i.e., one credit. The receiving end of the stream counts the incoming messages (LOCAL_WRITE 
+ * completions), and returns credits with a small RDMA WRITE of its release counter to the sender's credit word,
+ * once the application has released the slots. The sender stalls when it runs out of credits, so it never overwrites
+ * a slot that hasn't been consumed yet.
+ *
+ * Example:
+ *     // Sender                                          // Receiver
+ *     cRdmaStream tx(&thread, cfg);                      cRdmaStream rx(&thread, cfg);
+ *     thread.connSync(true);                             thread.connSync(false);
+ *     for (int i = 0; i < n; i++)                        for (uint64_t i = 0; i < n; i++) {
+ *         tx.post({ .local_offs = off, .len = 64 });         while (!rx.receive()) {}
+ *     tx.flush();                                            process(rx.getSlot(i), ...); rx.release(1);
+ *                                                        }
+ *
+ * @note A stream assumes it is the only user of the writeback counter of its operation on the cThread (and, on the
+ *       receiving end, of the LOCAL_WRITE counter); both ends must be constructed before the first connSync()
+ * @note Posted data must not be modified before the operation completed, i.e., before poll() or flush() retired it
+ * @note Waits follow the wait policy of the cThread, see cThread::setWaitPolicy()
+ */
+class cRdmaStream {
+
+private:
+    /// cThread owning the QP
+    cThread *thread;
+
+    /// Streamed operation
+    CoyoteOper oper;
+
+    /// Configuration
+    rdmaStreamCfg cfg;
+
+    /// Whether posted messages take receive slots (credit-based flow control)
+    bool credits_en;
+
+    /// Completion sequence number of the last issued operation (or, on the receiving end, credit update)
+    uint32_t issued_seq;
+
+    /// Last read value of the writeback counter
+    uint32_t completed_seq;
+
+    /// Value of the LOCAL_WRITE counter when the receiver was (re)started
+    uint32_t recv_base;
+
+    /// Number of messages released by the receiving application
+    uint64_t n_released;
+
+    /// Number of released messages, for which credits were returned to the sender
+    uint64_t n_returned;
+
+    /// Counters
+    rdmaStreamStats stats;
+
+    /// Wait phase counters
+    waitStats wait_stats;
+
+    /// Credit word in the local RDMA buffer; written by the remote end
+    volatile uint64_t* creditWord() const;
+
+    /// Sends the release counter to the credit word of the sender
+    void returnCredits();
+
+public:
+    /**
+     * @brief Constructs a stream over the QP of a cThread
+     *
+     * @param thread cThread, with the RDMA connection already set up (e.g., initRDMA())
+     * @param cfg Stream configuration
+     * @param oper Streamed operation; REMOTE_RDMA_WRITE, REMOTE_RDMA_SEND or REMOTE_RDMA_READ (windowing only)
+     * @throws std::runtime_error if the cThread has no QP, or the slots and the credit word don't fit into the RDMA buffer
+     */
+    cRdmaStream(cThread *thread, rdmaStreamCfg cfg, CoyoteOper oper = CoyoteOper::REMOTE_RDMA_WRITE);
+
+    cRdmaStream(const cRdmaStream&) = delete;
+    cRdmaStream& operator=(const cRdmaStream&) = delete;
+
+    /**
+     * @brief Posts an operation, waiting only if the window is full or there are no credits left
+     *
+     * @param sg RDMA scatter-gather entry; with credits enabled, remote_offs is an offset within the next receive slot
+     * @return Completion sequence number of the operation, see cThread::invoke(...)
+     * @throws std::runtime_error if the message doesn't fit into a receive slot
+     */
+    uint32_t post(rdmaSg sg);
+
+    /**
+     * @brief Retires the completed operations with a single writeback counter read
+     * @return Number of operations still outstanding
+     */
+    uint32_t poll();
+
+    /**
+     * @brief Blocks until all posted operations have completed
+     *
+     * On the receiving end, waits for the credit updates instead; call it before reset(), so that a late credit update
+     * cannot overwrite the sender's freshly cleared credit word
+     */
+    void flush();
+
+    /// Number of credits (free remote receive slots) currently available to the sender
+    uint32_t getCredits() const;
+
+    /// Number of outstanding operations, as of the last poll()
+    uint32_t getOutstanding() const;
+
+    /**
+     * @brief Receiver: checks for new messages
+     * @return Number of received messages that haven't been released yet
+     */
+    uint32_t receive();
+
+    /**
+     * @brief Receiver: returns a pointer to the receive slot of the i-th message of the stream
+     * @param i Index of the message, counted from the (re)start of the stream
+     */
+    void* getSlot(uint64_t i) const;
+
+    /**
+     * @brief Receiver: releases the oldest received messages, so that their slots can be reused by the sender
+     *
+     * Credits are returned to the sender once rdmaStreamCfg::credit_batch slots have been released.
+     * @param n Number of messages to release
+     * @throws std::runtime_error if more messages are released than were received
+     */
+    void release(uint32_t n);
+
+    /**
+     * @brief Restarts the stream, e.g., after cThread::clearCompleted(); clears the local credit word
+     *
+     * The receiver should flush() and reset() before synchronizing with the sender (connSync()), and the sender reset()
+     * after it, so that no credit update of the previous round can still land in the sender's credit word
+     */
+    void reset();
+
+    /// Getter: stream counters
+    rdmaStreamStats getStats() const;
+
+    /// Getter: counters of how often each wait phase was hit
+    waitStats getWaitStats() const;
+};
+
+}
+
+#endif // _COYOTE_CRDMASTREAM_HPP_
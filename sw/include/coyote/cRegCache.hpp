@@ -0,0 +1,159 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CREGCACHE_HPP_
+#define _COYOTE_CREGCACHE_HPP_
+
+#include <map>
+#include <list>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace coyote {
+
+/// @brief Registration cache statistics
+struct regCacheStats {
+    /// userMap() calls served from the cache, without a driver call
+    uint64_t hits = { 0 };
+
+    /// userMap() calls that had to map the buffer in the driver
+    uint64_t misses = { 0 };
+
+    /// Unused registrations that were unmapped to stay within the budget
+    uint64_t evictions = { 0 };
+
+    /// Bytes currently mapped (pinned) through the cache, including unused registrations
+    uint64_t pinned_bytes = { 0 };
+
+    /// Number of cached registrations
+    uint32_t n_entries = { 0 };
+
+    /// Number of cached registrations with no active user, which are unmapped lazily
+    uint32_t n_unused = { 0 };
+};
+
+/**
+ * @brief User-space cache of buffer registrations (userMap) with the driver
+ *
+ * Mapping a buffer pins its pages and programs the vFPGA TLB, so applications that map the same buffer
+ * around every transfer pay for both every time. The cache keeps registrations, keyed by their virtual address interval,
+ * after the last user released them and serves later mappings of (sub-)ranges from the cache. Unused registrations are
+ * unmapped in least-recently-used order once the pinned memory exceeds the budget.
+ *
+ * The cache only does the bookkeeping; cThread performs the actual driver calls for the addresses returned by
+ * evict(), invalidate() and flush().
+ */
+class cRegCache {
+
+private:
+    struct regEntry {
+        /// Length of the registered range, in bytes
+        uint64_t len;
+
+        /// Number of active users
+        uint32_t refcnt;
+
+        /// Position in the LRU list, valid only when refcnt == 0
+        std::list<uint64_t>::iterator lru_it;
+    };
+
+    /// Registrations, keyed by start address
+    std::map<uint64_t, regEntry> entries;
+
+    /// Unused registrations, least-recently used first
+    std::list<uint64_t> lru;
+
+    /// Length of the longest registration; bounds the backwards search for a covering range
+    uint64_t max_len = { 0 };
+
+    /// Pinned memory budget, in bytes; 0 disables the cache
+    uint64_t budget = { 0 };
+
+    regCacheStats stats;
+
+    /// Returns the registration covering [vaddr, vaddr + len), preferring the closest start address; entries.end() if none
+    std::map<uint64_t, regEntry>::iterator findCovering(uint64_t vaddr, uint64_t len, bool in_use_only);
+
+public:
+    /// Sets the pinned memory budget, in bytes; 0 disables the cache
+    void setBudget(uint64_t bytes) { budget = bytes; }
+
+    /// Getter: pinned memory budget
+    uint64_t getBudget() const { return budget; }
+
+    /// Returns true if caching is enabled
+    bool isEnabled() const { return budget > 0; }
+
+    /**
+     * @brief Looks up a registration covering the range and, if found, acquires it
+     * @return True on a hit; on a miss, the caller maps the buffer and calls insert(...)
+     */
+    bool acquire(uint64_t vaddr, uint64_t len);
+
+    /**
+     * @brief Removes the unused registration starting at vaddr, if any; e.g., before a longer range is mapped at the same address
+     *
+     * The driver doesn't extend an existing mapping (it only maps the pages not already mapped), 
+     * so a registration must be unmapped for a longer range at the same address to be pinned.
+     * 
+     * @return True if the registration was removed, in which case the caller unmaps it
+     */
+    bool remove(uint64_t vaddr);
+
+    /**
+     * @brief Adds a freshly mapped range, with one active user
+     *
+     * If a registration, still in use, already starts at vaddr (i.e., a longer range was re-mapped), it is acquired instead; 
+     * its length is unchanged, since the driver doesn't extend it (see remove(...))
+     */
+    void insert(uint64_t vaddr, uint64_t len);
+
+    /**
+     * @brief Releases one user of the registration covering vaddr; the registration stays mapped
+     * @return False if no registration covers vaddr, in which case the caller unmaps it directly
+     */
+    bool release(uint64_t vaddr);
+
+    /// Removes unused registrations, least-recently used first, until the pinned memory is within the budget; returns their start addresses
+    std::vector<uint64_t> evict();
+
+    /// Removes all registrations overlapping [vaddr, vaddr + len), used or not (e.g., before the memory is freed); returns their start addresses
+    std::vector<uint64_t> invalidate(uint64_t vaddr, uint64_t len);
+
+    /// Removes all unused registrations; returns their start addresses
+    std::vector<uint64_t> flush();
+
+    /// Removes all registrations; returns their start addresses
+    std::vector<uint64_t> clear();
+
+    /// Getter: cache statistics
+    regCacheStats getStats() const { return stats; }
+};
+
+}
+
+#endif // _COYOTE_CREGCACHE_HPP_
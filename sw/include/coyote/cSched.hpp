@@ -28,11 +28,18 @@
 #define _COYOTE_CSCHED_HPP_
 
 #include <map>
+#include <list>
+#include <deque>
 #include <mutex>
 #include <vector>
 #include <fstream>
 #include <cstdint>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
 #include <syslog.h>
+#include <sys/eventfd.h>
 
 #include <coyote/bFunc.hpp>
 #include <coyote/cTask.hpp>
@@ -40,6 +47,74 @@
 
 namespace coyote {
 
+/**
+ * @brief Parameters of the reordering (bitstream-affinity) scheduling policy
+ *
+ * Tasks are queued per bitstream. The next task is taken from the queue whose oldest task has the highest priority,
+ * where the priority is the time the task has waited, plus a bonus for the currently loaded bitstream, equal to the 
+ * estimated reconfiguration cost scaled by batch_factor. Thus, the loaded bitstream keeps running batches as long as
+ * switching wouldn't pay off, but a task of another bitstream waits at most about batch_factor reconfiguration times
+ * longer than the tasks it is overtaken by. Tasks waiting for longer than max_wait_us always go first, oldest first.
+ */
+struct schedPolicy {
+    /// Initial estimate of the reconfiguration time, in microseconds; refined with the measured times of reconfigurations
+    double rcnfg_cost_us = { 50000 };
+
+    /// Weight of a new measurement in the (exponentially weighted moving average) reconfiguration time estimate; 0 keeps the initial estimate
+    double rcnfg_alpha = { 0.25 };
+
+    /// Priority bonus of the loaded bitstream, in reconfiguration times; the higher, the longer the batches
+    double batch_factor = { 1.0 };
+
+    /// Wait time, in microseconds, after which a task gets priority over the batch of the loaded bitstream
+    double max_wait_us = { 1000000 };
+};
+
+/// @brief Per-function scheduling statistics, see cSched::getFunctionStats()
+struct schedStats {
+    /// Number of queued tasks (current queue depth)
+    uint32_t queued = { 0 };
+
+    /// Number of running tasks
+    uint32_t running = { 0 };
+
+    /// Number of dispatched tasks
+    uint64_t n_dispatched = { 0 };
+
+    /// Number of reconfigurations done to run the function's tasks
+    uint64_t n_rcnfgs = { 0 };
+
+    /// Average time from submission to dispatch, in microseconds
+    double avg_wait_us = { 0 };
+
+    /// Maximum time from submission to dispatch, in microseconds
+    double max_wait_us = { 0 };
+};
+
+/// @brief Bitstream cache statistics, see cSched::getCacheStats()
+struct bitstreamCacheStats {
+    /// Pinned memory held by cached bitstreams, in bytes
+    uint64_t used = { 0 };
+
+    /// Memory budget of the cache, in bytes
+    uint64_t budget = { 0 };
+
+    /// Number of cached (including loading) bitstreams
+    uint32_t n_cached = { 0 };
+
+    /// Number of reconfigurations that found their bitstream in the cache (including ones waiting for an ongoing prefetch)
+    uint64_t n_hits = { 0 };
+
+    /// Number of reconfigurations that had to load their bitstream from disk
+    uint64_t n_misses = { 0 };
+
+    /// Number of bitstreams loaded ahead of their reconfiguration
+    uint64_t n_prefetched = { 0 };
+
+    /// Number of bitstreams evicted to stay within the budget
+    uint64_t n_evictions = { 0 };
+};
+
 /**
  * @brief Coyote run-time scheduler
  *
@@ -50,9 +125,13 @@ namespace coyote {
  * it is possible to write code that interacts directly with the scheduler), which dispatches the tasks 
  * based on a scheduling policy. Where needed, the scheduler will also reconfigure the vFPGA bitstream
  * with the one correct for the function. Currently, there are two scheduling policieies implemented:
- * (1) first-come, first-served (FCFS) and (2) minimize reconfigurations. The second one will always
- * execute all the tasks with the same bitstream, avoiding the latency inccured by partial reconfiguration,
- * before proceeding to the next task with a different bitstream.
+ * (1) first-come, first-served (FCFS) and (2) minimize reconfigurations. The second one batches
+ * the tasks with the same bitstream, avoiding the latency inccured by partial reconfiguration, but
+ * ages the waiting tasks of other bitstreams, so that they cannot starve under steady load; see schedPolicy.
+ *
+ * App bitstreams are loaded into pinned (PRM) memory lazily, on their first reconfiguration, and kept in a cache with
+ * a least-recently-used memory budget (setCacheBudget(...)). While the current tasks run, the bitstream of the next task 
+ * that will require a reconfiguration is prefetched by a background thread, so that reconfigurations don't wait on disk I/O.
  *
  * TODO:
  * - Implement more scheduling policies, such as priority-based scheduling
@@ -81,56 +160,242 @@ private:
     /// A map of the functions loaded to the scheduler, each identified by a unique function ID
     std::map<int32_t, std::unique_ptr<bFunc>> functions;
 
-    /// A list of tasks submitted to the scheduler
-    std::vector<std::unique_ptr<cTask>> tasks;
+    /**
+     * @brief All the tasks submitted to the scheduler and not yet released (queued, running or completed), by task ID
+     *
+     * Completed tasks are kept until their owner collects the result and calls releaseTask(...), 
+     * so that the memory use doesn't grow with the uptime of the scheduler.
+     */
+    std::map<int32_t, std::unique_ptr<cTask>> tasks;
+
+    /// A queued task
+    struct queuedTask {
+        /// Submission time
+        std::chrono::steady_clock::time_point submitted;
+
+        /// Set once the task was picked from the queues, but had to wait for its cThread, busy with another task
+        bool parked;
+    };
+
+    /// Queued tasks, i.e., submitted but not dispatched to a worker yet
+    std::unordered_map<int32_t, queuedTask> queued;
+
+    /// Queued tasks, in order of submission (FCFS only); cancelled tasks are lazily skipped
+    std::deque<int32_t> arrival_queue;
+
+    /// Ready queues of the queued tasks, by bitstream path (reorder only); cancelled tasks are lazily skipped
+    std::map<std::string, std::deque<int32_t>> ready_queues;
+
+    /// Parameters of the reordering policy
+    schedPolicy policy;
+
+    /// Current estimate of the reconfiguration time, in microseconds
+    double rcnfg_cost_us;
 
-    /// A simple map from task ID to its position in the tasks vector; simply used for faster lookups of individual tasks
-    std::map<int32_t, int> task_id_map;
+    /// Scheduling statistics, by function ID
+    std::map<int32_t, schedStats> func_stats;
+
+    /// Number of worker threads, i.e., the maximum number of concurrently running tasks
+    uint32_t n_workers;
+
+    /// Worker threads, executing the dispatched tasks
+    std::vector<std::thread> workers;
+
+    /// Tasks dispatched to the workers, but not picked up yet
+    std::deque<cTask*> run_queue;
+
+    /// Signalled when a task is dispatched to the workers or the scheduler is stopped
+    std::condition_variable wcv;
+
+    /// Number of dispatched, not yet completed tasks
+    uint32_t n_running;
+
+    /// cThreads of the dispatched tasks; a cThread only runs one task at a time
+    std::unordered_set<cThread*> busy_cthreads;
+
+    /// Parked tasks, by cThread, in the order they were picked from the queues
+    std::map<cThread*, std::deque<int32_t>> parked;
+
+    /// Parked tasks whose cThread became free; dispatched before any other task
+    std::deque<int32_t> unparked;
+
+    /// Number of parked (including unparked) tasks
+    uint32_t n_parked;
+
+    /// Running tasks that were released; they are reclaimed as soon as they complete
+    std::unordered_set<int32_t> orphaned;
+
+    /// Event file descriptor, signalled whenever a task completes; -1 until requested through getCompletionFd()
+    int cmpl_fd;
+
+    /// IDs of the completed tasks not yet collected through takeCompleted(); only recorded once cmpl_fd exists
+    std::vector<int32_t> completed;
 
     /**
-     * @brief Task lock; there are multiple concurrent threads that access the tasks 
-     * vector, and since vectors can relocate data (e.g., when adding new elements),
-     * this can lead to undefined behaviour. E.g., the scheduler thread iterates
-     * through the tasks vector, while the addTask() function could be called in the meantime,
-     * which would cause the vector to be resized and may cause the iterators to become invalid.
+     * @brief Task lock; protects the task map and the queues, which are accessed both by the
+     * scheduler thread and by the threads adding, querying and releasing tasks (e.g., the cService)
+     * @note The lock is not held while a task is reconfiguring the vFPGA or running
      */ 
     std::mutex tlock;
 
+    /// Signalled when a task is queued or completes, or the scheduler is stopped; the scheduler thread sleeps on it while there is nothing to do
+    std::condition_variable tcv;
+
     /// A dedicated thread that runs the scheduler
     std::thread scheduler_thread;
 
     /// A flag indicating whether the scheduler thread is running
     bool scheduler_running;
 
-    /// The currently loaded bitstream
+    /// The currently loaded bitstream; only written by the scheduler thread, under tlock
     std::string current_bitstream;
 
+    /// A bitstream in the cache
+    struct cachedBitstream {
+        /// Bitstream memory, as returned by readBitstream(...); nullptr while loading
+        bitstream_t bitstream = { nullptr, 0 };
+
+        /// Pinned memory accounted to the bitstream, in bytes (whole hugepages)
+        uint64_t size = { 0 };
+
+        /// Number of reconfigurations currently using the bitstream; pinned bitstreams are not evicted
+        uint32_t pins = { 0 };
+
+        /// Set while the bitstream is being read from disk
+        bool loading = { true };
+
+        /// Position in bitstream_lru; only valid once loaded
+        std::list<std::string>::iterator lru;
+    };
+
+    /// Cached bitstreams, by path; functions sharing a bitstream share the entry
+    std::unordered_map<std::string, cachedBitstream> bitstream_cache;
+
+    /// Paths of the loaded bitstreams, most recently used first
+    std::list<std::string> bitstream_lru;
+
+    /// Memory budget and statistics of the cache
+    bitstreamCacheStats cache_stats;
+
+    /// Bitstream to be prefetched next; empty if none
+    std::string prefetch_path;
+
+    /// Prefetcher thread, loading bitstreams ahead of their reconfiguration
+    std::thread prefetch_thread;
+
+    /// A flag indicating whether the prefetcher thread is running
+    bool prefetch_running;
+
+    /**
+     * @brief Cache lock; protects the bitstream cache and the prefetch request
+     * @note May be acquired while holding tlock, but not the other way around
+     */
+    std::mutex cache_lock;
+
+    /// Signalled when a bitstream finishes loading, a prefetch is requested or the prefetcher is stopped
+    std::condition_variable cache_cv;
+
+    /// Serializes the allocation and release of bitstream memory (readBitstream(...), freeMem(...)), which share the page map of cRcnfg
+    std::mutex load_lock;
+
     /// Default constructor; private to ensure the class is implemented as a singleton
     cSched(int32_t vfid, uint32_t device, bool reorder, std::string current_bitstream);
 
     /**
-     * @brief A utility function that is reaused throughut the scheduler
-     * Does the following checks:
-     * 1. Checks if the task ID is present in the task_id_map
-     * 2. Checks whether the task is non-NULL
-     * 3. As a common sanity check, ensures the ID in the map and the ID in the vector match
-     *  If not, something went seriously wrong when inserting the task to the list of tasks.
+     * @brief Pops the next task to be executed from the queues, following the scheduling policy; tlock must be held
      *
-     * @param tid Task ID to check
-     * @return true if the task is found and valid, false otherwise
+     * Unparked tasks go first. Otherwise, without reordering, the oldest queued task is picked. With reordering, the oldest 
+     * task of the bitstream with the highest priority is picked, see schedPolicy. The cost is independent of the number 
+     * of tasks submitted so far (amortized O(1) per bitstream with queued tasks).
+     *
+     * @return Pointer to the task, or nullptr if there are no queued tasks
+     */
+    cTask* nextTask();
+
+    /// Returns true if there are queued tasks that can be picked by nextTask(); tlock must be held
+    bool hasReadyTasks() const;
+
+    /**
+     * @brief Marks a task as completed, wakes up the scheduler thread and signals the completion event, if any; tlock must be held
+     *
+     * @param task Completed task
+     * @param ret_code Function return code
+     * @param ret_val Function return value
+     */
+    void completeTask(cTask *task, int32_t ret_code, std::vector<char> ret_val);
+
+    /**
+     * @brief Returns the bitstream of the next queued task that will require a reconfiguration; tlock must be held
+     *
+     * A prediction, following the scheduling policy: with reordering, the bitstream (other than the loaded one) with the 
+     * highest priority, otherwise the bitstream of the oldest queued task using another bitstream (within a bounded window).
+     *
+     * @return Bitstream path, or an empty string if no reconfiguration is expected
+     */
+    std::string nextBitstream();
+
+    /// Requests the prefetch of the bitstream returned by nextBitstream(), if not cached yet; tlock must be held
+    void prefetchNext();
+
+    /// Requests the prefetch of a bitstream, replacing any request not yet picked by the prefetcher, if not cached yet
+    void prefetch(const std::string &path);
+
+    /// Prefetcher thread; loads the requested bitstreams into the cache
+    void prefetcher();
+
+    /**
+     * @brief Loads a bitstream into the cache, evicting least recently used, unpinned bitstreams as needed to stay within the budget
+     *
+     * The cache entry must have been created (loading) by the caller, under cache_lock; on failure, it is removed again.
+     * If all the other bitstreams are pinned, the budget is exceeded temporarily rather than failing the reconfiguration.
+     *
+     * @param path Bitstream path
+     * @param pin If true, the bitstream is pinned once loaded, see acquireBitstream(...)
+     * @return Loaded bitstream
+     * @throws std::runtime_error if the bitstream cannot be opened or read
+     */
+    bitstream_t loadBitstream(const std::string &path, bool pin);
+
+    /**
+     * @brief Evicts least recently used, unpinned bitstreams until the cache is within its budget, with additional bytes reserved; cache_lock must be held
+     * @param reserve Bytes to keep free, in addition to the used memory
+     * @return The evicted bitstreams, to be released with freeMem(...) under load_lock (not cache_lock)
+     */
+    std::vector<bitstream_t> evictBitstreams(uint64_t reserve);
+
+    /// Releases evicted bitstreams; cache_lock must not be held
+    void releaseEvicted(const std::vector<bitstream_t> &evicted);
+
+    /**
+     * @brief Returns a bitstream from the cache, loading it if needed, and pins it until releaseBitstream(...)
+     * @param path Bitstream path
+     * @return Loaded bitstream
+     * @throws std::runtime_error if the bitstream cannot be loaded
+     */
+    bitstream_t acquireBitstream(const std::string &path);
+
+    /// Unpins a bitstream obtained through acquireBitstream(...)
+    void releaseBitstream(const std::string &path);
+
+    /**
+     * @brief Reconfigures the vFPGA with the bitstream of a function; tlock must not be held
+     * @param fid Function ID
+     * @return true if the bitstream was loaded
      */
-    bool taskChecker(int32_t tid);
+    bool reconfigure(int32_t fid);
 
     /**
      * @brief The main function of the scheduler
      *
-     * It iterates through the list of outstanding tasks and
-     * executed the outstanding ones. The scheduling policy depends
-     * on the variable scheduling_policy, passed to the class constructor.
-     * This function will also reconfigure the vFPGA bitstream, if needed.
+     * It sleeps until tasks are queued, and then dispatches them to the workers, in the order given by the scheduling 
+     * policy (see nextTask()). Tasks using the same bitstream run concurrently, on distinct cThreads, while a task of 
+     * another bitstream waits until all the running tasks have completed (drain barrier), before the vFPGA is reconfigured.
      */
     void schedule();
 
+    /// Worker thread; executes the dispatched tasks
+    void worker();
+
 public:
     /**
      * @brief Creates an instance of the scheduler for a vFPGA
@@ -168,6 +433,18 @@ public:
      */
     void start();
 
+    /**
+     * @brief Sets the number of worker threads, i.e., the maximum number of tasks running concurrently on the vFPGA
+     *
+     * With a single worker (the default), tasks lock the vFPGA (cThread::lock()) while running. With more workers, tasks
+     * of the same bitstream run concurrently on distinct cThreads (hardware threads of the vFPGA), and they don't lock 
+     * the vFPGA, so the functions must be safe to run concurrently, see Example 8.
+     *
+     * @param n Number of workers, between 1 and N_CTID_MAX
+     * @note Must be called before start()
+     */
+    void setWorkers(uint32_t n);
+
     /**
      * @brief Stops the scheduler and cleans up resources
      */
@@ -181,6 +458,77 @@ public:
      */
     bool addTask(std::unique_ptr<cTask> task);
 
+    /**
+     * @brief Releases a task, once its result is no longer needed
+     *
+     * Completed tasks are freed right away, queued tasks are cancelled and running tasks are freed when they complete.
+     * Pointers obtained through getTask(...) are invalid after the task is freed.
+     *
+     * @param tid Task ID to release
+     * @return true if the task was found, false otherwise
+     */
+    bool releaseTask(int32_t tid);
+
+    /**
+     * @brief Sets the parameters of the reordering policy; resets the reconfiguration time estimate
+     * @param policy Policy parameters
+     */
+    void setPolicy(schedPolicy policy);
+
+    /// Getter: parameters of the reordering policy
+    schedPolicy getPolicy();
+
+    /// Getter: current estimate of the reconfiguration time, in microseconds
+    double getRcnfgCost();
+
+    /// Getter: path of the currently loaded bitstream
+    std::string getCurrentBitstream();
+
+    /// Getter: number of worker threads
+    uint32_t getWorkers();
+
+    /**
+     * @brief Returns the number of queued and running tasks
+     * @param fid If not -1, only the tasks of this function are counted
+     */
+    uint32_t getLoad(int32_t fid = -1);
+
+    /**
+     * @brief Returns an event file descriptor (eventfd), which is signalled whenever a task completes
+     *
+     * The descriptor is created on the first call; from then on, the IDs of the completed tasks (including 
+     * released ones) are recorded and can be collected with takeCompleted(). This allows the caller to wait 
+     * for completions with poll/epoll, instead of querying isTaskCompleted(...) periodically (see cService).
+     *
+     * @return Non-blocking event file descriptor; owned by the scheduler
+     */
+    int getCompletionFd();
+
+    /**
+     * @brief Collects the IDs of the tasks completed since the last call; requires getCompletionFd()
+     * @return Task IDs, in the order of completion
+     */
+    std::vector<int32_t> takeCompleted();
+
+    /**
+     * @brief Sets the amount of pinned memory the cached bitstreams may use; evicts unused bitstreams right away if needed
+     *
+     * Bitstreams are loaded on their first use, so the budget only needs to fit the working set of bitstreams, but at least 
+     * two of them, so that the next bitstream can be prefetched while the current one is in use.
+     *
+     * @param bytes Memory budget, in bytes (default: DEF_BITSTREAM_CACHE_BUDGET)
+     */
+    void setCacheBudget(uint64_t bytes);
+
+    /// Getter: bitstream cache statistics
+    bitstreamCacheStats getCacheStats();
+
+    /**
+     * @brief Returns the scheduling statistics (queue depth, wait times) of all the functions with submitted tasks
+     * @return Map from function ID to its statistics
+     */
+    std::map<int32_t, schedStats> getFunctionStats();
+
     /**
      * @brief Checks if a task with a given ID is completed
      *
@@ -219,7 +567,8 @@ public:
      *
      * Each function is uniquely identified by its ID and holds
      * information about the function: path to its bistream
-     * and the corresponding software-side code.
+     * and the corresponding software-side code. The bitstream itself
+     * is only loaded when needed for a reconfiguration, see cSched.
      *
      * @param fn Unique pointer to the bFunc object representing the function
      * @return 0 if the function was added successfully, 1 if bitstream cannot be opened, 2 if the function ID already exists 
@@ -231,21 +580,13 @@ public:
         if (functions.find(fid) == functions.end()) {
             functions.emplace(fid, std::move(fn));
 
-            std::ifstream bitstream_file(functions[fid]->getBitstreamPath(), std::ios::ate | std::ios::binary);
+            std::ifstream bitstream_file(functions[fid]->getBitstreamPath(), std::ios::binary);
             if (!bitstream_file) {
 		        syslog(LOG_ERR, "Function %d bitstream could not be opened; please check the provided bitstream path", fid);
                 functions.erase(fid);
                 return 1;
 	        }
 
-            try {
-                functions[fid]->setBitstreamPointer(readBitstream(bitstream_file));
-            } catch (const std::exception &e) {
-                syslog(LOG_ERR, "Exception while loading function fid %d bitstream: %s", fid, e.what());
-                functions.erase(fid);
-                return 1;
-            }
-
             bitstream_file.close();
             syslog(LOG_NOTICE, "Added function with fid %d", fid);
             return 0;
@@ -28,18 +28,27 @@
 #define _COYOTE_CSERVICE_HPP_
 
 #include <map>
+#include <algorithm>
+#include <functional>
 #include <mutex>
+#include <memory>
 #include <vector>
 #include <string>
+#include <unordered_set>
+#include <deque>
+#include <sys/mman.h>
 #include <signal.h>
 #include <unistd.h>
 #include <sys/un.h>
 #include <syslog.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
 
 #include <coyote/cFunc.hpp>
 #include <coyote/cSched.hpp>
+#include <coyote/cDevSched.hpp>
 #include <coyote/cThread.hpp>
+#include <coyote/cShmRing.hpp>
 
 namespace coyote {
 
@@ -52,6 +61,11 @@ namespace coyote {
  * through the helper class cConn and submit requests to the loaded 
  * functions. The service will automatically reconfigure the vFPGA
  * with the correct bistream. The requests can be local or remote.
+ *
+ * A service either serves a single vFPGA (getInstance), or all the given vFPGAs 
+ * of a device (getDeviceInstance); in the latter case, the tasks are placed on the 
+ * vFPGAs by the device scheduler (cDevSched), so that a task can run on another 
+ * vFPGA holding its bitstream, instead of waiting for a reconfiguration.
  * 
  * @note There is currently a bug in terminating the signals. Since the signal handler
  * is static and limited in parameters, is it not aware of what instance should be terminated.
@@ -71,7 +85,8 @@ private:
      * We only allow one instance of the service per vFPGA on a single device, 
      * to ensure that mutliple services do not run in parallel on the same vFPGA,
      * which can lead to multiple reconfigurations, execution conflicts etc.
-     * The map of the key is the device ID concatenated with the vFPGA ID.
+     * The map of the key is the device ID concatenated with the vFPGA ID; 
+     * a device-level service (see getDeviceInstance) is keyed by the device ID only.
      */
     static std::map<std::string, cService*> services;
 
@@ -90,7 +105,7 @@ private:
     /// Whether the service receives requests from a remote node or locally
     bool remote;
 
-    /// vFPGA ID associated with the service
+    /// vFPGA ID associated with the service; -1 for a device-level service
     int32_t vfid;
 
     /// Device number, for systems with multiple vFPGAs
@@ -99,45 +114,123 @@ private:
     /// Port for remote connections
     uint16_t port;
 
-    /// A map of the connected clients and their corresponding Coyote threads which are used for executing the functions
-    std::map<int, std::unique_ptr<cThread>> coyote_threads;
-
-    /// Dedicated threads which process the requests for each connected client; one for incoming request and one for writing the result back
-    std::map<int, std::pair<std::thread, std::thread>> connection_threads;
-
-    /// Scheduler instance; handles the execution of tasks as well as reconfiguration, where required
+    /// Scheduler instance; handles the execution of tasks as well as reconfiguration, where required; nullptr for a device-level service
     cSched *scheduler;
+
+    /// Device scheduler, placing the tasks on the vFPGAs of a device-level service; nullptr otherwise
+    cDevSched *dev_scheduler;
     
     /// An atomic variable; used for generating unique IDs for tasks on the server side
     std::atomic<int32_t> task_counter;
 
     /**
-     * @brief A map of client-submitted tasks
-     * When a client submits a task, it holds an ID which is written back with the task result, 
-     * so that the client can link the result to the task (see cConn::checkCompletedTasks() for details). 
-     * However, there is no guarantee that the client-submitted task ID is globally unique (because of multiple clients), 
-     * so for each task, the cService also stores a server-generated task ID.
+     * @brief State of a connected client
+     *
+     * All the connections are handled by a single event loop (see eventLoop()), on non-blocking sockets. 
+     * Since requests and responses may arrive or leave in fragments, each connection buffers the received
+     * bytes until a complete request has been received, and the responses until the socket can accept them.
      */
-    std::map<int, std::vector<std::pair<int32_t, int32_t>>> tasks;
+    struct connState {
+        /// Connection file descriptor
+        int connfd;
+
+        /// Process ID of the client; -1 until it has been received
+        pid_t rpid;
+
+        /// Coyote thread used for executing the client's functions; created once the process ID is received
+        /// (for a device-level service, the device scheduler creates them, one per vFPGA)
+        std::unique_ptr<cThread> coyote_thread;
+
+        /// Received bytes, not yet parsed into a request
+        std::vector<char> recv_buf;
+
+        /// Responses not yet written to the socket
+        std::vector<char> send_buf;
+
+        /// A submitted task, without a response sent
+        struct connTask {
+            /// Client-submitted task ID
+            int32_t client_tid;
+
+            /// Set if the task was submitted through the shared-memory queue; the response is sent back the same way
+            bool ring;
+        };
+
+        /**
+         * @brief Submitted tasks, without a response sent; maps the server-generated task ID to the client-submitted task ID
+         * 
+         * When a client submits a task, it holds an ID which is written back with the task result, so that the 
+         * client can link the result to the task (see cConn::checkCompletedTasks() for details). However, there 
+         * is no guarantee that the client-submitted task ID is globally unique (because of multiple clients), 
+         * so for each task, the cService also stores a server-generated task ID.
+         */
+        std::map<int32_t, connTask> tasks;
+
+        /// Running tasks of a closed connection; the Coyote thread is released once they complete
+        std::unordered_set<int32_t> draining;
+
+        /// Shared-memory submission and completion queues, if negotiated by the client (DEF_OP_SHM_RING)
+        std::unique_ptr<cShmRing> ring;
+
+        /// Shared memory regions holding the client's buffers (DEF_OP_REG_BUFFER), mapped into the service; by region ID
+        std::map<int32_t, std::pair<void*, size_t>> regions;
+
+        /// File descriptors received from the client (SCM_RIGHTS), not yet claimed by a request
+        std::deque<int> recv_fds;
+
+        /// Unmaps the regions; only destroyed once no task uses them
+        ~connState() {
+            for (auto &[id, region] : regions) {
+                munmap(region.first, region.second);
+            }
+            for (int fd : recv_fds) {
+                ::close(fd);
+            }
+        }
+    };
 
-    /** @brief Task map locks
-     * Since the map is written by the processRequests() thread and read by the  
-     * sendResponses() thread, thread safety must be ensured when accesing the map.
-     */
-    std::map<int, std::unique_ptr<std::mutex>> task_locks;
+    /// Connected clients, by connection file descriptor
+    std::map<int, std::unique_ptr<connState>> conns;
 
-    /// A list of connection to be cleaned up; if the bool value is true, the connection is stale and should be cleaned up; false indicated it's been cleaned up
-    std::map<int, bool> conns_to_clean;
+    /// Closed connections whose Coyote thread is still used by running tasks
+    std::vector<std::unique_ptr<connState>> closed_conns;
 
-    /// Dedicated thread that periodically iterates conns_to_clean and release stale connection threads and resources
-    std::thread cleanup_thread;
+    /// Connections with shared-memory queues, by submission event file descriptor
+    std::map<int, connState*> ring_conns;
 
-    /// A boolean flag indicating whether the clean-up thread is running
-    bool run_cleanup_thread;
+    /// Connection of each submitted task, by server-generated task ID
+    std::map<int32_t, connState*> task_conns;
+
+    /// epoll instance, monitoring the listening socket, the connections and the scheduler completion event
+    int epfd;
+
+    /// Scheduler completion event (see cSched::getCompletionFd())
+    int cmpl_fd;
 
     /// Default constructor; private to ensure the class is implemented as a singleton
     cService(std::string name, bool remote, int32_t vfid, uint32_t device, bool reorder, uint16_t port);
 
+    /// Constructor of a device-level service; private to ensure the class is implemented as a singleton
+    cService(std::string name, bool remote, std::vector<int32_t> vfids, uint32_t device, bool reorder, uint16_t port);
+
+    /// Returns a registered function, or nullptr if the function ID is unknown
+    bFunc* getFunction(int32_t fid);
+
+    /// Submits a task to the scheduler (or, for a device-level service, to the device scheduler) on behalf of a client process
+    bool addTask(std::unique_ptr<cTask> task, pid_t rpid);
+
+    /// Returns a submitted task, or nullptr if it was already released
+    cTask* getTask(int32_t tid);
+
+    /**
+     * @brief Releases a task from the scheduler
+     * @return true if the task is still running, in which case it is only reclaimed (and reported by processCompletions()) once it completes
+     */
+    bool releaseTask(int32_t tid);
+
+    /// For a device-level service, releases the Coyote threads of a client process, once none of its connections is left
+    void releaseClient(pid_t rpid);
+
     /**
      * @brief Handles signals sent to the background service
      *
@@ -155,35 +248,114 @@ private:
     /// Initializes the socket for connections to this service, either local or remote
     void initSocket();
 
-    /// Function that periodically iterates and releases resources (e.g., threads) held by stale connections
-    void cleanConns();
+    /**
+     * @brief The main loop of the service
+     *
+     * A single thread waits (epoll) on the listening socket, all the client connections and the
+     * scheduler completion event; it accepts connections, parses requests, submits tasks and
+     * sends the responses as soon as the scheduler signals the completion of a task.
+     */
+    void eventLoop();
+
+    /// Accepts all pending local connections (IPC) to this service
+    void acceptConnectionsLocal();
+
+    /**
+     * @brief Reads all available bytes from a connection and processes the complete requests
+     * @param conn Client connection
+     * @return false if the connection was closed
+     */
+    bool readConnection(connState *conn);
+
+    /**
+     * @brief Processes the first request among the received bytes of a connection
+     *
+     * The first message of a client is its process ID; then follow the requests (opcode, function ID, task ID), 
+     * where a task submission is followed by the function arguments.
+     * 
+     * @param conn Client connection
+     * @param buf Received bytes, starting at the request
+     * @param len Number of received bytes
+     * @param closed Set to true if the client requested to close the connection
+     * @return Number of bytes consumed; 0 if the request is not complete yet
+     */
+    size_t processRequest(connState *conn, const char *buf, size_t len, bool &closed);
+
+    /**
+     * @brief Parses the function arguments and submits a task to the scheduler; on failure, an error response is sent
+     *
+     * @param conn Client connection
+     * @param fn Requested function
+     * @param client_tid Client-submitted task ID
+     * @param args Serialized function arguments, with the sizes given by bFunc::getArgumentSizes()
+     * @param ring If true, the task was received through the shared-memory submission queue
+     */
+    void submitTask(connState *conn, bFunc *fn, int32_t client_tid, const char *args, bool ring);
+
+    /**
+     * @brief Maps a shared memory region of the client, passed with a DEF_OP_REG_BUFFER request, and sends the response
+     *
+     * @param conn Client connection
+     * @param region Region ID, chosen by the client
+     * @param client_tid Client-submitted task ID of the request
+     */
+    void registerRegion(connState *conn, int32_t region, int32_t client_tid);
 
-    /// Accepts a local connection (IPC) to this service
-    void acceptConnectionLocal();
+    /**
+     * @brief Points a buffer (cBuffer), as sent by the client, to the service's mapping of its region; 
+     * the client's address is kept for FPGA transfers (see cBuffer::fpgaAddr())
+     * @return false if the region is not registered or the buffer exceeds it
+     */
+    bool resolveBuffer(connState *conn, cBuffer &buf);
 
-    /// Accepts a connection from a remote client to this service
-    void acceptConnectionRemote();
+    /**
+     * @brief Expresses a buffer (cBuffer), as returned by a function, relative to the region holding it, for the client
+     * @return false if the buffer is not inside one of the client's regions
+     */
+    bool exportBuffer(connState *conn, cBuffer &buf);
 
     /**
-     * @brief Processes client requests in a dedicated thread
+     * @brief Sets up shared-memory queues for a connection and passes them to the client
      *
-     * This function continuously loops to accept incoming requests
-     * for a connected client. It stores the requests in a list and
-     * can close the connection if the client sends a close request.
+     * The response carries the memfd and the event file descriptors of the queues (SCM_RIGHTS); 
+     * if they cannot be set up, the client receives an error code and keeps using the socket.
+     * Only the tasks submitted through the queues complete through them, so a client that fails
+     * to map the queues keeps working over the socket.
      *
-     * @param connfd The connection file descriptor for the client
+     * @param conn Client connection
+     * @param client_tid Client-submitted task ID of the request
      */
-    void processRequests(int connfd);
+    void setupRing(connState *conn, int32_t client_tid);
+
+    /// Submits all the tasks in the shared-memory submission queue of a connection
+    void processSubmissions(connState *conn);
 
     /**
-     * @brief Send client responses in a dedicated thread
+     * @brief Queues a response (return code, task ID and, on success, the return value) and tries to send it
      *
-     * This function continuously loops to check whether a client task
-     * has been completed and sends the response back to the client.
+     * Responses to tasks submitted through the shared-memory queues are posted to the completion queue instead, unless it is full
+     *
+     * @param conn Client connection
+     * @param ret_code Return code; 0 on success
+     * @param client_tid Client-submitted task ID
+     * @param ret_val Return value; only sent on success
+     * @param ring If true, the request was received through the shared-memory submission queue
+     */
+    void sendResponse(connState *conn, int32_t ret_code, int32_t client_tid, const std::vector<char> &ret_val = {}, bool ring = false);
+
+    /// Writes the buffered responses of a connection, as long as the socket accepts them
+    void flushConnection(connState *conn);
+
+    /// Sends the responses of all the tasks completed since the last call, and releases them from the scheduler
+    void processCompletions();
+
+    /**
+     * @brief Closes a connection and releases its tasks
      *
-     * @param connfd The connection file descriptor for the client
+     * The connection state is kept until the tasks already running (and, therefore, using its Coyote thread) complete
+     * @param conn Client connection
      */
-    void sendResponses(int connfd);
+    void closeConnection(connState *conn);
 
 public:
 
@@ -214,12 +386,39 @@ public:
 
     }
 
+    /**
+     * @brief Creates an instance of the service for a set of vFPGAs of a device
+     *
+     * Tasks are placed on the vFPGAs by the device scheduler (see cDevSched): preferably on a vFPGA already holding 
+     * the task's bitstream, reconfiguring the least loaded vFPGA otherwise. The clients connect to the socket 
+     * /tmp/coyote-daemon-dev-{device}-{name} and submit tasks as for a single-vFPGA service; functions 
+     * must be added through the factory overload of addFunction(...), since bitstreams are specific to a vFPGA.
+     *
+     * If an instance already exists, return the existing instance ("singleton" implementation)
+     *
+     * @param name Unique name for the service
+     * @param remote Local or remote service
+     * @param vfids IDs of the vFPGAs served
+     * @param device Device number, for systems with multiple vFPGAs 
+     * @param reorder Allow the schedulers to reorder tasks, to minimize reconfigurations
+     * @param port Port for remote connections
+     */
+    static cService* getDeviceInstance(std::string name, bool remote, std::vector<int32_t> vfids, uint32_t device = 0, bool reorder = true, uint16_t port = DEF_PORT) {
+        std::string tmp_id = std::to_string(device);
+
+        if (services.find(tmp_id) == services.end() || services[tmp_id] == nullptr) {
+            services[tmp_id] = new cService(name, remote, vfids, device, reorder, port);
+        }
+
+        return services[tmp_id];
+    }
+
     /**
      * @brief Starts the service
      *
      * This function initializes the daemon, sets up the socket for communication,
      * and starts the scheduler thread to handle incoming requests.
-     * It will also accept connections from clients and register them.
+     * It then runs the event loop, which accepts connections from clients and serves their requests.
      */
     void start();
 
@@ -229,12 +428,28 @@ public:
     * @param fn Unique pointer to the bFunc object representing the function
     * @return 0 if the function was added successfully, 1 if bitstream cannot be opened, 2 if the function ID already exists 
     *
-    * @note Implemented in the header file since it is a templated function
+    * @note Not supported by a device-level service, whose functions are added through a factory (see below)
     */
     int addFunction(std::unique_ptr<bFunc> fn) {
+        if (dev_scheduler != nullptr) {
+            throw std::runtime_error("ERROR: cService - functions of a device-level service must be added through a factory");
+        }
         return scheduler->addFunction(std::move(fn));
     }
 
+    /**
+    * @brief Adds an arbitrary user function to all the vFPGAs of the service
+    * 
+    * @param make_fn Factory, returning the function for a given vFPGA ID (e.g., with the bitstream built for that vFPGA)
+    * @return 0 if the function was added successfully, otherwise the return code of addFunction(...) for the first failing vFPGA
+    */
+    int addFunction(std::function<std::unique_ptr<bFunc>(int32_t)> make_fn) {
+        if (dev_scheduler != nullptr) {
+            return dev_scheduler->addFunction(make_fn);
+        }
+        return scheduler->addFunction(make_fn(vfid));
+    }
+
 };
 
 }
@@ -0,0 +1,182 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CSHMRING_HPP_
+#define _COYOTE_CSHMRING_HPP_
+
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+#include <coyote/cDefs.hpp>
+
+namespace coyote {
+
+/// @brief An entry of a cShmRing queue; a task submission (fid, tid, arguments) or a completion (ret_code, tid, return value)
+struct shmRingEntry {
+    /// Function ID (submission) or return code (completion)
+    int32_t code;
+
+    /// Client-submitted task ID
+    int32_t tid;
+
+    /// Number of valid bytes in data
+    uint32_t len;
+
+    /// Serialized function arguments (submission) or return value (completion)
+    char data[SHM_RING_SLOT_SIZE - 3 * sizeof(int32_t)];
+};
+
+/**
+ * @brief Shared-memory submission and completion queues between a cConn client and the cService
+ *
+ * The queues live in an anonymous, memfd-backed memory region, which the cService creates for each
+ * connection and passes to the client, together with two event file descriptors, over the Unix socket 
+ * (see cService::processRequest() and the cConn constructor). Each queue is a single-producer,
+ * single-consumer ring of fixed-size entries: submitting a task is a copy into shared memory
+ * and an eventfd kick, instead of a series of socket writes and reads.
+ *
+ * The memory layout is shared between processes, so it only holds trivially copyable data and lock-free atomics.
+ */
+class cShmRing {
+
+private:
+    /// Head (consumer) and tail (producer) index of a queue, on separate cache lines
+    struct shmRingIdx {
+        alignas(64) std::atomic<uint32_t> head;
+        alignas(64) std::atomic<uint32_t> tail;
+    };
+
+    /// Layout of the shared memory region
+    struct shmRingLayout {
+        uint32_t magic;
+        uint32_t depth;
+        shmRingIdx sq;
+        shmRingIdx cq;
+        shmRingEntry sq_entries[SHM_RING_DEPTH];
+        shmRingEntry cq_entries[SHM_RING_DEPTH];
+    };
+
+    /// Identifies an initialized region
+    static constexpr uint32_t SHM_RING_MAGIC = 0x434f5952;
+
+    /// memfd of the shared memory region
+    int mem_fd;
+
+    /// Event file descriptor, signalled by the client after submitting tasks
+    int sq_fd;
+
+    /// Event file descriptor, signalled by the service after completing tasks
+    int cq_fd;
+
+    /// Mapped shared memory region
+    shmRingLayout *layout;
+
+    /// Maps the shared memory region; shared by the constructors
+    void map(bool init);
+
+    /// Pushes an entry to a queue; returns false if the queue is full
+    static bool push(shmRingIdx &idx, shmRingEntry *entries, int32_t code, int32_t tid, const void *data, size_t len);
+
+    /// Pops an entry from a queue; returns false if the queue is empty
+    static bool pop(shmRingIdx &idx, shmRingEntry *entries, shmRingEntry &entry);
+
+public:
+    /// Maximum size of the arguments or return value carried by a single entry
+    static constexpr size_t MAX_DATA_SIZE = sizeof(shmRingEntry::data);
+
+    /**
+     * @brief Creates the queues (service side); allocates the shared memory region and the event file descriptors
+     * @note Throws a runtime_error if the resources cannot be allocated
+     */
+    cShmRing();
+
+    /**
+     * @brief Attaches to queues created by the service (client side); takes ownership of the file descriptors
+     *
+     * @param mem_fd memfd of the shared memory region
+     * @param sq_fd Submission event file descriptor
+     * @param cq_fd Completion event file descriptor
+     * @note Throws a runtime_error if the region cannot be mapped or was not initialized by a cShmRing
+     */
+    cShmRing(int mem_fd, int sq_fd, int cq_fd);
+
+    /// Default destructor; unmaps the region and closes the file descriptors
+    ~cShmRing();
+
+    cShmRing(const cShmRing&) = delete;
+    cShmRing& operator=(const cShmRing&) = delete;
+
+    /**
+     * @brief Submits a task (client side) and signals the service
+     *
+     * @param fid Function ID
+     * @param tid Client-submitted task ID
+     * @param args Serialized function arguments
+     * @param len Size of the arguments, at most MAX_DATA_SIZE
+     * @param kick If false, the service is not signalled; used to submit a batch of tasks followed by a single kick()
+     * @return true if the task was submitted, false if the queue is full or the arguments too large
+     */
+    bool submit(int32_t fid, int32_t tid, const void *args, size_t len, bool kick = true);
+
+    /// Signals the service that tasks were submitted (client side)
+    void kick();
+
+    /// Pops the next submitted task (service side); returns false if there is none
+    bool popSubmission(shmRingEntry &entry);
+
+    /**
+     * @brief Posts a task completion (service side) and signals the client
+     *
+     * @param ret_code Return code; 0 on success
+     * @param tid Client-submitted task ID
+     * @param ret_val Return value
+     * @param len Size of the return value, at most MAX_DATA_SIZE
+     * @return true if the completion was posted, false if the queue is full or the return value too large
+     */
+    bool complete(int32_t ret_code, int32_t tid, const void *ret_val, size_t len);
+
+    /// Pops the next task completion (client side); returns false if there is none
+    bool popCompletion(shmRingEntry &entry);
+
+    /// Getter: memfd of the shared memory region
+    int getMemFd() const { return mem_fd; }
+
+    /// Getter: submission event file descriptor; readable when tasks were submitted
+    int getSubmitFd() const { return sq_fd; }
+
+    /// Getter: completion event file descriptor; readable when tasks were completed
+    int getCompletionFd() const { return cq_fd; }
+};
+
+}
+
+#endif // _COYOTE_CSHMRING_HPP_
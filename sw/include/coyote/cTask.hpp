@@ -89,6 +89,9 @@ public:
     /// Getter: Pointer to associated cThread
     cThread* getCThread() const;
 
+    /// Setter: Pointer to associated cThread; e.g., for tasks placed on a vFPGA by the cDevSched
+    void setCThread(cThread* cthread);
+
     /// Getter: Function arguments
     std::vector<std::vector<char>> getArgs() const;
 
@@ -27,9 +27,11 @@
 #ifndef _COYOTE_CTHREAD_HPP_
 #define _COYOTE_CTHREAD_HPP_
 
+#include <atomic>
 #include <thread>
 #include <chrono>
 #include <string>
+#include <vector>
 #include <random>
 #include <fstream>
 #include <iostream>
@@ -58,6 +60,11 @@
 #include <coyote/cDefs.hpp>
 #include <coyote/cOps.hpp>
 #include <coyote/cGpu.hpp>
+#include <coyote/cWait.hpp>
+#include <coyote/cNuma.hpp>
+#include <coyote/cOperStats.hpp>
+#include <coyote/cRegCache.hpp>
+#include <coyote/cIntervalMap.hpp>
 
 namespace coyote {
 
@@ -92,15 +99,44 @@ protected:
 	/// Number data transfer commands sent to the vFPGA
 	uint32_t cmd_cnt = { 0 };
 
+	/// Expected value of each writeback (completion) counter once all issued operations with last = true complete; indexed by RD_WBACK, WR_WBACK etc.
+	uint32_t cmpl_seq[N_WBACKS] = { 0 };
+
 	/// User interrupt file descriptor
 	int32_t efd = { -1 };
 
 	/// Termination event file descriptor for stopping the user interrupt thread
 	int32_t terminate_efd = { -1 };
 
+	/// Wait policy, used for command FIFO backpressure and blocking completion waits
+	waitPolicy wait_policy;
+
+	/// Counters of the wait phases hit so far
+	waitStats wait_stats;
+
+	/// Eventfd waiters block on in the CoyoteWait::SPIN_BLOCK mode; see wakeWaiters()
+	int32_t wait_efd = { -1 };
+
+	/// Set if user interrupts should wake up blocked waiters, see waitPolicy::irq_wakeup; read by the user interrupt thread
+	std::atomic<bool> irq_wakeup = { false };
+
+	#ifdef EN_OPER_STATS
+	/// Submit-to-completion latency histograms; mutable, since completions are observed in checkCompleted()
+	mutable cOperStats oper_stats;
+	#endif
+
 	/// Dedicated thread for handling user interrupts
 	std::thread event_thread;
 
+	/// NUMA node the FPGA is attached to; -1 if unknown
+	int32_t numa_node = { -1 };
+
+	/// Whether host buffers allocated by getMem() are placed on numa_node; see setNumaPlacement()
+	bool numa_mem = { true };
+
+	/// Whether helper threads (i.e., the user interrupt thread) are pinned to the CPUs of numa_node; see setNumaPlacement()
+	bool numa_affinity = { false };
+
 	/// vFPGA config registers, if AVX is enabled, as implemented in cnfg_slave_avx.sv; used mainly for starting DMA commands
 	#ifdef EN_AVX
 	volatile __m256i *cnfg_reg_avx = { 0 };
@@ -115,8 +151,11 @@ protected:
 	/// Pointer to writeback region, if enabled
 	volatile uint32_t *wback = { 0 };
 
-	/// A map of all the pages that have been allocated and mapped for this thread
-	std::unordered_map<void*, CoyoteAlloc> mapped_pages;
+	/// All the buffers that have been allocated and mapped for this thread, ordered by address so interior pointers can be resolved
+	cIntervalMap<CoyoteAlloc> mapped_pages;
+
+	/// Cache of buffer registrations made through userMap(); disabled by default, see setRegCacheBudget()
+	cRegCache reg_cache;
 
 	/** 
 	 * Out-of-band connection file descriptor to a remote node
@@ -140,12 +179,28 @@ protected:
 	/// Set to true if the vFPGA lock is acquired by this cThread; used to release the lock in the destructor
 	bool lock_acquired = { false };
 	
+	/**
+	 * @brief Utility function, registers the user interrupt eventfd and starts the user interrupt thread
+	 *
+	 * @param uisr User interrupt service routine; may be empty if the thread is only needed to wake up waiters (waitPolicy::irq_wakeup)
+	 */
+	void startEventThread(std::function<void(int)> uisr);
+
 	/// Utility function, memory mapping all the vFPGA control registers and writeback regions
 	void mmapFpga();
 
 	/// Utility function, unmapping all the vFPGA control registers and writeback regions
 	void munmapFpga();
 
+	/// Utility function, maps a buffer to the vFPGA TLB in the driver, bypassing the registration cache
+	void mapBuffer(void *vaddr, uint32_t len);
+
+	/// Utility function, unmaps a buffer from the vFPGA TLB in the driver, bypassing the registration cache
+	void unmapBuffer(void *vaddr);
+
+	/// Utility function, unmaps and releases the memory of an allocation obtained through getMem(...); mapped_pages is not updated
+	void releaseMem(void *vaddr, const CoyoteAlloc &alloc);
+
 	/**
 	 * @brief Posts a DMA command to the vFPGA
 	 *
@@ -158,6 +213,35 @@ protected:
 	 */
 	void postCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0);
 
+	/**
+	 * @brief Returns the number of commands that can be written to the command FIFO without overflowing it
+	 *
+	 * Credits are tracked in software (cmd_cnt); CTRL_REG is only read back, and the function only blocks,
+	 * once the software count reaches the threshold (CMD_FIFO_DEPTH - CMD_FIFO_THR).
+	 * @return Number of available command credits, always at least 1
+	 */
+	uint32_t getCmdCredits();
+
+	/**
+	 * @brief Writes a single DMA command to the vFPGA config registers, without any credit checks
+	 *
+	 * @note Callers must obtain credits through getCmdCredits() and increment cmd_cnt accordingly
+	 */
+	void writeCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0);
+
+	/**
+	 * @brief Advances the expected completion counter(s) of an issued operation
+	 *
+	 * @param oper Issued operation
+	 * @param last Whether the operation was issued with last = true; only then is the counter incremented by the vFPGA
+	 * @param bytes Number of bytes moved by the operation, for the operation statistics (EN_OPER_STATS)
+	 * @return Completion sequence number of the operation, see invoke(...)
+	 */
+	uint32_t nextCmplSeq(CoyoteOper oper, bool last, uint64_t bytes = 0);
+
+	/// Utility function, reads the completion counter of an operation type; checkCompleted() without the operation statistics
+	uint32_t readCompleted(CoyoteOper oper) const;
+
 	/**
 	 * @brief Sends an ack to the connected remote node via the out-of-band channel
 	 *
@@ -179,8 +263,9 @@ protected:
 	/**
 	 * @brief Writes an IP address to a config register so it can be used for ARP lookup
 	 * @param ip_addr IP address to be looked up
+	 * @param wait If true, waits for the lookup to complete; otherwise, the caller must wait (e.g., once for several lookups)
 	 */
-    void doArpLookup(uint32_t ip_addr);
+    void doArpLookup(uint32_t ip_addr, bool wait = true);
 	
 	/**
 	 * @brief Writes the exchanged QP information to the vFPGA config registers
@@ -217,9 +302,68 @@ protected:
 	 * @brief Unmaps a buffer from the the vFPGAs TLB
 	 *
 	 * @param vaddr Virtual address of the buffer
+	 * @note With the registration cache enabled, the buffer stays mapped until it is evicted, see setRegCacheBudget()
 	 */
 	void userUnmap(void *vaddr);
 
+	/**
+	 * @brief Enables the registration cache for userMap()/userUnmap() with the given pinned memory budget
+	 *
+	 * With the cache enabled, userUnmap() keeps the registration and a later userMap() of the same (or a covered) range
+	 * becomes a lookup instead of a driver call. Unused registrations are unmapped in LRU order once the memory mapped
+	 * through the cache exceeds the budget.
+	 *
+	 * @param bytes Pinned memory budget, in bytes; 0 disables the cache and unmaps all unused registrations
+	 * @note Buffers mapped with userMap() that are released by the application (e.g., free or munmap) while the cache
+	 * is enabled must be invalidated first, using invalidateRegCache(); buffers from getMem() are handled by freeMem()
+	 */
+	void setRegCacheBudget(uint64_t bytes);
+
+	/**
+	 * @brief Unmaps all cached registrations overlapping the given range, including ones still in use
+	 *
+	 * @param vaddr Start of the range
+	 * @param len Length of the range, in bytes
+	 */
+	void invalidateRegCache(void *vaddr, uint64_t len);
+
+	/// Unmaps all unused cached registrations
+	void flushRegCache();
+
+	/// Getter: registration cache statistics
+	regCacheStats getRegCacheStats() const;
+
+	/**
+	 * @brief Sets the NUMA placement of host buffers and helper threads
+	 *
+	 * By default, host buffers (REG, THP and HPF) allocated by getMem() are placed on the NUMA node of the FPGA,
+	 * so that DMA traffic does not cross the socket interconnect. Pinning the helper threads is opt-in; 
+	 * application threads can be pinned with setThreadAffinity(pthread_self(), getNodeCpus(getNumaNode())).
+	 * Both have no effect if the NUMA node of the FPGA is unknown.
+	 *
+	 * @param mem_bind Place buffers allocated by subsequent getMem() calls on the FPGA's NUMA node
+	 * @param thread_affinity Pin the user interrupt thread to the CPUs of the FPGA's NUMA node; 
+	 *                        if false, a previously set affinity is reset to all CPUs
+	 */
+	void setNumaPlacement(bool mem_bind, bool thread_affinity);
+
+	/// Getter: NUMA node the FPGA is attached to, -1 if unknown
+	int32_t getNumaNode() const;
+
+	/**
+	 * @brief Returns the submit-to-completion latency distribution and throughput of each operation type
+	 *
+	 * Operations are timed from invoke(...) until their completion is first observed through checkCompleted() 
+	 * (or isCompleted(), waitCompleted() etc.), so the latency includes the polling delay of the application.
+	 * Only operations with a completion counter, issued with last = true, are timed.
+	 *
+	 * @return One entry per operation type with completed operations; empty if the library was built without EN_OPER_STATS
+	 */
+	std::vector<operStats> getOperStats() const;
+
+	/// Clears the operation statistics
+	void resetOperStats();
+
 	/**
 	 * @brief Allocates memory for this cThread and maps it into the vFPGA's TLB
 	 *
@@ -235,6 +379,23 @@ protected:
 	 */
 	void freeMem(void* vaddr);
 
+	/**
+	 * @brief Finds the allocation (obtained through getMem()) containing the given address range
+	 *
+	 * @param addr Any address within the allocation, not necessarily its start
+	 * @param len Length of the range, in bytes; the whole range must be within the allocation
+	 * @return Pointer to the allocation parameters (with mem set to the start of the allocation); nullptr if the range is not within a single allocation
+	 */
+	const CoyoteAlloc* findAlloc(const void *addr, uint64_t len = 1) const;
+
+	/**
+	 * @brief Checks whether an address range is within a single allocation obtained through getMem()
+	 *
+	 * @param addr Start of the range
+	 * @param len Length of the range, in bytes
+	 */
+	bool isMapped(const void *addr, uint64_t len = 1) const;
+
 	/**
 	 * @brief Sets a control register in the vFPGA at the specified offset
 	 *
@@ -270,11 +431,12 @@ protected:
 	 * @param oper Operation be invoked, in this case must be either CoyoteOper::LOCAL_READ or CoyoteOper::LOCAL_WRITE
 	 * @param sg Scatter-gather entry, specifying the memory address, length and stream for the operation
 	 * @param last Indicates whether this is the last operation in a sequence (default: true)
+	 * @return Completion sequence number; checkCompleted(oper) reaches this value once the operation (or, if last is false, the preceding one with last set) has completed
 	 *
  	 * @note Local operations are non-blocking (asynchronous) by design, so users should poll for completion using checkCompleted()
 	 * @note Whenever last is passed as true, the completion counter for the operation is incremented by 1 and an acknowledgement is sent on the hardware-side cq_* interface of the vFPGA with ack_t.host = 1; otherwise it is not
 	 */
-	void invoke(CoyoteOper oper, localSg sg, bool last = true);
+	uint32_t invoke(CoyoteOper oper, localSg sg, bool last = true);
 
 	/**
 	 * @brief Invokes a two-sided local Coyote operation with the specified scatter-gather list (sg)
@@ -283,11 +445,37 @@ protected:
 	 * @param src_sg Source scatter-gather entry, specifying the memory address, length and stream
 	 * @param dst_sg Destination scatter-gather entry, specifying the memory address, length and stream
 	 * @param last Indicates whether this is the last operation in a sequence (default: true)
+	 * @return Completion sequence number; checkCompleted(oper) reaches this value once the operation (or, if last is false, the preceding one with last set) has completed
 	 *
  	 * @note Local operations are non-blocking (asynchronous) by design, so users should poll for completion using checkCompleted()
 	 * @note Whenever last is passed as true, the completion counter for the operation is incremented by 1 and an acknowledgement is sent on the hardware-side cq_* interface of the vFPGA with ack_t.host = 1; otherwise it is not
 	 */
-	void invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last = true);
+	uint32_t invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last = true);
+
+	/**
+	 * @brief Invokes a one-sided local Coyote operation on a scatter-gather list, which may exceed MAX_TRANSFER_SIZE
+	 *
+	 * The list is split into descriptors of at most MAX_TRANSFER_SIZE bytes, which are issued as fast as the command FIFO
+	 * accepts them; last is only set on the final descriptor, so the whole list completes as a single operation.
+	 *
+	 * @param oper Operation be invoked, in this case must be either CoyoteOper::LOCAL_READ or CoyoteOper::LOCAL_WRITE
+	 * @param sgl Scatter-gather list, specifying the segments, stream and dest for the operation
+	 * @return Completion sequence number of the whole list, see invoke(...)
+	 */
+	uint32_t invoke(CoyoteOper oper, const localSgList &sgl);
+
+	/**
+	 * @brief Invokes a two-sided local Coyote operation on scatter-gather lists, which may exceed MAX_TRANSFER_SIZE
+	 *
+	 * Source and destination lists are split independently, so their segments don't have to line up;
+	 * the whole transfer completes as a single operation.
+	 *
+	 * @param oper Operation be invoked, in this case must be CoyoteOper::LOCAL_TRANSFER
+	 * @param src_sgl Source scatter-gather list
+	 * @param dst_sgl Destination scatter-gather list
+	 * @return Completion sequence number of the whole transfer, see invoke(...)
+	 */
+	uint32_t invoke(CoyoteOper oper, const localSgList &src_sgl, const localSgList &dst_sgl);
 
 	/**
 	 * @brief Invokes an RDMA operation with the specified scatter-gather list (sg)
@@ -295,11 +483,12 @@ protected:
 	 * @param oper Operation be invoked, in this case must be CoyoteOper::RDMA_WRITE or CoyoteOper::RDMA_READ
 	 * @param sg Scatter-gather entry, specifying the RDMA operation parameters 
 	 * @param last Indicates whether this is the last operation in a sequence (default: true)
+	 * @return Completion sequence number; checkCompleted(oper) reaches this value once the operation (or, if last is false, the preceding one with last set) has completed
 	 *
  	 * @note Remote oeprations are non-blocking (asynchronous) by design, so users should poll for completion using checkCompleted()
 	 * @note Whenever last is passed as true, the completion counter for the operation is incremented by 1 and an acknowledgement is sent on the hardware-side cq_* interface of the vFPGA with ack_t.host = 1; otherwise it is not
 	 */
-	void invoke(CoyoteOper oper, rdmaSg sg, bool last = true);
+	uint32_t invoke(CoyoteOper oper, rdmaSg sg, bool last = true);
 
 	/**
 	 * @brief Invokes a TCP operation with the specified scatter-gather list (sg)
@@ -307,10 +496,46 @@ protected:
 	 * @param oper Operation be invoked, in this case must be CoyoteOper::TCP_SEND
 	 * @param sg Scatter-gather entry, specifying the TCP operation parameters 
 	 * @param last Indicates whether this is the last operation in a sequence (default: true)
+	 * @return Always 0, as TCP operations don't have a completion counter
 	 *
 	 * @note TCP operations aren't fully stable in Coyote 0.2.1, to be updated in the future
 	 */
-	void invoke(CoyoteOper oper, tcpSg sg, bool last = true);
+	uint32_t invoke(CoyoteOper oper, tcpSg sg, bool last = true);
+
+	/**
+	 * @brief Invokes a batch of one-sided local Coyote operations
+	 *
+	 * Equivalent to calling invoke(oper, sg, last) for every entry, but the command FIFO credits are obtained
+	 * once for as many entries as fit and the descriptors are written back-to-back, so CTRL_REG is only polled
+	 * when the credits run out. All entries are validated before any command is issued.
+	 *
+	 * @param oper Operation be invoked, in this case must be either CoyoteOper::LOCAL_READ or CoyoteOper::LOCAL_WRITE
+	 * @param sgs Scatter-gather entries, specifying the memory address, length and stream for each operation
+	 * @param last Indicates whether each operation is the last in a sequence (default: true)
+	 * @return Completion sequence number of the last entry in the batch, see invoke(...)
+	 */
+	uint32_t invokeBatch(CoyoteOper oper, const std::vector<localSg> &sgs, bool last = true);
+
+	/**
+	 * @brief Invokes a batch of two-sided local Coyote operations
+	 *
+	 * @param oper Operation be invoked, in this case must be CoyoteOper::LOCAL_TRANSFER
+	 * @param src_sgs Source scatter-gather entries
+	 * @param dst_sgs Destination scatter-gather entries; must have the same number of entries as src_sgs
+	 * @param last Indicates whether each operation is the last in a sequence (default: true)
+	 * @return Completion sequence number of the last entry in the batch, see invoke(...)
+	 */
+	uint32_t invokeBatch(CoyoteOper oper, const std::vector<localSg> &src_sgs, const std::vector<localSg> &dst_sgs, bool last = true);
+
+	/**
+	 * @brief Invokes a batch of RDMA operations
+	 *
+	 * @param oper Operation be invoked, in this case must be CoyoteOper::REMOTE_RDMA_WRITE or CoyoteOper::REMOTE_RDMA_READ
+	 * @param sgs Scatter-gather entries, specifying the RDMA operation parameters
+	 * @param last Indicates whether each operation is the last in a sequence (default: true)
+	 * @return Completion sequence number of the last entry in the batch, see invoke(...)
+	 */
+	uint32_t invokeBatch(CoyoteOper oper, const std::vector<rdmaSg> &sgs, bool last = true);
 
 	/**
 	 * @brief Returns the number of completed operations for a given Coyote operation type
@@ -320,11 +545,54 @@ protected:
 	 */
 	uint32_t checkCompleted(CoyoteOper oper) const;
 
+	/**
+	 * @brief Checks whether the operation with the given completion sequence number has completed
+	 *
+	 * @param oper Operation to be queried
+	 * @param seq Completion sequence number, as returned by invoke(...)
+	 * @return True if checkCompleted(oper) has reached seq; the comparison is robust to the 32-bit counters wrapping around
+	 */
+	bool isCompleted(CoyoteOper oper, uint32_t seq) const;
+
 	/**
 	 * @brief Clears all the completion counters (for all operations)
 	 */
 	void clearCompleted();
 
+	/**
+	 * @brief Blocks until the operation with the given completion sequence number has completed
+	 *
+	 * @param oper Operation to be waited on
+	 * @param seq Completion sequence number, as returned by invoke(...)
+	 * @note The wait follows the wait policy of this cThread, see setWaitPolicy()
+	 */
+	void waitCompleted(CoyoteOper oper, uint32_t seq);
+
+	/**
+	 * @brief Sets the wait policy for command FIFO backpressure and waitCompleted()
+	 *
+	 * With waitPolicy::irq_wakeup, blocked waiters are woken up by vFPGA user interrupts, so that many cThreads can wait for
+	 * long transfers without occupying a core each; the user interrupt thread is started if it isn't running yet.
+	 * Setting spin_iters and yield_iters to zero blocks right away; otherwise, the wait spins first (hybrid mode).
+	 *
+	 * @param policy Wait policy; the default is CoyoteWait::SLEEP
+	 * @throws std::runtime_error if irq_wakeup is set for a mode other than CoyoteWait::SPIN_BLOCK
+	 */
+	void setWaitPolicy(waitPolicy policy);
+
+	/// Getter: wait policy
+	waitPolicy getWaitPolicy() const;
+
+	/// Getter: counters of how often each wait phase was hit
+	waitStats getWaitStats() const;
+
+	/**
+	 * @brief Wakes up a waiter blocked in the CoyoteWait::SPIN_BLOCK mode before its timeout expires
+	 *
+	 * Can be called from any thread, e.g., from a user interrupt service routine signalling that the vFPGA made progress
+	 */
+	void wakeWaiters();
+
 	/** 
 	 * @brief Synchronizes the connection between the client and server
 	 * @param client If true, this cThread acts as a client; otherwise, it acts as a server
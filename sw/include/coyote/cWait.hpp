@@ -0,0 +1,175 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COYOTE_CWAIT_HPP_
+#define _COYOTE_CWAIT_HPP_
+
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+#include <poll.h>
+#include <time.h>
+#include <sys/eventfd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <coyote/cDefs.hpp>
+
+namespace coyote {
+
+/**
+ * @brief Wait policies for cThread, used for command FIFO backpressure and blocking completion waits
+ *
+ * A fixed std::this_thread::sleep_for(SLEEP_TIME) typically sleeps for tens of microseconds due to timer slack,
+ * which inflates tail latency; the spinning policies avoid the scheduler for short waits.
+ */
+enum class CoyoteWait {
+    /// Sleep for SLEEP_TIME between checks; the original behaviour, lowest CPU usage
+    SLEEP = 0,
+
+    /// Busy-wait with a pause instruction between checks; lowest latency, occupies a core
+    SPIN = 1,
+
+    /// Spin for waitPolicy::spin_iters checks, then yield the CPU between checks
+    SPIN_YIELD = 2,
+
+    /// Spin, then yield for waitPolicy::yield_iters checks, then block on an eventfd (with a timeout of waitPolicy::block_ns) between checks
+    SPIN_BLOCK = 3
+};
+
+/// @brief Wait policy parameters of a cThread, see CoyoteWait
+struct waitPolicy {
+    /// Wait mode
+    CoyoteWait mode = { CoyoteWait::SLEEP };
+
+    /// Number of checks in the spin phase
+    uint32_t spin_iters = { 1024 };
+
+    /// Number of checks in the yield phase (SPIN_BLOCK only)
+    uint32_t yield_iters = { 64 };
+
+    /// Maximum time blocked on the eventfd, in nanoseconds, before checking again (SPIN_BLOCK only)
+    long block_ns = { 10000 };
+
+    /**
+     * Wake up blocked waiters on every vFPGA user interrupt (SPIN_BLOCK only); the vFPGA should then raise a notification
+     * when it completes an operation, and block_ns can be raised to a safety timeout for completions without one
+     */
+    bool irq_wakeup = { false };
+};
+
+/// @brief Counters of how often each wait phase was hit
+struct waitStats {
+    /// Number of waits, i.e., the condition didn't hold at the first check
+    uint64_t n_waits = { 0 };
+
+    /// Waits that completed in the spin phase
+    uint64_t spin_hits = { 0 };
+
+    /// Waits that completed in the yield phase
+    uint64_t yield_hits = { 0 };
+
+    /// Waits that completed in the block (or, for SLEEP, sleep) phase
+    uint64_t block_hits = { 0 };
+
+    /// Total number of times the thread blocked or slept
+    uint64_t n_blocks = { 0 };
+};
+
+/// CPU hint that the caller is in a spin-wait loop
+inline void cpuRelax() {
+    #if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+    #else
+    std::this_thread::yield();
+    #endif
+}
+
+/**
+ * @brief Blocks until the condition holds, following the given wait policy
+ *
+ * @param cond Condition to wait for; called repeatedly, so it should be cheap (e.g., a register or writeback read)
+ * @param policy Wait policy
+ * @param stats Counters, updated according to the phase the wait completed in
+ * @param efd Eventfd to block on in the SPIN_BLOCK mode; if -1, the thread sleeps for block_ns instead
+ */
+template <typename Cond>
+inline void waitFor(Cond cond, const waitPolicy &policy, waitStats &stats, int32_t efd = -1) {
+    if (cond()) {
+        return;
+    }
+    stats.n_waits++;
+
+    if (policy.mode == CoyoteWait::SLEEP) {
+        do {
+            stats.n_blocks++;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(SLEEP_TIME));
+        } while (!cond());
+        stats.block_hits++;
+        return;
+    }
+
+    // Spin phase; pure spinning never leaves it
+    for (uint32_t i = 0; policy.mode == CoyoteWait::SPIN || i < policy.spin_iters; i++) {
+        cpuRelax();
+        if (cond()) {
+            stats.spin_hits++;
+            return;
+        }
+    }
+
+    // Yield phase; unbounded for SPIN_YIELD
+    for (uint32_t i = 0; policy.mode == CoyoteWait::SPIN_YIELD || i < policy.yield_iters; i++) {
+        std::this_thread::yield();
+        if (cond()) {
+            stats.yield_hits++;
+            return;
+        }
+    }
+
+    // Block phase; the eventfd allows a notifier to cut the timeout short
+    struct timespec timeout = { policy.block_ns / 1000000000L, policy.block_ns % 1000000000L };
+    do {
+        stats.n_blocks++;
+        if (efd != -1) {
+            struct pollfd pfd = { efd, POLLIN, 0 };
+            if (ppoll(&pfd, 1, &timeout, nullptr) > 0) {
+                eventfd_t val;
+                eventfd_read(efd, &val);
+            }
+        } else {
+            nanosleep(&timeout, nullptr);
+        }
+    } while (!cond());
+    stats.block_hits++;
+}
+
+}
+
+#endif // _COYOTE_CWAIT_HPP_
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cCompletionQueue.hpp>
+
+namespace coyote {
+
+/// Inverse of getWbackIndex(...): an operation whose completions are tracked by the given writeback counter
+static CoyoteOper wbackOper(int32_t idx) {
+    switch (idx) {
+        case RD_WBACK: return CoyoteOper::LOCAL_READ;
+        case WR_WBACK: return CoyoteOper::LOCAL_WRITE;
+        case RD_RDMA_WBACK: return CoyoteOper::REMOTE_RDMA_READ;
+        default: return CoyoteOper::REMOTE_RDMA_WRITE;
+    }
+}
+
+cCompletionQueue::cCompletionQueue(std::chrono::nanoseconds poll_interval): 
+    n_pending(0), n_completed(0), poll_interval(poll_interval), stop(false) {
+    poller = std::thread(&cCompletionQueue::pollLoop, this);
+}
+
+cCompletionQueue::~cCompletionQueue() {
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+
+    if (poller.joinable()) {
+        poller.join();
+    }
+}
+
+void cCompletionQueue::add(cThread *thread, CoyoteOper oper, uint32_t seq, std::function<void()> callback) {
+    int32_t idx = getWbackIndex(oper);
+    if (idx == -1) {
+        throw std::runtime_error("ERROR: cCompletionQueue::add() called for an operation without a completion counter");
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        pending[std::make_pair(thread, idx)].push_back({seq, std::move(callback)});
+        n_pending++;
+    }
+    cv.notify_all();
+}
+
+std::future<void> cCompletionQueue::add(cThread *thread, CoyoteOper oper, uint32_t seq) {
+    // std::function requires a copyable callable, hence the shared promise
+    auto promise = std::make_shared<std::promise<void>>();
+    std::future<void> future = promise->get_future();
+    add(thread, oper, seq, [promise]() { promise->set_value(); });
+    return future;
+}
+
+void cCompletionQueue::remove(cThread *thread) {
+    std::lock_guard<std::mutex> lck(mtx);
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->first.first == thread) {
+            n_pending -= it->second.size();
+            it = pending.erase(it);
+        } else {
+            it++;
+        }
+    }
+    cv.notify_all();
+}
+
+void cCompletionQueue::drain() {
+    std::unique_lock<std::mutex> lck(mtx);
+    cv.wait(lck, [this] { return n_pending == 0 || stop; });
+}
+
+uint32_t cCompletionQueue::getPending() const { return n_pending; }
+
+uint64_t cCompletionQueue::getCompleted() const { return n_completed; }
+
+void cCompletionQueue::pollLoop() {
+    std::vector<std::function<void()>> ready;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            cv.wait(lck, [this] { return n_pending > 0 || stop; });
+            if (stop) {
+                return;
+            }
+
+            // One pass: read every counter once and move all completed operations out of the pending lists
+            for (auto it = pending.begin(); it != pending.end();) {
+                uint32_t completed = it->first.first->checkCompleted(wbackOper(it->first.second));
+
+                std::vector<cqEntry> &entries = it->second;
+                auto done = std::stable_partition(entries.begin(), entries.end(), [completed](const cqEntry &e) {
+                    return static_cast<int32_t>(completed - e.seq) < 0;
+                });
+                for (auto e = done; e != entries.end(); e++) {
+                    ready.push_back(std::move(e->callback));
+                }
+                entries.erase(done, entries.end());
+
+                if (entries.empty()) {
+                    it = pending.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+
+        // Callbacks are fired outside of the lock, so that they can register new operations
+        for (auto &callback : ready) {
+            callback();
+        }
+
+        if (!ready.empty()) {
+            n_completed += ready.size();
+            n_pending -= ready.size();
+            ready.clear();
+
+            // Wake up drain()
+            std::lock_guard<std::mutex> lck(mtx);
+            cv.notify_all();
+        } else if (poll_interval.count() > 0) {
+            std::this_thread::sleep_for(poll_interval);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}
@@ -28,7 +28,7 @@
 
 namespace coyote {      
     
-cConn::cConn(std::string sock_name) {  
+cConn::cConn(std::string sock_name, bool shm_ring) {  
     DBG3("cConn: Called the constructor for a local connection (AF_UNIX), sock_name" << sock_name); 
 
     // Open a socket and try to connect it to the server
@@ -59,9 +59,15 @@ cConn::cConn(std::string sock_name) {
         throw std::runtime_error("ERROR: Failed to send PID to the server");
     }
 
+    // Negotiate the shared-memory queues before the completion thread starts reading from the socket
+    if (shm_ring) {
+        setupRing();
+    }
+
     /// Initialize the completion listener thread & the rest of the variables
     run_thread = true;
     task_counter = 0;
+    region_counter = 0;
     completion_thread = std::thread(&cConn::checkCompletedTasks, this);
     std::cout << "Client connected" << std::endl;
 }
@@ -77,58 +83,326 @@ cConn::~cConn() {
      */
     int32_t req[3];
     req[0] = DEF_OP_CLOSE_CONN;
-    if (write(sockfd, &req, 3 * sizeof(int32_t)) != 3 * sizeof(int32_t)) {
-        std::cerr << "ERROR: Failed to send close connection request to the server" << std::endl;
+    {
+        std::lock_guard<std::mutex> lck(submit_lock);
+        if (write(sockfd, &req, 3 * sizeof(int32_t)) != 3 * sizeof(int32_t)) {
+            std::cerr << "ERROR: Failed to send close connection request to the server" << std::endl;
+        }
     }
-    close(sockfd);
-    std::cout << "Successfully closed connection to the server" << std::endl;
 
-    // Terminate completion thread
+    // Terminate completion thread; shutting down the socket wakes it up
     run_thread = false;
+    shutdown(sockfd, SHUT_RDWR);
     if (completion_thread.joinable()) {
         completion_thread.join();
     }
+    close(sockfd);
+    ring.reset();
+    std::cout << "Successfully closed connection to the server" << std::endl;
+
+    // Tasks still in flight will never complete; fail their futures and callbacks
+    std::unordered_map<int32_t, pendingTask> unfinished;
+    {
+        std::lock_guard<std::mutex> lck(tlock);
+        unfinished.swap(pending);
+    }
+    for (auto &[tid, p] : unfinished) {
+        p.handler(tid, 1, {});
+    }
+
+    for (auto &[id, region] : regions) {
+        munmap(region.data, region.size);
+    }
+}
+
+void cConn::setupRing() {
+    int32_t req[3];
+    req[0] = DEF_OP_SHM_RING;
+    req[1] = 0;
+    req[2] = -1;
+    if (write(sockfd, &req, 3 * sizeof(int32_t)) != 3 * sizeof(int32_t)) {
+        throw std::runtime_error("ERROR: Failed to send request to server");
+    }
+
+    // Response (return code, task ID), with the memfd and the event file descriptors attached on success
+    // The server always responds; since the completion thread isn't running yet, the response is read here, with its file descriptors
+    int32_t resp[2];
+    int fds[3];
+    struct iovec iov = { resp, sizeof(resp) };
+    char ctrl[CMSG_SPACE(sizeof(fds))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    if (recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL) != sizeof(resp)) {
+        throw std::runtime_error("ERROR: Failed to read response from server");
+    }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    bool has_fds = cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && 
+                   cmsg->cmsg_len == CMSG_LEN(sizeof(fds));
+    if (has_fds) {
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    }
+
+    if (resp[0] != 0 || !has_fds) {
+        DBG1("cConn: Server could not set up shared memory queues, using the socket; return code: " << resp[0]); 
+        return;
+    }
+
+    ring = std::make_unique<cShmRing>(fds[0], fds[1], fds[2]);
+    DBG1("cConn: Using shared memory queues"); 
+}
+
+void cConn::submitTasks(int32_t fid, const std::vector<std::pair<int32_t, std::vector<char>>> &reqs) {
+    std::lock_guard<std::mutex> lck(submit_lock);
+    size_t n_ring = 0;
+    if (ring != nullptr) {
+        while (n_ring < reqs.size() && ring->submit(fid, reqs[n_ring].first, reqs[n_ring].second.data(), reqs[n_ring].second.size(), false)) {
+            n_ring++;
+        }
+        if (n_ring > 0) {
+            ring->kick();
+        }
+    }
+    if (n_ring == reqs.size()) {
+        return;
+    }
+
+    // Send opcode, function ID and task ID, followed by the arguments, for each of the remaining tasks
+    std::vector<char> buf;
+    for (size_t i = n_ring; i < reqs.size(); i++) {
+        int32_t req[3];
+        req[0] = DEF_OP_SUBMIT_TASK;
+        req[1] = fid;
+        req[2] = reqs[i].first;
+        const char *p = reinterpret_cast<const char*>(req);
+        buf.insert(buf.end(), p, p + 3 * sizeof(int32_t));
+        buf.insert(buf.end(), reqs[i].second.begin(), reqs[i].second.end());
+    }
+
+    size_t sent = 0;
+    while (sent < buf.size()) {
+        ssize_t n = write(sockfd, buf.data() + sent, buf.size() - sent);
+        if (n <= 0 && errno != EINTR) {
+            // The tasks were not (completely) sent, so they will never complete
+            std::lock_guard<std::mutex> tlck(tlock);
+            for (size_t i = n_ring; i < reqs.size(); i++) {
+                tasks.erase(reqs[i].first);
+                pending.erase(reqs[i].first);
+            }
+            throw std::runtime_error("ERROR: Failed to send request to server");
+        }
+        sent += n > 0 ? n : 0;
+    }
+}
+
+int32_t cConn::addHandler(size_t ret_size, cmplHandler handler) {
+    int32_t tid = task_counter++;
+    std::lock_guard<std::mutex> lck(tlock);
+    pending.emplace(tid, pendingTask{ret_size, std::move(handler)});
+    return tid;
+}
+
+void cConn::completeTask(int32_t tid, int32_t ret_code, const std::vector<char> &ret_val) {
+    cmplHandler handler;
+    {
+        std::lock_guard<std::mutex> lck(tlock);
+        auto p = pending.find(tid);
+        if (p != pending.end()) {
+            handler = std::move(p->second.handler);
+            pending.erase(p);
+        } else if (tasks.find(tid) != tasks.end()) {
+            // Only store the return value if the return code is zero
+            if (ret_code == 0) {
+                tasks[tid]->setRetVal(ret_val);
+            }
+            tasks[tid]->setRetCode(ret_code);
+            tasks[tid]->setCompleted(true);
+        }
+    }
+
+    // Handlers are called without the lock, so that they can submit further tasks
+    if (handler) {
+        handler(tid, ret_code, ret_val);
+    }
+}
+
+int32_t cConn::sendControl(int32_t opcode, int32_t arg, int fd) {
+    auto promise = std::make_shared<std::promise<int32_t>>();
+    std::future<int32_t> result = promise->get_future();
+    int32_t tid = addHandler(0, [promise](int32_t, int32_t ret_code, const std::vector<char> &) {
+        promise->set_value(ret_code);
+    });
+
+    int32_t req[3];
+    req[0] = opcode;
+    req[1] = arg;
+    req[2] = tid;
+    struct iovec iov = { req, sizeof(req) };
+    char ctrl[CMSG_SPACE(sizeof(int))];
+    memset(ctrl, 0, sizeof(ctrl));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd != -1) {
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(submit_lock);
+        if (sendmsg(sockfd, &msg, MSG_NOSIGNAL) != sizeof(req)) {
+            std::lock_guard<std::mutex> tlck(tlock);
+            pending.erase(tid);
+            throw std::runtime_error("ERROR: Failed to send request to server");
+        }
+    }
+
+    return result.get();
+}
+
+cBuffer cConn::allocBuffer(size_t size) {
+    int fd = memfd_create("coyote-buffer", MFD_CLOEXEC);
+    if (fd == -1 || size == 0 || ftruncate(fd, size)) {
+        if (fd != -1) { close(fd); }
+        throw std::runtime_error("ERROR: Failed to allocate shared buffer of size " + std::to_string(size));
+    }
+
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("ERROR: Failed to map shared buffer of size " + std::to_string(size));
+    }
+
+    // The service maps the region before any task can use it, since the response is awaited here
+    int32_t region = region_counter++;
+    int32_t ret_code = 1;
+    try {
+        ret_code = sendControl(DEF_OP_REG_BUFFER, region, fd);
+    } catch (...) {
+        close(fd);
+        munmap(mem, size);
+        throw;
+    }
+    close(fd);
+    if (ret_code != 0) {
+        munmap(mem, size);
+        throw std::runtime_error("ERROR: Server could not map shared buffer, region " + std::to_string(region));
+    }
+
+    cBuffer buf{ mem, size, region, 0 };
+    std::lock_guard<std::mutex> lck(region_lock);
+    regions.emplace(region, buf);
+    return buf;
+}
+
+void cConn::freeBuffer(const cBuffer &buf) {
+    cBuffer region;
+    {
+        std::lock_guard<std::mutex> lck(region_lock);
+        auto it = regions.find(buf.region);
+        if (it == regions.end()) {
+            throw std::runtime_error("ERROR: Buffer was not allocated with allocBuffer(), region " + std::to_string(buf.region));
+        }
+        region = it->second;
+        regions.erase(it);
+    }
+
+    if (sendControl(DEF_OP_UNREG_BUFFER, region.region) != 0) {
+        std::cerr << "ERROR: Server could not release shared buffer, region " << region.region << std::endl;
+    }
+    munmap(region.data, region.size);
+}
+
+void cConn::resolveBuffer(cBuffer &buf) {
+    std::lock_guard<std::mutex> lck(region_lock);
+    auto it = regions.find(buf.region);
+    if (it == regions.end() || buf.offset > it->second.size || buf.size > it->second.size - buf.offset) {
+        throw std::runtime_error("ERROR: Server returned a buffer outside the allocated buffers, region " + std::to_string(buf.region));
+    }
+    buf.data = static_cast<char*>(it->second.data) + buf.offset;
+}
+
+size_t cConn::getRetValSize(int32_t tid) {
+    std::lock_guard<std::mutex> lck(tlock);
+    auto p = pending.find(tid);
+    if (p != pending.end()) {
+        return p->second.ret_size;
+    }
+    auto t = tasks.find(tid);
+    return t != tasks.end() ? t->second->getRetValSize() : 0;
 }
 
 void cConn::checkCompletedTasks() {
     DBG3("cConn: Starting the completion listener thread");
     
     while (run_thread) {
-        // Check if the server wrote the task ID and the completion code; if yes, process task completion
+        // Sleep until the server writes to the socket or signals the completion queue
+        struct pollfd fds[2] = {
+            { sockfd, POLLIN, 0 }, 
+            { ring != nullptr ? ring->getCompletionFd() : -1, POLLIN, 0 }
+        };
+        if (poll(fds, 2, CLIENT_POLL_TIMEOUT) <= 0) {
+            continue;
+        }
+
+        // Completions in shared memory
+        if (fds[1].revents & POLLIN) {
+            eventfd_t cnt;
+            eventfd_read(ring->getCompletionFd(), &cnt);
+
+            shmRingEntry entry;
+            while (ring->popCompletion(entry)) {
+                completeTask(entry.tid, entry.code, std::vector<char>(entry.data, entry.data + entry.len));
+            }
+        }
+
+        if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+            continue;
+        }
+
+        // Read whatever the server sent; responses may be split across reads
         char recv_buff[RECV_BUFF_SIZE];
-        if (read(sockfd, recv_buff, 2 * sizeof(int32_t)) == 2 * sizeof(int32_t)) {
+        ssize_t n = read(sockfd, recv_buff, RECV_BUFF_SIZE);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) { continue; }
+            // Connection closed
+            break;
+        }
+        recv_buf.insert(recv_buf.end(), recv_buff, recv_buff + n);
 
+        // Each response is the return code and the task ID, followed by the return value if the return code is zero
+        size_t offset = 0;
+        while (recv_buf.size() - offset >= 2 * sizeof(int32_t)) {
             int32_t task_id, ret_code;
-            memcpy(&ret_code, recv_buff, sizeof(int32_t));
-            memcpy(&task_id, recv_buff + sizeof(int32_t), sizeof(int32_t));
-            if (tasks.find(task_id) != tasks.end()) {
-                // Task exists & ret_code is zero; receive the return value from the server
-                if (ret_code == 0) {
-                    size_t ret_val_size = tasks[task_id]->getRetValSize();
-                    if (read(sockfd, recv_buff, ret_val_size) != ret_val_size) {
-                        throw std::runtime_error("ERROR: Failed to read return value from server, tid " + std::to_string(task_id));
-                    }
-                    std::vector<char> ret_val(recv_buff, recv_buff + ret_val_size);
-                    tasks[task_id]->setRetVal(ret_val);
-                    tasks[task_id]->setRetCode(ret_code);
-                    tasks[task_id]->setCompleted(true);
-
-                // Task exists, but server sent non-zero return code; mark as completed but don't store return value
-                } else {
-                    tasks[task_id]->setRetCode(ret_code);
-                    tasks[task_id]->setCompleted(true);
-                }
-            }   
-            
+            memcpy(&ret_code, recv_buf.data() + offset, sizeof(int32_t));
+            memcpy(&task_id, recv_buf.data() + offset + sizeof(int32_t), sizeof(int32_t));
+            size_t ret_val_size = ret_code == 0 ? getRetValSize(task_id) : 0;
+            if (recv_buf.size() - offset < 2 * sizeof(int32_t) + ret_val_size) {
+                break;
+            }
+
+            auto ret_val_start = recv_buf.begin() + offset + 2 * sizeof(int32_t);
+            completeTask(task_id, ret_code, std::vector<char>(ret_val_start, ret_val_start + ret_val_size));
+            offset += 2 * sizeof(int32_t) + ret_val_size;
         }
-        
-        std::this_thread::sleep_for(std::chrono::microseconds(SLEEP_INTERVAL_CLIENT_CONN_MANAGER)); 
+        recv_buf.erase(recv_buf.begin(), recv_buf.begin() + offset);
     }
 
     DBG3("cConn: Completion thread stopped");
 }
 
 bool cConn::isTaskCompleted(int32_t tid) {
+    std::lock_guard<std::mutex> lck(tlock);
     if (tasks.find(tid) != tasks.end()) {
         return tasks[tid]->isCompleted();
     } else {
@@ -0,0 +1,269 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cDevSched.hpp>
+
+namespace coyote {
+
+std::map<uint32_t, cDevSched*> coyote::cDevSched::dev_schedulers;
+
+cDevSched::cDevSched(uint32_t device, std::vector<int32_t> vfids, bool reorder): device(device), rcnfg_load_thr(UINT32_MAX), cmpl_fd(-1) {
+    if (vfids.empty()) {
+        throw std::runtime_error("ERROR: cDevSched - at least one vFPGA must be managed");
+    }
+
+    for (int32_t vfid : vfids) {
+        regions.emplace(vfid, cSched::getInstance(vfid, device, reorder));
+    }
+}
+
+void cDevSched::start() {
+    for (auto &region : regions) {
+        region.second->start();
+    }
+}
+
+void cDevSched::stop() {
+    for (auto &region : regions) {
+        region.second->stop();
+    }
+}
+
+int cDevSched::addFunction(std::function<std::unique_ptr<bFunc>(int32_t)> make_fn) {
+    for (auto &region : regions) {
+        int ret = region.second->addFunction(make_fn(region.first));
+        if (ret) {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+int32_t cDevSched::route(int32_t fid) {
+    int32_t match = -1, any = -1;
+    uint32_t match_load = UINT32_MAX, any_load = UINT32_MAX;
+
+    for (auto &region : regions) {
+        bFunc *fn = region.second->getFunction(fid);
+        if (fn == nullptr) {
+            continue;
+        }
+
+        // A vFPGA matches if it holds the bitstream, or will load it for the queued tasks of the same function
+        uint32_t load = region.second->getLoad();
+        bool holds = region.second->getCurrentBitstream() == fn->getBitstreamPath() || region.second->getLoad(fid) > 0;
+        if (holds && load < match_load) {
+            match = region.first;
+            match_load = load;
+        }
+        if (load < any_load) {
+            any = region.first;
+            any_load = load;
+        }
+    }
+
+    // Reconfigure only if no vFPGA matches, or all the matching ones are too busy and there is an idle one
+    if (match != -1 && (match_load < rcnfg_load_thr || any_load > 0)) {
+        return match;
+    }
+    return any;
+}
+
+int32_t cDevSched::addTask(std::unique_ptr<cTask> task, pid_t hpid) {
+    if (task == nullptr) {
+        syslog(LOG_WARNING, "Task is null, cannot add to device scheduler");
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lck(mtx);
+    int32_t tid = task->getTid();
+    if (placements.find(tid) != placements.end()) {
+        syslog(LOG_WARNING, "Task with ID %d already exists in the device scheduler", tid);
+        return -1;
+    }
+
+    int32_t vfid = route(task->getFid());
+    if (vfid == -1) {
+        syslog(LOG_WARNING, "Function for task %d with fid %d is not registered with any vFPGA", tid, task->getFid());
+        return -1;
+    }
+
+    // cThread of the client on the chosen vFPGA, created on first use
+    auto key = std::make_pair(vfid, hpid);
+    if (cthreads.find(key) == cthreads.end()) {
+        try {
+            cthreads.emplace(key, std::make_unique<cThread>(vfid, hpid, device));
+        } catch (const std::exception &e) {
+            syslog(LOG_ERR, "Could not create cThread for vfid %d, pid %d: %s", vfid, hpid, e.what());
+            return -1;
+        }
+    }
+    task->setCThread(cthreads[key].get());
+
+    if (!regions[vfid]->addTask(std::move(task))) {
+        return -1;
+    }
+    placements.emplace(tid, taskPlacement{vfid, hpid});
+    syslog(LOG_NOTICE, "Placed task with ID %d on vfid %d", tid, vfid);
+    return vfid;
+}
+
+int cDevSched::getCompletionFd() {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (cmpl_fd != -1) {
+        return cmpl_fd;
+    }
+
+    cmpl_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (cmpl_fd == -1) {
+        throw std::runtime_error("ERROR: cDevSched - failed to create completion epoll instance, device: " + std::to_string(device));
+    }
+    for (auto &region : regions) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = region.second->getCompletionFd();
+        if (epoll_ctl(cmpl_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) == -1) {
+            throw std::runtime_error("ERROR: cDevSched - failed to register completion event of vfid: " + std::to_string(region.first));
+        }
+    }
+    return cmpl_fd;
+}
+
+std::vector<int32_t> cDevSched::takeCompleted() {
+    std::vector<int32_t> tids;
+    for (auto &region : regions) {
+        // The event is consumed before collecting the tasks, so that later completions signal it again
+        eventfd_t cnt;
+        eventfd_read(region.second->getCompletionFd(), &cnt);
+
+        std::vector<int32_t> completed = region.second->takeCompleted();
+        tids.insert(tids.end(), completed.begin(), completed.end());
+    }
+    return tids;
+}
+
+bFunc* cDevSched::getFunction(int32_t fid) {
+    cSched *sched = regions.begin()->second;
+    return sched->isFunctionRegistered(fid) ? sched->getFunction(fid) : nullptr;
+}
+
+bool cDevSched::isTaskCompleted(int32_t tid) {
+    std::lock_guard<std::mutex> lck(mtx);
+    auto it = placements.find(tid);
+    return it != placements.end() && regions[it->second.vfid]->isTaskCompleted(tid);
+}
+
+cTask* cDevSched::getTask(int32_t tid) {
+    std::lock_guard<std::mutex> lck(mtx);
+    auto it = placements.find(tid);
+    if (it != placements.end()) {
+        return regions[it->second.vfid]->getTask(tid);
+    }
+
+    // As with cSched, a released task is still returned until it is reclaimed, once it completes
+    for (auto &client : draining) {
+        for (auto &[draining_tid, vfid] : client.second) {
+            if (draining_tid == tid) {
+                return regions[vfid]->getTask(tid);
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool cDevSched::releaseTask(int32_t tid) {
+    std::lock_guard<std::mutex> lck(mtx);
+    auto it = placements.find(tid);
+    if (it == placements.end()) {
+        return false;
+    }
+
+    // Running tasks are reclaimed by the cSched once they complete; if the client is released 
+    // in the meantime, its cThreads are kept until then (see releaseClient)
+    cSched *sched = regions[it->second.vfid];
+    bool running = !sched->isTaskCompleted(tid);
+    sched->releaseTask(tid);
+    if (running && sched->getTask(tid) != nullptr) {
+        draining[it->second.hpid].emplace_back(tid, it->second.vfid);
+    }
+    placements.erase(it);
+    return true;
+}
+
+bool cDevSched::releaseClient(pid_t hpid) {
+    std::vector<int32_t> tids;
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        for (auto &placement : placements) {
+            if (placement.second.hpid == hpid) {
+                tids.push_back(placement.first);
+            }
+        }
+    }
+
+    for (int32_t tid : tids) {
+        releaseTask(tid);
+    }
+
+    std::lock_guard<std::mutex> lck(mtx);
+    auto &tasks = draining[hpid];
+    tasks.erase(
+        std::remove_if(tasks.begin(), tasks.end(), [&](const std::pair<int32_t, int32_t> &t) { 
+            return regions[t.second]->getTask(t.first) == nullptr; 
+        }),
+        tasks.end()
+    );
+    if (!tasks.empty()) {
+        syslog(LOG_NOTICE, "Client with pid %d still has %ld running tasks, keeping its cThreads", hpid, tasks.size());
+        return false;
+    }
+    draining.erase(hpid);
+
+    for (auto &region : regions) {
+        cthreads.erase(std::make_pair(region.first, hpid));
+    }
+    return true;
+}
+
+void cDevSched::setRcnfgLoadThreshold(uint32_t thr) {
+    std::lock_guard<std::mutex> lck(mtx);
+    rcnfg_load_thr = thr;
+}
+
+std::map<int32_t, std::string> cDevSched::getBitstreams() {
+    std::map<int32_t, std::string> bitstreams;
+    for (auto &region : regions) {
+        bitstreams.emplace(region.first, region.second->getCurrentBitstream());
+    }
+    return bitstreams;
+}
+
+cSched* cDevSched::getScheduler(int32_t vfid) {
+    auto it = regions.find(vfid);
+    return it != regions.end() ? it->second : nullptr;
+}
+
+}
@@ -0,0 +1,370 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+
+#include <coyote/cMemArena.hpp>
+
+namespace coyote {
+
+/// Slab size; every slab serves blocks of a single size class
+static constexpr uint64_t SLAB_SIZE = HUGE_PAGE_SIZE;
+
+/// Smallest size class, 64B (one cache line)
+static constexpr uint32_t MIN_CLASS_SHIFT = 6;
+
+/// Number of size classes, 64B to SLAB_SIZE
+static constexpr uint32_t N_CLASSES = HUGE_PAGE_SHIFT - MIN_CLASS_SHIFT + 1;
+
+/// Marks a slab that hasn't been assigned to a size class yet
+static constexpr uint8_t NO_CLASS = 0xff;
+
+/// Maximum number of blocks of each size class kept in a thread cache, and the number of blocks moved on refill/drain
+static constexpr size_t CACHE_MAX = 64;
+static constexpr size_t CACHE_BATCH = 32;
+
+static inline uint32_t sizeClass(size_t size) {
+    uint32_t shift = MIN_CLASS_SHIFT;
+    while ((1ULL << shift) < size) {
+        shift++;
+    }
+    return shift - MIN_CLASS_SHIFT;
+}
+
+static inline uint64_t classSize(uint32_t cls) {
+    return 1ULL << (cls + MIN_CLASS_SHIFT);
+}
+
+struct cMemArena::arenaState {
+    struct region {
+        uint64_t base;
+        uint64_t size;
+        uint32_t next_slab;
+        std::unique_ptr<std::atomic<uint8_t>[]> slab_class;
+    };
+
+    cThread *thread;
+    CoyoteAllocType type;
+    uint32_t region_size;
+    uint32_t max_regions;
+
+    /// Protects free_lists, large and region growth; regions are only appended, so lookups don't need the lock
+    mutable std::mutex mtx;
+
+    std::vector<void*> free_lists[N_CLASSES];
+    std::unique_ptr<region[]> regions;
+    std::atomic<uint32_t> n_regions = { 0 };
+    std::unordered_map<void*, uint64_t> large;
+
+    std::atomic<uint64_t> reserved = { 0 };
+    std::atomic<uint64_t> in_use = { 0 };
+    std::atomic<uint64_t> high_water = { 0 };
+    std::atomic<uint64_t> large_bytes = { 0 };
+    std::atomic<uint64_t> slab_bytes = { 0 };
+    std::atomic<uint64_t> total_requested = { 0 };
+    std::atomic<uint64_t> total_allocated = { 0 };
+    std::atomic<uint64_t> n_allocs = { 0 };
+    std::atomic<uint64_t> n_large_allocs = { 0 };
+
+    arenaState(cThread *thread, CoyoteAllocType type, uint32_t region_size, uint32_t max_regions) :
+        thread(thread), type(type), max_regions(max_regions), regions(new region[max_regions]) {
+        this->region_size = ((region_size + SLAB_SIZE - 1) / SLAB_SIZE) * SLAB_SIZE;
+    }
+
+    /// Size class of the slab the pointer belongs to; -1 if it is not in any region
+    int32_t lookupClass(const void *ptr) const {
+        uint64_t addr = reinterpret_cast<uint64_t>(ptr);
+        uint32_t n = n_regions.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; i++) {
+            if (addr >= regions[i].base && addr < regions[i].base + regions[i].size) {
+                uint8_t cls = regions[i].slab_class[(addr - regions[i].base) / SLAB_SIZE].load(std::memory_order_relaxed);
+                return cls == NO_CLASS ? -1 : cls;
+            }
+        }
+        return -1;
+    }
+
+    /// Obtains a new region from the cThread; called with the lock held
+    bool grow() {
+        uint32_t n = n_regions.load(std::memory_order_relaxed);
+        if (n == max_regions) {
+            return false;
+        }
+
+        void *mem = nullptr;
+        if (type == CoyoteAllocType::HPF) {
+            try {
+                mem = thread->getMem({CoyoteAllocType::HPF, region_size});
+            } catch (const std::runtime_error &e) {
+                DBG1("cMemArena: Hugepage region allocation failed, falling back to transparent huge pages");
+                type = CoyoteAllocType::THP;
+            }
+        }
+        if (!mem) {
+            mem = thread->getMem({CoyoteAllocType::THP, region_size});
+        }
+        if (!mem) {
+            return false;
+        }
+
+        region &r = regions[n];
+        r.base = reinterpret_cast<uint64_t>(mem);
+        r.size = region_size;
+        r.next_slab = 0;
+        r.slab_class.reset(new std::atomic<uint8_t>[region_size / SLAB_SIZE]);
+        for (uint32_t i = 0; i < region_size / SLAB_SIZE; i++) {
+            r.slab_class[i].store(NO_CLASS, std::memory_order_relaxed);
+        }
+
+        reserved += region_size;
+        n_regions.store(n + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Assigns a fresh slab to a size class and splits it into blocks; called with the lock held
+    bool carveSlab(uint32_t cls) {
+        uint32_t n = n_regions.load(std::memory_order_relaxed);
+        if (n == 0 || regions[n - 1].next_slab == regions[n - 1].size / SLAB_SIZE) {
+            if (!grow()) {
+                return false;
+            }
+            n++;
+        }
+
+        region &r = regions[n - 1];
+        uint64_t slab = r.base + r.next_slab * SLAB_SIZE;
+        r.slab_class[r.next_slab].store(cls, std::memory_order_relaxed);
+        r.next_slab++;
+        slab_bytes += SLAB_SIZE;
+
+        // Pushed in reverse, so that blocks are handed out in address order
+        for (uint64_t offs = SLAB_SIZE; offs > 0; offs -= classSize(cls)) {
+            free_lists[cls].push_back(reinterpret_cast<void*>(slab + offs - classSize(cls)));
+        }
+        return true;
+    }
+
+    /// Moves up to n blocks of a size class to out
+    void refill(uint32_t cls, std::vector<void*> &out, size_t n) {
+        std::lock_guard<std::mutex> lck(mtx);
+        if (free_lists[cls].empty() && !carveSlab(cls)) {
+            return;
+        }
+
+        std::vector<void*> &fl = free_lists[cls];
+        size_t cnt = std::min(n, fl.size());
+        out.insert(out.end(), fl.end() - cnt, fl.end());
+        fl.resize(fl.size() - cnt);
+    }
+
+    /// Returns the last n blocks of in to the arena
+    void release(uint32_t cls, std::vector<void*> &in, size_t n) {
+        std::lock_guard<std::mutex> lck(mtx);
+        free_lists[cls].insert(free_lists[cls].end(), in.end() - n, in.end());
+        in.resize(in.size() - n);
+    }
+
+    void addInUse(uint64_t bytes) {
+        uint64_t cur = in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        uint64_t hw = high_water.load(std::memory_order_relaxed);
+        while (cur > hw && !high_water.compare_exchange_weak(hw, cur, std::memory_order_relaxed)) {}
+    }
+};
+
+/**
+ * Per-thread cache of free blocks, for every arena the thread used
+ *
+ * Entries are keyed by the arena state and hold a weak reference to it, so that a stale entry of a destroyed
+ * arena (whose address may be reused by a new one) is detected and discarded. On thread exit, the cached blocks
+ * are returned to the arenas that are still alive.
+ */
+struct threadCache {
+    struct entry {
+        std::weak_ptr<cMemArena::arenaState> arena;
+        std::vector<void*> bins[N_CLASSES];
+    };
+
+    std::unordered_map<const cMemArena::arenaState*, entry> entries;
+
+    entry& get(const std::shared_ptr<cMemArena::arenaState> &arena) {
+        entry &e = entries[arena.get()];
+        if (e.arena.lock() != arena) {
+            e = entry();
+            e.arena = arena;
+        }
+        return e;
+    }
+
+    void flush(entry &e) {
+        if (auto arena = e.arena.lock()) {
+            for (uint32_t cls = 0; cls < N_CLASSES; cls++) {
+                if (!e.bins[cls].empty()) {
+                    arena->release(cls, e.bins[cls], e.bins[cls].size());
+                }
+            }
+        }
+    }
+
+    ~threadCache() {
+        for (auto &it : entries) {
+            flush(it.second);
+        }
+    }
+};
+
+static thread_local threadCache tcache;
+
+cMemArena::cMemArena(cThread *thread, CoyoteAllocType type, uint32_t region_size, uint32_t max_regions) {
+    if (type != CoyoteAllocType::HPF && type != CoyoteAllocType::THP) {
+        throw std::runtime_error("ERROR: cMemArena only supports HPF and THP regions");
+    }
+    if (region_size == 0 || max_regions == 0) {
+        throw std::runtime_error("ERROR: cMemArena region size and number of regions must be non-zero");
+    }
+    state = std::make_shared<arenaState>(thread, type, region_size, max_regions);
+}
+
+cMemArena::~cMemArena() {
+    std::lock_guard<std::mutex> lck(state->mtx);
+    for (uint32_t i = 0; i < state->n_regions.load(); i++) {
+        state->thread->freeMem(reinterpret_cast<void*>(state->regions[i].base));
+    }
+    for (auto &it : state->large) {
+        state->thread->freeMem(it.first);
+    }
+}
+
+void* cMemArena::allocate(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    // Large allocations bypass the slabs
+    if (size > SLAB_SIZE) {
+        if (size > UINT32_MAX) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lck(state->mtx);
+        void *mem = nullptr;
+        try {
+            mem = state->thread->getMem({state->type, static_cast<uint32_t>(size)});
+        } catch (const std::runtime_error &e) {
+            mem = state->thread->getMem({CoyoteAllocType::THP, static_cast<uint32_t>(size)});
+        }
+        if (mem) {
+            state->large.emplace(mem, size);
+            state->reserved += size;
+            state->large_bytes += size;
+            state->addInUse(size);
+            state->total_requested += size;
+            state->total_allocated += size;
+            state->n_allocs++;
+            state->n_large_allocs++;
+        }
+        return mem;
+    }
+
+    uint32_t cls = sizeClass(size);
+    std::vector<void*> &bin = tcache.get(state).bins[cls];
+    if (bin.empty()) {
+        state->refill(cls, bin, CACHE_BATCH);
+        if (bin.empty()) {
+            return nullptr;
+        }
+    }
+
+    void *mem = bin.back();
+    bin.pop_back();
+
+    state->addInUse(classSize(cls));
+    state->total_requested.fetch_add(size, std::memory_order_relaxed);
+    state->total_allocated.fetch_add(classSize(cls), std::memory_order_relaxed);
+    state->n_allocs.fetch_add(1, std::memory_order_relaxed);
+    return mem;
+}
+
+void cMemArena::free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    int32_t cls = state->lookupClass(ptr);
+    if (cls == -1) {
+        std::lock_guard<std::mutex> lck(state->mtx);
+        auto it = state->large.find(ptr);
+        if (it == state->large.end()) {
+            throw std::runtime_error("ERROR: cMemArena::free() called for a buffer that was not allocated by this arena");
+        }
+
+        state->thread->freeMem(ptr);
+        state->reserved -= it->second;
+        state->large_bytes -= it->second;
+        state->in_use -= it->second;
+        state->large.erase(it);
+        return;
+    }
+
+    std::vector<void*> &bin = tcache.get(state).bins[cls];
+    bin.push_back(ptr);
+    if (bin.size() > CACHE_MAX) {
+        state->release(cls, bin, CACHE_BATCH);
+    }
+
+    state->in_use.fetch_sub(classSize(cls), std::memory_order_relaxed);
+}
+
+bool cMemArena::owns(const void *ptr) const {
+    return state->lookupClass(ptr) != -1;
+}
+
+void cMemArena::flushThreadCache() {
+    auto it = tcache.entries.find(state.get());
+    if (it != tcache.entries.end()) {
+        tcache.flush(it->second);
+        tcache.entries.erase(it);
+    }
+}
+
+arenaStats cMemArena::getStats() const {
+    arenaStats stats;
+    stats.reserved = state->reserved;
+    stats.in_use = state->in_use;
+    stats.high_water = state->high_water;
+    stats.large_bytes = state->large_bytes;
+    stats.slab_bytes = state->slab_bytes;
+    stats.total_requested = state->total_requested;
+    stats.total_allocated = state->total_allocated;
+    stats.n_regions = state->n_regions;
+    stats.n_allocs = state->n_allocs;
+    stats.n_large_allocs = state->n_large_allocs;
+    return stats;
+}
+
+}
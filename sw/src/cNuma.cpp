@@ -0,0 +1,131 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cNuma.hpp>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+namespace coyote {
+
+/// sysfs directory listing the PCI devices bound to the Coyote driver (see COYOTE_DRIVER_NAME in the driver)
+static const std::string COYOTE_PCI_DRIVER_PATH = "/sys/bus/pci/drivers/coyote_driver";
+
+int32_t getDeviceNumaNode(uint32_t device) {
+    DIR *dir = opendir(COYOTE_PCI_DRIVER_PATH.c_str());
+    if (!dir) {
+        return -1;
+    }
+
+    // Bound devices appear as links named by their PCI address (e.g., 0000:3b:00.0); the other entries (bind, unbind, ...) have no ':'
+    std::vector<std::string> bdfs;
+    while (struct dirent *entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name.find(':') != std::string::npos) {
+            bdfs.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    if (device >= bdfs.size()) {
+        return -1;
+    }
+    std::sort(bdfs.begin(), bdfs.end());
+
+    std::ifstream numa_file(COYOTE_PCI_DRIVER_PATH + "/" + bdfs[device] + "/numa_node");
+    int32_t node = -1;
+    if (!(numa_file >> node)) {
+        return -1;
+    }
+    return node;
+}
+
+std::vector<int> getNodeCpus(int32_t node) {
+    std::vector<int> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+
+    // Format: comma-separated CPUs and ranges, e.g., 0-15,32-47
+    std::ifstream cpulist_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string cpulist;
+    if (!std::getline(cpulist_file, cpulist)) {
+        return cpus;
+    }
+
+    std::stringstream ss(cpulist);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool bindMemToNode(void *mem, uint64_t size, int32_t node) {
+    if (!mem || size == 0 || node < 0 || node >= static_cast<int32_t>(8 * sizeof(unsigned long))) {
+        return false;
+    }
+
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t start = reinterpret_cast<uint64_t>(mem) & ~(page_size - 1);
+    uint64_t len = reinterpret_cast<uint64_t>(mem) + size - start;
+
+    unsigned long nodemask = 1UL << node;
+    return syscall(SYS_mbind, start, len, MPOL_PREFERRED, &nodemask, 8 * sizeof(nodemask), MPOL_MF_MOVE) == 0;
+}
+
+bool setThreadAffinity(pthread_t thread, const std::vector<int> &cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuset);
+        }
+    }
+    return pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset) == 0;
+}
+
+}
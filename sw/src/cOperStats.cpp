@@ -0,0 +1,262 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cOperStats.hpp>
+
+#include <cmath>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace coyote {
+
+/// Timestamp counter; falls back to the steady clock (in ns) on architectures without rdtsc
+static inline uint64_t readTsc() {
+    #if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+}
+
+/// Raises an atomic to at least the given value
+static inline void atomicMax(std::atomic<uint64_t> &target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+///////////////////////////////////////////////////
+//              cLatencyHistogram               //
+//////////////////////////////////////////////////
+
+uint32_t cLatencyHistogram::binIndex(uint64_t cycles) {
+    if (cycles < (1ULL << HIST_SUB_BITS)) {
+        return cycles;
+    }
+
+    uint32_t msb = 63 - __builtin_clzll(cycles);
+    if (msb >= HIST_MAX_BITS) {
+        return HIST_BINS - 1;
+    }
+
+    uint32_t shift = msb - HIST_SUB_BITS;
+    return ((shift + 1) << HIST_SUB_BITS) + ((cycles >> shift) - (1ULL << HIST_SUB_BITS));
+}
+
+uint64_t cLatencyHistogram::binValue(uint32_t idx) {
+    if (idx < (1U << HIST_SUB_BITS)) {
+        return idx;
+    }
+
+    // Mid-point of the bin
+    uint32_t shift = (idx >> HIST_SUB_BITS) - 1;
+    uint64_t sub = idx & ((1U << HIST_SUB_BITS) - 1);
+    return (((1ULL << HIST_SUB_BITS) + sub) << shift) + ((1ULL << shift) >> 1);
+}
+
+void cLatencyHistogram::record(uint64_t cycles) {
+    bins[binIndex(cycles)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(cycles, std::memory_order_relaxed);
+    atomicMax(max, cycles);
+}
+
+uint64_t cLatencyHistogram::quantile(double q) const {
+    uint64_t total = getCount();
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total)));
+    uint64_t cumulative = 0;
+    for (uint32_t i = 0; i < HIST_BINS; i++) {
+        cumulative += bins[i].load(std::memory_order_relaxed);
+        if (cumulative >= rank) {
+            return std::min(binValue(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+void cLatencyHistogram::reset() {
+    for (auto &bin : bins) {
+        bin.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////
+//                 cOperStats                   //
+//////////////////////////////////////////////////
+
+void cOperStats::submit(CoyoteOper oper, uint32_t seq, bool last, uint64_t bytes) {
+    int32_t idx = getWbackIndex(oper);
+    if (idx == -1) {
+        return;
+    }
+
+    // Operations issued without last are merged into the next one with last, which is the one that completes
+    opRing &ring = rings[idx];
+    uint64_t start = ring.pending_tsc ? ring.pending_tsc : readTsc();
+    if (!last) {
+        ring.pending_tsc = start;
+        ring.pending_bytes += bytes;
+        return;
+    }
+    bytes += ring.pending_bytes;
+    ring.pending_tsc = 0;
+    ring.pending_bytes = 0;
+
+    operCounters &counters = opers[static_cast<int32_t>(oper)];
+    uint64_t unset = 0;
+    counters.first_tsc.compare_exchange_strong(unset, start, std::memory_order_relaxed);
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        counters.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ringEntry &entry = ring.entries[head % RING_SIZE];
+    entry.tsc.store(start, std::memory_order_relaxed);
+    entry.bytes.store(bytes, std::memory_order_relaxed);
+    entry.seq.store(seq, std::memory_order_relaxed);
+    entry.oper.store(static_cast<int32_t>(oper), std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void cOperStats::observe(int32_t idx, uint32_t completed) {
+    if (idx < 0 || idx >= static_cast<int32_t>(N_WBACKS)) {
+        return;
+    }
+
+    opRing &ring = rings[idx];
+    uint64_t now = 0;
+    while (true) {
+        uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        if (tail == ring.head.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        // A slot is only rewritten once the tail moved past it, in which case the CAS below fails and the read values are discarded
+        ringEntry &entry = ring.entries[tail % RING_SIZE];
+        uint32_t seq = entry.seq.load(std::memory_order_relaxed);
+        uint64_t tsc = entry.tsc.load(std::memory_order_relaxed);
+        uint64_t bytes = entry.bytes.load(std::memory_order_relaxed);
+        int32_t oper = entry.oper.load(std::memory_order_relaxed);
+
+        if (static_cast<int32_t>(completed - seq) < 0) {
+            return;
+        }
+        if (!ring.tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel)) {
+            continue;
+        }
+
+        if (!now) {
+            now = readTsc();
+        }
+        operCounters &counters = opers[oper];
+        counters.hist.record(now > tsc ? now - tsc : 0);
+        counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        atomicMax(counters.last_tsc, now);
+    }
+}
+
+std::vector<operStats> cOperStats::snapshot() const {
+    std::vector<operStats> out;
+    double cycles_per_us = tscPerNs() * 1000.0;
+
+    for (int32_t i = 0; i < N_OPERS; i++) {
+        const operCounters &counters = opers[i];
+        if (counters.hist.getCount() == 0) {
+            continue;
+        }
+
+        operStats stats;
+        stats.oper = static_cast<CoyoteOper>(i);
+        stats.count = counters.hist.getCount();
+        stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+        stats.dropped = counters.dropped.load(std::memory_order_relaxed);
+        stats.mean_us = static_cast<double>(counters.hist.getSum()) / stats.count / cycles_per_us;
+        stats.p50_us = counters.hist.quantile(0.5) / cycles_per_us;
+        stats.p99_us = counters.hist.quantile(0.99) / cycles_per_us;
+        stats.p999_us = counters.hist.quantile(0.999) / cycles_per_us;
+        stats.max_us = counters.hist.getMax() / cycles_per_us;
+
+        uint64_t first = counters.first_tsc.load(std::memory_order_relaxed);
+        uint64_t last = counters.last_tsc.load(std::memory_order_relaxed);
+        if (last > first) {
+            // Bytes per ns equals GB/s
+            stats.throughput_gbps = stats.bytes / ((last - first) / tscPerNs());
+        }
+
+        out.push_back(stats);
+    }
+
+    return out;
+}
+
+void cOperStats::reset() {
+    for (auto &counters : opers) {
+        counters.hist.reset();
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.dropped.store(0, std::memory_order_relaxed);
+        counters.first_tsc.store(0, std::memory_order_relaxed);
+        counters.last_tsc.store(0, std::memory_order_relaxed);
+    }
+}
+
+void cOperStats::discardInFlight() {
+    for (auto &ring : rings) {
+        ring.tail.store(ring.head.load(std::memory_order_acquire), std::memory_order_release);
+        ring.pending_tsc = 0;
+        ring.pending_bytes = 0;
+    }
+}
+
+double cOperStats::tscPerNs() {
+    #if defined(__x86_64__) || defined(__i386__)
+    // Calibrated once against the steady clock; the TSC is invariant on all the CPUs Coyote targets
+    static const double tsc_per_ns = []() {
+        auto t_start = std::chrono::steady_clock::now();
+        uint64_t tsc_start = readTsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        uint64_t tsc_end = readTsc();
+        auto t_end = std::chrono::steady_clock::now();
+        return (tsc_end - tsc_start) / static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count());
+    }();
+    return tsc_per_ns;
+    #else
+    return 1.0;
+    #endif
+}
+
+}
@@ -29,15 +29,59 @@
 namespace coyote {
 std::atomic<uint32_t> cRcnfg::crid_gen; 
 
-cRcnfg::cRcnfg(unsigned int device): mlock(boost::interprocess::open_or_create, "reconfig_mtx") {
+/// Bitstreams are converted in chunks of this size, see readBitstream(...)
+static constexpr uint64_t CONVERT_CHUNK_SIZE = HUGE_PAGE_SIZE;
+
+/**
+ * @brief Converts big-endian 32-bit words, as stored in the bitstream files, to host order
+ *
+ * @param dst Destination words
+ * @param src Source bytes, no alignment required
+ * @param n_words Number of words to convert
+ */
+static void convertWords(uint32_t *dst, const uint8_t *src, uint64_t n_words) {
+	uint64_t i = 0;
+
+#if defined(__AVX2__)
+	const __m256i shuffle_256 = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+	);
+	for (; i + 8 <= n_words; i += 8) {
+		__m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 4 * i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(words, shuffle_256));
+	}
+#endif
+
+#if defined(__SSSE3__)
+	const __m128i shuffle_128 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	for (; i + 4 <= n_words; i += 4) {
+		__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4 * i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(words, shuffle_128));
+	}
+#endif
+
+	for (; i < n_words; i++) {
+		uint32_t word;
+		memcpy(&word, src + 4 * i, sizeof(word));
+		dst[i] = be32toh(word);
+	}
+}
+
+cRcnfg::cRcnfg([[maybe_unused]] unsigned int device): mlock(boost::interprocess::open_or_create, "reconfig_mtx") {
 	DBG2("cRcnfg: Constructor called");
 
+#ifdef EN_SOFT_VFPGA
+	// The software vFPGA has no reconfiguration device; bitstreams are held in ordinary memory and reconfiguration is a no-op
+	reconfig_dev_fd = -1;
+#else
 	// Issue driver call to obtain the file descriptor for this (physical) FPGA
 	// In the driver, an instance of reconfig_dev is opened, ready for memory mapping and reconfiguration
 	std::string dev_name = "/dev/coyote_fpga_" + std::to_string(device) + "_reconfig";
 	reconfig_dev_fd = open(dev_name.c_str(), O_RDWR | O_SYNC);
 	if (reconfig_dev_fd == -1)
 		throw std::runtime_error("ERROR: cRcnfg instance could not be obtained");
+#endif
 
 	// Get host process ID and generate unique configuration ID, by incrementing atomic variable
 	pid = getpid();
@@ -47,11 +91,13 @@ cRcnfg::cRcnfg(unsigned int device): mlock(boost::interprocess::open_or_create,
 cRcnfg::~cRcnfg() {
 	// Free dynamically allocated memory, remove mutex and close file descriptor
 	DBG2("cRcnfg: Destructor called");
-	for (auto &it: mapped_pages) {
-		freeMem(it.first);
+	while (!mapped_pages.empty()) {
+		freeMem(mapped_pages.begin()->first);
 	}
 	boost::interprocess::named_mutex::remove("reconfig_mtx");
-	close(reconfig_dev_fd);
+	if (reconfig_dev_fd != -1) {
+		close(reconfig_dev_fd);
+	}
 }
 
 void* cRcnfg::getMem(CoyoteAlloc&& alloc) {
@@ -63,6 +109,12 @@ void* cRcnfg::getMem(CoyoteAlloc&& alloc) {
 		if (alloc.alloc == CoyoteAllocType::PRM) {
 			mlock.lock();
 
+#ifdef EN_SOFT_VFPGA
+			mem_non_aligned = mmap(NULL, (alloc.size + 1) * HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mem_non_aligned == MAP_FAILED) {
+				throw std::runtime_error("ERROR: bitstream memory mmap() failed");
+			}
+#else
 			// Arguments be passed to the driver's IOCTL call
 			uint64_t tmp[MAX_USER_ARGS];
 			tmp[0] = static_cast<uint64_t>(alloc.size);
@@ -77,6 +129,7 @@ void* cRcnfg::getMem(CoyoteAlloc&& alloc) {
 			if (mem_non_aligned == MAP_FAILED) {
 				throw std::runtime_error("ERROR: reconfig_dev mmap() failed");
 			}
+#endif
 
 			mlock.unlock();
 
@@ -103,20 +156,23 @@ void cRcnfg::freeMem(void* virtual_address) {
 				mlock.lock();
 
 				// Unmap and de-allocate bitstream memory
+				if (munmap(mapped.mem, (mapped.size + 1) * HUGE_PAGE_SIZE) != 0) {
+					throw std::runtime_error("ERROR munmap() failed");
+				} 
+
+#ifndef EN_SOFT_VFPGA
 				uint64_t tmp[MAX_USER_ARGS];
 				tmp[0] = reinterpret_cast<uint64_t>(virtual_address);
 				tmp[1] = static_cast<uint64_t>(this->pid);
 				tmp[2] = static_cast<uint64_t>(this->crid);
 
-				if (munmap(mapped.mem, (mapped.size + 1) * HUGE_PAGE_SIZE) != 0) {
-					throw std::runtime_error("ERROR munmap() failed");
-				} 
-				
 				if (ioctl(reconfig_dev_fd, IOCTL_FREE_HOST_RECONFIG_MEM, &tmp)) {
 					throw std::runtime_error("ERROR: IOCTL_FREE_HOST_RECONFIG_MEM() failed");
 				}
+#endif
 
 				mlock.unlock();
+				mapped_pages.erase(virtual_address);
 		} else {
 			throw std::runtime_error("ERROR: Unauthorized memory deallocation");
 		}     
@@ -139,25 +195,87 @@ bitstream_t cRcnfg::readBitstream(std::ifstream& fb) {
 	void *vaddr = getMem({CoyoteAllocType::PRM, n_pages}); 
 	uint32_t *vaddr_32 = reinterpret_cast<uint32_t *>(vaddr); 
 
-	// Read the input-stream bytewise and store it bytewise to the mapped memory 
-	for (uint32_t i = 0; i < len / 4; i++) {
-		vaddr_32[i] = 0;
-		vaddr_32[i] |= readByte(fb) << 24;
-		vaddr_32[i] |= readByte(fb) << 16;
-		vaddr_32[i] |= readByte(fb) << 8;
-		vaddr_32[i] |= readByte(fb);
+	// Read the input-stream chunk-wise and convert it to the mapped memory 
+	std::vector<char> chunk(CONVERT_CHUNK_SIZE);
+	uint64_t n_bytes = len / 4 * 4;
+	for (uint64_t offs = 0; offs < n_bytes; offs += CONVERT_CHUNK_SIZE) {
+		uint64_t chunk_size = std::min(CONVERT_CHUNK_SIZE, n_bytes - offs);
+		if (!fb.read(chunk.data(), chunk_size)) {
+			freeMem(vaddr);
+			throw std::runtime_error("ERROR: Failed to read bitstream");
+		}
+		convertWords(vaddr_32 + offs / 4, reinterpret_cast<const uint8_t *>(chunk.data()), chunk_size / 4);
 	}
 
 	DBG2("cRcnfg: Shell bitstream loaded");
 	return std::make_pair(vaddr, len);
 }
 
-void cRcnfg::reconfigureBase(bitstream_t bitstream, uint32_t vfid) {
+bitstream_t cRcnfg::readBitstream(const std::string &bitstream_path) {
+	DBG2("cRcnfg: Called readBitstream to read bitstream from " << bitstream_path);
+
+	int fd = open(bitstream_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		throw std::runtime_error("ERROR: Bitstream " + bitstream_path + " could not be opened; please check the provided bitstream path...");
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == -1) {
+		close(fd);
+		throw std::runtime_error("ERROR: Bitstream " + bitstream_path + " fstat() failed");
+	}
+	uint32_t len = file_stat.st_size;
+
+	// Map the file; the mapping remains valid after closing the descriptor
+	const uint8_t *file = nullptr;
+	if (len > 0) {
+		void *file_map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (file_map == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("ERROR: Bitstream " + bitstream_path + " mmap() failed");
+		}
+		file = reinterpret_cast<const uint8_t *>(file_map);
+		madvise(file_map, len, MADV_SEQUENTIAL);
+	}
+	close(fd);
+
+	// Allocate host-side, kernel memory to hold the bitsream 
+	uint32_t n_pages = (len + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE;
+	void *vaddr;
+	try {
+		vaddr = getMem({CoyoteAllocType::PRM, n_pages}); 
+	} catch (const std::exception &e) {
+		if (file) { munmap(const_cast<uint8_t *>(file), len); }
+		throw;
+	}
+	uint32_t *vaddr_32 = reinterpret_cast<uint32_t *>(vaddr); 
+
+	// Convert chunk by chunk, with the kernel reading ahead the next chunk, and dropping the converted ones from the page cache mapping
+	uint64_t n_bytes = len / 4 * 4;
+	for (uint64_t offs = 0; offs < n_bytes; offs += CONVERT_CHUNK_SIZE) {
+		uint64_t chunk_size = std::min(CONVERT_CHUNK_SIZE, n_bytes - offs);
+		if (offs + chunk_size < n_bytes) {
+			madvise(const_cast<uint8_t *>(file) + offs + chunk_size, std::min(CONVERT_CHUNK_SIZE, n_bytes - offs - chunk_size), MADV_WILLNEED);
+		}
+		convertWords(vaddr_32 + offs / 4, file + offs, chunk_size / 4);
+		madvise(const_cast<uint8_t *>(file) + offs, chunk_size, MADV_DONTNEED);
+	}
+
+	if (file) { munmap(const_cast<uint8_t *>(file), len); }
+
+	DBG2("cRcnfg: Bitstream " << bitstream_path << " loaded");
+	return std::make_pair(vaddr, len);
+}
+
+void cRcnfg::reconfigureBase([[maybe_unused]] bitstream_t bitstream, [[maybe_unused]] uint32_t vfid) {
 	DBG2(
 		"cRcnfg: reconfigureBase called with virtual address 0x" << std::hex << std::get<0>(bitstream) 
 		<< std::dec << ", length " << std::get<1>(bitstream) << " and vFPGA ID " << vfid
 	);
 
+#ifdef EN_SOFT_VFPGA
+	// Nothing to program; the software vFPGA runs its registered kernel regardless of the bitstream
+	DBG2("cRcnfg: Reconfiguration skipped for the software vFPGA");
+#else
 	// Arguments to be passed to the driver's IOCTL call
 	uint64_t tmp[MAX_USER_ARGS];
 	tmp[0] = reinterpret_cast<uint64_t>(std::get<0>(bitstream));
@@ -180,18 +298,27 @@ void cRcnfg::reconfigureBase(bitstream_t bitstream, uint32_t vfid) {
 		}
 		DBG2("cRcnfg: Shell reconfiguration completed");
 	}
+#endif
+}
+
+bool cRcnfg::isPrEnabled() {
+#ifdef EN_SOFT_VFPGA
+	// Reconfiguration is a no-op, so any number of app bitstreams can be "loaded"
+	return true;
+#else
+	uint64_t tmp[2];
+	if (ioctl(reconfig_dev_fd, IOCTL_PR_CNFG, &tmp)) {
+		throw std::runtime_error("ERROR: IOCTL_PR_CNFG failed");
+	}
+	return tmp[0];
+#endif
 }
 
 void cRcnfg::reconfigureShell(std::string bitstream_path) {
 	DBG2("cRcnfg: Called reconfigureShell"); 
 	
 	// Read bitstream from file and trigger reconfiguration
-	std::ifstream bitstream_file(bitstream_path, std::ios::ate | std::ios::binary);
-	if (!bitstream_file) {
-		throw std::runtime_error("ERROR: Shell bitstream could not be opened; please check the provided bitstream path...");
-	}
-	bitstream_t bitstream = readBitstream(bitstream_file);
-	bitstream_file.close();
+	bitstream_t bitstream = readBitstream(bitstream_path);
 	reconfigureBase(bitstream);
 }
 
@@ -199,12 +326,7 @@ void cRcnfg::reconfigureApp(std::string bitstream_path, int vfid) {
 	DBG2("cRcnfg: Called reconfigureApp"); 
 	
 	// Read bitstream from file and trigger reconfiguration
-	std::ifstream bitstream_file(bitstream_path, std::ios::ate | std::ios::binary);
-	if (!bitstream_file) {
-		throw std::runtime_error("ERROR: App bitstream could not be opened; please check the provided bitstream path...");
-	}
-	bitstream_t bitstream = readBitstream(bitstream_file);
-	bitstream_file.close();
+	bitstream_t bitstream = readBitstream(bitstream_path);
 	reconfigureBase(bitstream, vfid);
 }
 
@@ -0,0 +1,311 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cRdmaConnMgr.hpp>
+
+#include <set>
+#include <chrono>
+#include <thread>
+#include <exception>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace coyote {
+
+/// Header of the batched QP exchange; followed by n_qps ibvQ structs
+struct qpBatchHdr {
+    uint32_t magic;
+    uint32_t n_qps;
+};
+
+/// Identifies a batched QP exchange, so that a peer running the single-QP initRDMA() is detected
+constexpr uint32_t const QP_BATCH_MAGIC = 0xc07e0b47;
+
+/// Writes a whole buffer to a socket
+static void writeAll(int fd, const void *buf, size_t len) {
+    const char *ptr = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t n = ::write(fd, ptr, len);
+        if (n <= 0) {
+            throw std::runtime_error("ERROR: cRdmaConnMgr - failed to write to the out-of-band connection");
+        }
+        ptr += n;
+        len -= n;
+    }
+}
+
+/// Reads a whole buffer from a socket
+static void readAll(int fd, void *buf, size_t len) {
+    char *ptr = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = ::read(fd, ptr, len);
+        if (n <= 0) {
+            throw std::runtime_error("ERROR: cRdmaConnMgr - failed to read from the out-of-band connection");
+        }
+        ptr += n;
+        len -= n;
+    }
+}
+
+cRdmaConnMgr::cRdmaConnMgr(int32_t vfid, uint32_t device, pid_t hpid, uint32_t connect_timeout_ms):
+    vfid(vfid), device(device), hpid(hpid), connect_timeout_ms(connect_timeout_ms) {}
+
+cRdmaConnMgr::~cRdmaConnMgr() {
+    for (auto &peer : peers) {
+        if (peer->connfd != -1) {
+            ::close(peer->connfd);
+        }
+        if (peer->listenfd != -1) {
+            ::close(peer->listenfd);
+        }
+    }
+}
+
+void cRdmaConnMgr::addPeer(const rdmaPeer &peer) {
+    if (connected) {
+        throw std::runtime_error("ERROR: cRdmaConnMgr::addPeer() called after connect()");
+    }
+    if (peer.n_qps == 0) {
+        throw std::runtime_error("ERROR: cRdmaConnMgr::addPeer() - peer " + peer.name + " has no QPs");
+    }
+
+    for (const auto &other : peers) {
+        if (other->cnfg.name == peer.name) {
+            throw std::runtime_error("ERROR: cRdmaConnMgr::addPeer() - duplicate peer name " + peer.name);
+        }
+        if (peer.address.empty() && other->cnfg.address.empty() && other->cnfg.port == peer.port) {
+            throw std::runtime_error("ERROR: cRdmaConnMgr::addPeer() - accepted peers must use distinct ports, port " + std::to_string(peer.port));
+        }
+    }
+
+    auto state = std::make_unique<peerState>();
+    state->cnfg = peer;
+    peers.push_back(std::move(state));
+}
+
+void cRdmaConnMgr::connect() {
+    if (connected) {
+        return;
+    }
+
+    // Create the QPs and their buffers up front; cThread registration goes through the driver, so it is kept serial
+    for (auto &peer : peers) {
+        for (uint32_t i = 0; i < peer->cnfg.n_qps; i++) {
+            peer->threads.push_back(std::make_unique<cThread>(vfid, hpid, device));
+            peer->buffers.push_back(peer->threads.back()->getMem({CoyoteAllocType::HPF, peer->cnfg.buffer_size, true}));
+
+            std::string name = peer->cnfg.name + "/" + std::to_string(i);
+            connections[name] = std::make_pair(peer.get(), i);
+            if (i == 0) {
+                connections[peer->cnfg.name] = std::make_pair(peer.get(), i);
+            }
+        }
+
+        // Listen before any exchange starts, so that peers connecting to this node don't have to retry
+        if (peer->cnfg.address.empty()) {
+            peer->listenfd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (peer->listenfd == -1) {
+                throw std::runtime_error("ERROR: cRdmaConnMgr - could not create a socket");
+            }
+
+            int reuse = 1;
+            setsockopt(peer->listenfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            struct sockaddr_in server = {};
+            server.sin_family = AF_INET;
+            server.sin_port = htons(peer->cnfg.port);
+            server.sin_addr.s_addr = INADDR_ANY;
+            if (::bind(peer->listenfd, (struct sockaddr*) &server, sizeof(server)) < 0) {
+                throw std::runtime_error("ERROR: cRdmaConnMgr - could not bind to port " + std::to_string(peer->cnfg.port));
+            }
+            if (::listen(peer->listenfd, 1) == -1) {
+                throw std::runtime_error("ERROR: cRdmaConnMgr - could not listen on port " + std::to_string(peer->cnfg.port));
+            }
+        }
+    }
+
+    // Out-of-band exchanges with all the peers run concurrently
+    std::vector<std::exception_ptr> errors(peers.size());
+    std::vector<std::thread> setup_threads;
+    for (size_t i = 0; i < peers.size(); i++) {
+        setup_threads.emplace_back([this, i, &errors] {
+            try {
+                exchange(*peers[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto &thread : setup_threads) {
+        thread.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // The QP and connection contexts are written through shared vFPGA config registers, so they are written one QP at a time
+    for (auto &peer : peers) {
+        for (auto &thread : peer->threads) {
+            thread->writeQpContext(peer->cnfg.port);
+        }
+    }
+
+    // One ARP lookup per remote node; like the QP contexts, the lookups are issued through a shared vFPGA config 
+    // register (NET_ARP_REG), so they are written one at a time, and then awaited once for all the remote nodes
+    std::map<uint32_t, cThread*> arp_targets;
+    for (auto &peer : peers) {
+        arp_targets.emplace(peer->threads.front()->getQpair()->remote.ip_addr, peer->threads.front().get());
+    }
+    for (auto &target : arp_targets) {
+        target.second->doArpLookup(target.first, false);
+    }
+    usleep(SLEEP_TIME);
+
+    connected = true;
+    DBG3("cRdmaConnMgr: connected " << connections.size() << " connections to " << peers.size() << " peers");
+}
+
+void cRdmaConnMgr::exchange(peerState &peer) {
+    if (!peer.cnfg.address.empty()) {
+        // Client: the peer may not be listening yet, so retry until the timeout
+        struct addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo *res;
+        if (getaddrinfo(peer.cnfg.address.c_str(), std::to_string(peer.cnfg.port).c_str(), &hints, &res) != 0) {
+            throw std::runtime_error("ERROR: cRdmaConnMgr - getaddrinfo() failed for " + peer.cnfg.address);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(connect_timeout_ms);
+        while (peer.connfd == -1) {
+            for (struct addrinfo *t = res; t && peer.connfd == -1; t = t->ai_next) {
+                int fd = ::socket(t->ai_family, t->ai_socktype, t->ai_protocol);
+                if (fd >= 0 && !::connect(fd, t->ai_addr, t->ai_addrlen)) {
+                    peer.connfd = fd;
+                } else if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+
+            if (peer.connfd == -1) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    freeaddrinfo(res);
+                    throw std::runtime_error("ERROR: cRdmaConnMgr - could not connect to " + peer.cnfg.address + ":" + std::to_string(peer.cnfg.port));
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        freeaddrinfo(res);
+    } else {
+        // Server
+        peer.connfd = ::accept(peer.listenfd, NULL, 0);
+        if (peer.connfd == -1) {
+            throw std::runtime_error("ERROR: cRdmaConnMgr - failed to accept connection from peer " + peer.cnfg.name);
+        }
+    }
+
+    // All the local QPs in one message; both sides send first, since the message fits in the socket buffer for any sensible n_qps
+    std::vector<char> msg(sizeof(qpBatchHdr) + peer.threads.size() * sizeof(ibvQ));
+    qpBatchHdr hdr = { QP_BATCH_MAGIC, static_cast<uint32_t>(peer.threads.size()) };
+    memcpy(msg.data(), &hdr, sizeof(qpBatchHdr));
+    for (size_t i = 0; i < peer.threads.size(); i++) {
+        memcpy(msg.data() + sizeof(qpBatchHdr) + i * sizeof(ibvQ), &(peer.threads[i]->getQpair()->local), sizeof(ibvQ));
+    }
+    writeAll(peer.connfd, msg.data(), msg.size());
+
+    qpBatchHdr remote_hdr;
+    readAll(peer.connfd, &remote_hdr, sizeof(qpBatchHdr));
+    if (remote_hdr.magic != QP_BATCH_MAGIC || remote_hdr.n_qps != peer.threads.size()) {
+        throw std::runtime_error(
+            "ERROR: cRdmaConnMgr - peer " + peer.cnfg.name + " sent an unexpected QP batch (" + std::to_string(remote_hdr.n_qps) + 
+            " QPs, expected " + std::to_string(peer.threads.size()) + ")"
+        );
+    }
+
+    for (auto &thread : peer.threads) {
+        readAll(peer.connfd, &(thread->getQpair()->remote), sizeof(ibvQ));
+    }
+
+    DBG3("cRdmaConnMgr: exchanged " << peer.threads.size() << " QPs with peer " << peer.cnfg.name);
+}
+
+std::pair<cRdmaConnMgr::peerState*, uint32_t> cRdmaConnMgr::lookup(const std::string &connection) const {
+    auto it = connections.find(connection);
+    if (it == connections.end()) {
+        throw std::runtime_error("ERROR: cRdmaConnMgr - unknown connection " + connection);
+    }
+    return it->second;
+}
+
+uint32_t cRdmaConnMgr::invoke(CoyoteOper oper, const rdmaSgConn &sg, bool last) {
+    if (!connected) {
+        throw std::runtime_error("ERROR: cRdmaConnMgr::invoke() called before connect()");
+    }
+
+    auto conn = lookup(sg.connection);
+    rdmaSg rdma_sg;
+    rdma_sg.local_offs = sg.local_offs;
+    rdma_sg.local_stream = sg.local_stream;
+    rdma_sg.local_dest = sg.local_dest;
+    rdma_sg.remote_offs = sg.remote_offs;
+    rdma_sg.remote_dest = sg.remote_dest;
+    rdma_sg.len = sg.len;
+
+    return conn.first->threads[conn.second]->invoke(oper, rdma_sg, last);
+}
+
+cThread* cRdmaConnMgr::getThread(const std::string &connection) const {
+    auto conn = lookup(connection);
+    return conn.first->threads[conn.second].get();
+}
+
+void* cRdmaConnMgr::getBuffer(const std::string &connection) const {
+    auto conn = lookup(connection);
+    return conn.first->buffers[conn.second];
+}
+
+std::vector<std::string> cRdmaConnMgr::getConnections() const {
+    std::vector<std::string> names;
+    for (const auto &peer : peers) {
+        for (size_t i = 0; i < peer->threads.size(); i++) {
+            names.push_back(peer->cnfg.name + "/" + std::to_string(i));
+        }
+    }
+    return names;
+}
+
+void cRdmaConnMgr::sync(const std::string &peer) {
+    auto conn = lookup(peer);
+    uint32_t ack = 0;
+    writeAll(conn.first->connfd, &ack, sizeof(uint32_t));
+    readAll(conn.first->connfd, &ack, sizeof(uint32_t));
+}
+
+}
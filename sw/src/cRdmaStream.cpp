@@ -0,0 +1,175 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cRdmaStream.hpp>
+
+namespace coyote {
+
+cRdmaStream::cRdmaStream(cThread *thread, rdmaStreamCfg cfg, CoyoteOper oper): thread(thread), oper(oper), cfg(cfg) {
+    if (!isRemoteRdma(oper)) {
+        throw std::runtime_error("ERROR: cRdmaStream - the streamed operation must be a REMOTE_RDMA_READ, REMOTE_RDMA_WRITE or REMOTE_RDMA_SEND");
+    }
+
+    if (!thread->getQpair() || !thread->getQpair()->local.vaddr) {
+        throw std::runtime_error("ERROR: cRdmaStream - the cThread has no RDMA connection, set it up first");
+    }
+
+    if (cfg.window == 0) {
+        throw std::runtime_error("ERROR: cRdmaStream - the window must hold at least one operation");
+    }
+
+    credits_en = cfg.n_slots > 0 && isRemoteWriteOrSend(oper);
+    if (credits_en) {
+        uint64_t buff_size = thread->getQpair()->local.size;
+        uint64_t ring_end = cfg.ring_offs + (uint64_t) cfg.n_slots * cfg.slot_size;
+        bool overlap = cfg.credit_offs + sizeof(uint64_t) > cfg.ring_offs && cfg.credit_offs < ring_end;
+        if (ring_end > buff_size || cfg.credit_offs + sizeof(uint64_t) > buff_size || overlap || cfg.credit_offs % sizeof(uint64_t)) {
+            throw std::runtime_error("ERROR: cRdmaStream - the receive slots and the (aligned) credit word must fit into the RDMA buffer without overlapping");
+        }
+
+        if (cfg.credit_batch == 0 || cfg.credit_batch > cfg.n_slots) {
+            throw std::runtime_error("ERROR: cRdmaStream - the credit batch must be between 1 and the number of slots");
+        }
+    }
+
+    reset();
+}
+
+volatile uint64_t* cRdmaStream::creditWord() const {
+    return (volatile uint64_t*) ((uint64_t) thread->getQpair()->local.vaddr + cfg.credit_offs);
+}
+
+void cRdmaStream::reset() {
+    DBG3("cRdmaStream: reset, window " << cfg.window << ", slots " << cfg.n_slots);
+
+    if (credits_en) {
+        *creditWord() = 0;
+    }
+
+    issued_seq = thread->checkCompleted(oper);
+    completed_seq = issued_seq;
+    recv_base = thread->checkCompleted(CoyoteOper::LOCAL_WRITE);
+    n_released = 0;
+    n_returned = 0;
+    stats = rdmaStreamStats();
+}
+
+uint32_t cRdmaStream::poll() {
+    completed_seq = thread->checkCompleted(oper);
+    int32_t outstanding = static_cast<int32_t>(issued_seq - completed_seq);
+    return outstanding > 0 ? outstanding : 0;
+}
+
+uint32_t cRdmaStream::getOutstanding() const {
+    int32_t outstanding = static_cast<int32_t>(issued_seq - completed_seq);
+    return outstanding > 0 ? outstanding : 0;
+}
+
+uint32_t cRdmaStream::getCredits() const {
+    if (!credits_en) {
+        return cfg.window;
+    }
+    uint64_t in_use = stats.n_posted - *creditWord();
+    return in_use < cfg.n_slots ? cfg.n_slots - in_use : 0;
+}
+
+uint32_t cRdmaStream::post(rdmaSg sg) {
+    waitPolicy policy = thread->getWaitPolicy();
+
+    // Window; the counter is only read again once the cached value says the window is full
+    if (getOutstanding() >= cfg.window && poll() >= cfg.window) {
+        stats.window_stalls++;
+        waitFor([&]() { return poll() < cfg.window; }, policy, wait_stats);
+    }
+
+    // Credits; the next slot must have been released by the receiver
+    if (credits_en) {
+        if (sg.remote_offs + sg.len > cfg.slot_size) {
+            throw std::runtime_error("ERROR: cRdmaStream::post() - message does not fit into a receive slot");
+        }
+
+        if (getCredits() == 0) {
+            stats.credit_stalls++;
+            waitFor([&]() { return getCredits() > 0; }, policy, wait_stats);
+        }
+
+        sg.remote_offs += cfg.ring_offs + (stats.n_posted % cfg.n_slots) * cfg.slot_size;
+    }
+
+    issued_seq = thread->invoke(oper, sg);
+    stats.n_posted++;
+    return issued_seq;
+}
+
+void cRdmaStream::flush() {
+    waitFor([&]() { return poll() == 0; }, thread->getWaitPolicy(), wait_stats);
+}
+
+uint32_t cRdmaStream::receive() {
+    uint32_t cnt = thread->checkCompleted(CoyoteOper::LOCAL_WRITE);
+    stats.n_received += static_cast<uint32_t>(cnt - recv_base);
+    recv_base = cnt;
+    return stats.n_received - n_released;
+}
+
+void* cRdmaStream::getSlot(uint64_t i) const {
+    uint64_t slot = cfg.n_slots ? i % cfg.n_slots : 0;
+    return (void*) ((uint64_t) thread->getQpair()->local.vaddr + cfg.ring_offs + slot * cfg.slot_size);
+}
+
+void cRdmaStream::release(uint32_t n) {
+    if (n_released + n > stats.n_received) {
+        throw std::runtime_error("ERROR: cRdmaStream::release() - cannot release more messages than were received");
+    }
+    n_released += n;
+
+    if (credits_en && n_released - n_returned >= cfg.credit_batch) {
+        returnCredits();
+    }
+}
+
+void cRdmaStream::returnCredits() {
+    DBG3("cRdmaStream: returning credits, released " << n_released);
+
+    // The counter is monotonic, so a later update overtaking the DMA read of an earlier one is harmless
+    *creditWord() = n_released;
+
+    rdmaSg sg = { .local_offs = cfg.credit_offs, .remote_offs = cfg.credit_offs, .len = sizeof(uint64_t) };
+    issued_seq = thread->invoke(CoyoteOper::REMOTE_RDMA_WRITE, sg);
+
+    n_returned = n_released;
+    stats.credit_updates++;
+}
+
+rdmaStreamStats cRdmaStream::getStats() const {
+    return stats;
+}
+
+waitStats cRdmaStream::getWaitStats() const {
+    return wait_stats;
+}
+
+}
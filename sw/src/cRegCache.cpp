@@ -0,0 +1,174 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cRegCache.hpp>
+
+namespace coyote {
+
+std::map<uint64_t, cRegCache::regEntry>::iterator cRegCache::findCovering(uint64_t vaddr, uint64_t len, bool in_use_only) {
+    auto it = entries.upper_bound(vaddr);
+    while (it != entries.begin()) {
+        it--;
+        if (it->first + max_len < vaddr + len) {
+            break;
+        }
+        if (it->first + it->second.len >= vaddr + len && (!in_use_only || it->second.refcnt > 0)) {
+            return it;
+        }
+    }
+    return entries.end();
+}
+
+bool cRegCache::acquire(uint64_t vaddr, uint64_t len) {
+    auto it = findCovering(vaddr, len, false);
+    if (it == entries.end()) {
+        stats.misses++;
+        return false;
+    }
+
+    if (it->second.refcnt == 0) {
+        lru.erase(it->second.lru_it);
+        stats.n_unused--;
+    }
+    it->second.refcnt++;
+    stats.hits++;
+    return true;
+}
+
+bool cRegCache::remove(uint64_t vaddr) {
+    auto it = entries.find(vaddr);
+    if (it == entries.end() || it->second.refcnt > 0) {
+        return false;
+    }
+
+    lru.erase(it->second.lru_it);
+    stats.pinned_bytes -= it->second.len;
+    stats.n_entries--;
+    stats.n_unused--;
+    entries.erase(it);
+    return true;
+}
+
+void cRegCache::insert(uint64_t vaddr, uint64_t len) {
+    // A range re-mapped at the start of a registration in use only acquires it, since the driver doesn't extend the mapping
+    auto it = entries.find(vaddr);
+    if (it != entries.end()) {
+        if (it->second.refcnt == 0) {
+            lru.erase(it->second.lru_it);
+            stats.n_unused--;
+        }
+        it->second.refcnt++;
+    } else {
+        entries.emplace(vaddr, regEntry{len, 1, lru.end()});
+        stats.pinned_bytes += len;
+        stats.n_entries++;
+    }
+    max_len = std::max(max_len, len);
+}
+
+bool cRegCache::release(uint64_t vaddr) {
+    auto it = findCovering(vaddr, 1, true);
+    if (it == entries.end()) {
+        return false;
+    }
+
+    if (--it->second.refcnt == 0) {
+        it->second.lru_it = lru.insert(lru.end(), it->first);
+        stats.n_unused++;
+    }
+    return true;
+}
+
+std::vector<uint64_t> cRegCache::evict() {
+    std::vector<uint64_t> evicted;
+    while (stats.pinned_bytes > budget && !lru.empty()) {
+        auto it = entries.find(lru.front());
+        lru.pop_front();
+
+        stats.pinned_bytes -= it->second.len;
+        stats.n_entries--;
+        stats.n_unused--;
+        stats.evictions++;
+
+        evicted.push_back(it->first);
+        entries.erase(it);
+    }
+    return evicted;
+}
+
+std::vector<uint64_t> cRegCache::invalidate(uint64_t vaddr, uint64_t len) {
+    std::vector<uint64_t> removed;
+
+    // Entries starting before vaddr may still overlap, up to max_len back
+    auto it = entries.lower_bound(vaddr > max_len ? vaddr - max_len : 0);
+    while (it != entries.end() && it->first < vaddr + len) {
+        if (it->first + it->second.len > vaddr) {
+            if (it->second.refcnt == 0) {
+                lru.erase(it->second.lru_it);
+                stats.n_unused--;
+            }
+            stats.pinned_bytes -= it->second.len;
+            stats.n_entries--;
+
+            removed.push_back(it->first);
+            it = entries.erase(it);
+        } else {
+            it++;
+        }
+    }
+    return removed;
+}
+
+std::vector<uint64_t> cRegCache::flush() {
+    std::vector<uint64_t> removed;
+    for (uint64_t vaddr : lru) {
+        auto it = entries.find(vaddr);
+        stats.pinned_bytes -= it->second.len;
+        stats.n_entries--;
+
+        removed.push_back(vaddr);
+        entries.erase(it);
+    }
+    lru.clear();
+    stats.n_unused = 0;
+    return removed;
+}
+
+std::vector<uint64_t> cRegCache::clear() {
+    std::vector<uint64_t> removed;
+    for (auto &it : entries) {
+        removed.push_back(it.first);
+    }
+    entries.clear();
+    lru.clear();
+    max_len = 0;
+    stats.pinned_bytes = 0;
+    stats.n_entries = 0;
+    stats.n_unused = 0;
+    return removed;
+}
+
+}
@@ -30,15 +30,16 @@ namespace coyote {
 
 std::map<std::string, cSched*> coyote::cSched::schedulers;
 
+/// Number of queued tasks inspected by nextBitstream() without reordering
+static constexpr uint32_t PREFETCH_WINDOW = 64;
+
 cSched::cSched(int32_t vfid, uint32_t device, bool reorder, std::string current_bitstream) : 
-  vfid(vfid), cRcnfg(device), reorder(reorder), current_bitstream(current_bitstream), scheduler_running(false) {
+  cRcnfg(device), vfid(vfid), reorder(reorder), rcnfg_cost_us(policy.rcnfg_cost_us), n_workers(1), n_running(0), n_parked(0),
+  cmpl_fd(-1), scheduler_running(false), current_bitstream(current_bitstream), prefetch_running(false) {
+    cache_stats.budget = DEF_BITSTREAM_CACHE_BUDGET;
 
     // Check if partial reconfiguration is enabled
-    uint64_t tmp[2];
-    if (ioctl(reconfig_dev_fd, IOCTL_PR_CNFG, &tmp)) {
-        throw std::runtime_error("IOCTL_PR_CNFG failed, vfid: " + std::to_string(vfid));
-    }
-    fcnfg.en_pr = tmp[0];
+    fcnfg.en_pr = isPrEnabled();
 
     if (!fcnfg.en_pr) {
         syslog(LOG_WARNING, "Partial reconfiguration is not enabled; scheduler will only execute functions that match the current bitstream");
@@ -46,139 +47,525 @@ cSched::cSched(int32_t vfid, uint32_t device, bool reorder, std::string current_
 
 }
 
-bool cSched::taskChecker(int32_t tid) {
-    if (task_id_map.find(tid) == task_id_map.end()) {
-        // Don't add print here; as this condition can happen often causing too many prints
-        return false;
+cTask* cSched::nextTask() {
+    // Drop the entries of cancelled tasks
+    auto trim = [&](std::deque<int32_t> &q) {
+        while (!q.empty() && queued.find(q.front()) == queued.end()) {
+            q.pop_front();
+        }
+    };
+
+    // Parked tasks whose cThread became free were already picked by the policy earlier
+    trim(unparked);
+    if (!unparked.empty()) {
+        int32_t tid = unparked.front();
+        unparked.pop_front();
+        return tasks[tid].get();
+    }
+
+    std::deque<int32_t> *q = nullptr;
+    if (!reorder) {
+        trim(arrival_queue);
+        q = &arrival_queue;
+    } else {
+        // Pick the bitstream with the highest priority (overdue tasks first); see schedPolicy
+        auto now = std::chrono::steady_clock::now();
+        std::pair<bool, double> best_priority = { false, 0 };
+        auto rq = ready_queues.begin();
+        while (rq != ready_queues.end()) {
+            trim(rq->second);
+            if (rq->second.empty()) {
+                rq = ready_queues.erase(rq);
+                continue;
+            }
+
+            double wait_us = std::chrono::duration<double, std::micro>(now - queued[rq->second.front()].submitted).count();
+            std::pair<bool, double> priority = { wait_us >= policy.max_wait_us, wait_us };
+            if (!priority.first && rq->first == current_bitstream) {
+                priority.second += policy.batch_factor * rcnfg_cost_us;
+            }
+
+            if (q == nullptr || priority > best_priority) {
+                q = &rq->second;
+                best_priority = priority;
+            }
+            rq++;
+        }
+    }
+
+    if (q == nullptr || q->empty()) {
+        return nullptr;
+    }
+
+    int32_t tid = q->front();
+    q->pop_front();
+    return tasks[tid].get();
+}
+
+bool cSched::hasReadyTasks() const {
+    return queued.size() > n_parked || !unparked.empty();
+}
+
+void cSched::completeTask(cTask *task, int32_t ret_code, std::vector<char> ret_val) {
+    int32_t tid = task->getTid();
+    task->setRetVal(ret_val);
+    task->setRetCode(ret_code);
+    task->setCompleted(true);
+
+    // Tasks released while running are reclaimed right away
+    if (orphaned.erase(tid)) {
+        tasks.erase(tid);
+    }
+    tcv.notify_all();
+
+    if (cmpl_fd != -1) {
+        completed.push_back(tid);
+        eventfd_write(cmpl_fd, 1);
+    }
+}
+
+std::string cSched::nextBitstream() {
+    if (!fcnfg.en_pr) {
+        return "";
+    }
+
+    if (reorder) {
+        // Without the bonus of the loaded bitstream, the priority is the wait time of the oldest task; see nextTask()
+        auto now = std::chrono::steady_clock::now();
+        std::string next;
+        double best_wait_us = -1;
+        for (auto &rq : ready_queues) {
+            if (rq.first == current_bitstream || rq.second.empty()) {
+                continue;
+            }
+            auto q = queued.find(rq.second.front());
+            if (q == queued.end()) {
+                continue;
+            }
+            double wait_us = std::chrono::duration<double, std::micro>(now - q->second.submitted).count();
+            if (wait_us > best_wait_us) {
+                next = rq.first;
+                best_wait_us = wait_us;
+            }
+        }
+        return next;
+    }
+
+    uint32_t n = 0;
+    for (int32_t tid : arrival_queue) {
+        if (n++ == PREFETCH_WINDOW) {
+            break;
+        }
+        if (queued.find(tid) == queued.end()) {
+            continue;
+        }
+        const std::string &path = functions[tasks[tid]->getFid()]->getBitstreamPath();
+        if (path != current_bitstream) {
+            return path;
+        }
+    }
+    return "";
+}
+
+void cSched::prefetchNext() {
+    std::string path = nextBitstream();
+    if (!path.empty()) {
+        prefetch(path);
     }
-    if (tasks[task_id_map[tid]] == nullptr) {
-        syslog(LOG_WARNING, "Task with ID %d is null", tid);
+}
+
+void cSched::prefetch(const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lck(cache_lock);
+        if (!prefetch_running || prefetch_path == path || bitstream_cache.find(path) != bitstream_cache.end()) {
+            return;
+        }
+        prefetch_path = path;
+    }
+    cache_cv.notify_all();
+}
+
+void cSched::prefetcher() {
+    std::unique_lock<std::mutex> lck(cache_lock);
+    while (true) {
+        cache_cv.wait(lck, [&] { return !prefetch_running || !prefetch_path.empty(); });
+        if (!prefetch_running) {
+            break;
+        }
+
+        std::string path;
+        path.swap(prefetch_path);
+        if (bitstream_cache.find(path) != bitstream_cache.end()) {
+            continue;
+        }
+        bitstream_cache.emplace(path, cachedBitstream());
+        lck.unlock();
+
+        bool loaded = false;
+        try {
+            loadBitstream(path, false);
+            loaded = true;
+            syslog(LOG_NOTICE, "Prefetched bitstream %s", path.c_str());
+        } catch (const std::exception &e) {
+            syslog(LOG_WARNING, "Failed to prefetch bitstream %s: %s", path.c_str(), e.what());
+        }
+
+        lck.lock();
+        if (loaded) { cache_stats.n_prefetched++; }
+    }
+}
+
+std::vector<bitstream_t> cSched::evictBitstreams(uint64_t reserve) {
+    std::vector<bitstream_t> evicted;
+    auto it = bitstream_lru.end();
+    while (cache_stats.used + reserve > cache_stats.budget && it != bitstream_lru.begin()) {
+        it--;
+        auto entry = bitstream_cache.find(*it);
+        if (entry->second.pins > 0) {
+            continue;
+        }
+
+        syslog(LOG_NOTICE, "Evicting bitstream %s from the cache", it->c_str());
+        evicted.push_back(entry->second.bitstream);
+        cache_stats.used -= entry->second.size;
+        cache_stats.n_evictions++;
+        bitstream_cache.erase(entry);
+        it = bitstream_lru.erase(it);
+    }
+    return evicted;
+}
+
+void cSched::releaseEvicted(const std::vector<bitstream_t> &evicted) {
+    std::lock_guard<std::mutex> lck(load_lock);
+    for (auto &bitstream : evicted) {
+        freeMem(bitstream.first);
+    }
+}
+
+bitstream_t cSched::loadBitstream(const std::string &path, bool pin) {
+    // Removes the entry (and its reservation) if the bitstream cannot be loaded; waiters then try loading it themselves
+    auto drop = [&](uint64_t size) {
+        {
+            std::lock_guard<std::mutex> lck(cache_lock);
+            cache_stats.used -= size;
+            bitstream_cache.erase(path);
+        }
+        cache_cv.notify_all();
+    };
+
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) == -1) {
+        drop(0);
+        throw std::runtime_error("ERROR: Bitstream " + path + " could not be opened");
+    }
+    uint64_t size = (static_cast<uint64_t>(file_stat.st_size) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    // Reserve the memory, making room for it first
+    std::vector<bitstream_t> evicted;
+    {
+        std::lock_guard<std::mutex> lck(cache_lock);
+        evicted = evictBitstreams(size);
+        if (cache_stats.used + size > cache_stats.budget) {
+            syslog(LOG_WARNING, "Bitstream cache budget of %lu B exceeded, since the cached bitstreams are in use", cache_stats.budget);
+        }
+        cache_stats.used += size;
+        bitstream_cache[path].size = size;
+    }
+
+    bitstream_t bitstream;
+    try {
+        releaseEvicted(evicted);
+        std::lock_guard<std::mutex> lck(load_lock);
+        bitstream = readBitstream(path);
+    } catch (const std::exception &e) {
+        drop(size);
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(cache_lock);
+        cachedBitstream &entry = bitstream_cache[path];
+        entry.bitstream = bitstream;
+        entry.loading = false;
+        entry.pins += pin;
+        bitstream_lru.push_front(path);
+        entry.lru = bitstream_lru.begin();
+    }
+    cache_cv.notify_all();
+
+    syslog(LOG_NOTICE, "Loaded bitstream %s into the cache", path.c_str());
+    return bitstream;
+}
+
+bitstream_t cSched::acquireBitstream(const std::string &path) {
+    std::unique_lock<std::mutex> lck(cache_lock);
+    while (true) {
+        auto entry = bitstream_cache.find(path);
+        if (entry == bitstream_cache.end()) {
+            break;
+        }
+
+        if (!entry->second.loading) {
+            entry->second.pins++;
+            bitstream_lru.splice(bitstream_lru.begin(), bitstream_lru, entry->second.lru);
+            cache_stats.n_hits++;
+            return entry->second.bitstream;
+        }
+
+        // Being prefetched; wait for it rather than reading it twice
+        cache_cv.wait(lck);
+    }
+
+    bitstream_cache.emplace(path, cachedBitstream());
+    cache_stats.n_misses++;
+    lck.unlock();
+    return loadBitstream(path, true);
+}
+
+void cSched::releaseBitstream(const std::string &path) {
+    std::lock_guard<std::mutex> lck(cache_lock);
+    auto entry = bitstream_cache.find(path);
+    if (entry != bitstream_cache.end() && entry->second.pins > 0) {
+        entry->second.pins--;
+    }
+}
+
+bool cSched::reconfigure(int32_t fid) {
+    std::string target_bitstream = functions[fid]->getBitstreamPath();
+    if (!fcnfg.en_pr) {
+        syslog(LOG_WARNING, "Partial reconfiguration is not enabled, however, fid %d requires a different bitstream, skipping", fid);
         return false;
     }
-    if (tasks[task_id_map[tid]]->getTid() != tid) {
-        syslog(LOG_ERR, "UNEXPECTED BUG: ID from task map and list entry differ, map entry tid: %d", tid);
+
+    try {
+        syslog(LOG_NOTICE, "Reconfiguring vFPGA %d, with bitstream %s for fid %d", vfid, target_bitstream.c_str(), fid);
+        bitstream_t bitstream = acquireBitstream(target_bitstream);
+
+        // Only the reconfiguration itself is timed; the cost estimate shouldn't depend on cache misses
+        auto rcnfg_start = std::chrono::steady_clock::now();
+        try {
+            reconfigureBase(bitstream, vfid);
+        } catch (const std::exception &e) {
+            releaseBitstream(target_bitstream);
+            throw;
+        }
+        double rcnfg_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - rcnfg_start).count();
+        releaseBitstream(target_bitstream);
+        syslog(LOG_NOTICE, "Reconfiguration complete in %.0f us", rcnfg_us);
+
+        std::lock_guard<std::mutex> lck(tlock);
+        current_bitstream = target_bitstream;
+        rcnfg_cost_us += policy.rcnfg_alpha * (rcnfg_us - rcnfg_cost_us);
+        func_stats[fid].n_rcnfgs++;
+        return true;
+    } catch (const std::exception &e) {
+        syslog(LOG_ERR, "Exception during reconfiguration: %s", e.what());
         return false;
     }
-    return true;
 }
 
 void cSched::schedule() {
     syslog(LOG_NOTICE, "Starting scheduler thread for vfid %d", vfid);
-    while (scheduler_running) {
-        tlock.lock();
-        int next_idx = -1;
+    std::unique_lock<std::mutex> lck(tlock);
+    while (true) {
+        tcv.wait(lck, [&] { return !scheduler_running || (n_running < n_workers && hasReadyTasks()); });
+        if (!scheduler_running) {
+            break;
+        }
 
-        for (int i = 0; i < tasks.size(); i++) {
-            // Check task is non-null and non-completed
-            if (tasks[i] == nullptr) {
-                continue;
+        cTask *task = nextTask();
+        if (task == nullptr) {
+            continue;
+        }
+        int32_t tid = task->getTid();
+        int32_t fid = task->getFid();
+
+        // Sanity check
+        cThread* cthread = task->getCThread();
+        if (cthread == nullptr || functions.find(fid) == functions.end()) {
+            syslog(LOG_ERR, "UNEXPECTED BUG: Task with ID %d is missing its function signature or corresponding cThread, skipping", tid);
+            if (queued[tid].parked) { n_parked--; }
+            func_stats[fid].queued--;
+            queued.erase(tid);
+            completeTask(task, 1, {});
+            continue;
+        }
+
+        // A cThread only runs one task at a time; park the task until the running one completes
+        if (busy_cthreads.count(cthread)) {
+            if (!queued[tid].parked) {
+                queued[tid].parked = true;
+                n_parked++;
             }
+            parked[cthread].push_back(tid);
+            continue;
+        }
+
+        // Drain barrier: the running tasks must complete, before the vFPGA can be reconfigured for this one
+        // The bitstream is prefetched meanwhile, if it isn't cached yet
+        if (current_bitstream != functions[fid]->getBitstreamPath()) {
+            if (fcnfg.en_pr) { prefetch(functions[fid]->getBitstreamPath()); }
+            tcv.wait(lck, [&] { return n_running == 0; });
+
+            lck.unlock();
+            bool loaded = reconfigure(fid);
+            lck.lock();
 
-            if (tasks[i]->isCompleted()) {
+            // The task may have been cancelled in the meantime
+            if (queued.find(tid) == queued.end()) {
                 continue;
             }
-
-            // Sanity check
-            cThread* cthread = tasks[i]->getCThread();
-            if (cthread == nullptr || functions.find(tasks[i]->getFid()) == functions.end()) {
-                syslog(LOG_ERR, "UNEXPECTED BUG: Task with ID %d is missing its function signature or corresponding cThread, skipping", tasks[i]->getTid());
-                tasks[i]->setRetCode(1);
-                tasks[i]->setCompleted(true);
-                continue;   
+            if (!loaded) {
+                if (queued[tid].parked) { n_parked--; }
+                func_stats[fid].queued--;
+                queued.erase(tid);
+                completeTask(task, 1, {});
+                continue;
             }
+        }
 
-            if (!reorder) {
-                // If reordering is not enabled, process the first task found
-                next_idx = i;
-                break;
-            } else {
-                // Roerdering enabled => minimize the number of reconfigurations needed
-                // However, if all tasks require reconfiguration, process the first one
-                if (next_idx == -1) {
-                    next_idx = i;
-                }
-                
-                std::string target_bitstream = functions[tasks[i]->getFid()]->getBitstreamPath();
-                if (current_bitstream != target_bitstream) {
-                    // Skip this task, requires a different bitstream
-                    continue; 
-                } else {
-                    // Process this task, its bitstream matches the current one
-                    next_idx = i; 
-                    break;
-                }
-            }
+        // Dispatch to the workers
+        schedStats &stats = func_stats[fid];
+        double wait_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - queued[tid].submitted).count();
+        stats.queued--;
+        stats.running++;
+        stats.avg_wait_us += (wait_us - stats.avg_wait_us) / ++stats.n_dispatched;
+        stats.max_wait_us = std::max(stats.max_wait_us, wait_us);
+
+        if (queued[tid].parked) { n_parked--; }
+        queued.erase(tid);
+        busy_cthreads.insert(cthread);
+        n_running++;
+        run_queue.push_back(task);
+        wcv.notify_one();
+
+        // Load the bitstream of the next reconfiguration while this one runs
+        prefetchNext();
+    }
+
+    syslog(LOG_NOTICE, "Stopping scheduler thread for vfid %d", vfid);
+}
+
+void cSched::worker() {
+    std::unique_lock<std::mutex> lck(tlock);
+    while (true) {
+        wcv.wait(lck, [&] { return !scheduler_running || !run_queue.empty(); });
+        if (run_queue.empty()) {
+            break;
+        }
+        cTask *task = run_queue.front();
+        run_queue.pop_front();
+        lck.unlock();
+
+        // Execute the task; the lock is only needed if the vFPGA isn't shared between the workers
+        int32_t ret_code = 0;
+        std::vector<char> ret_val;
+        cThread* cthread = task->getCThread();
+        syslog(LOG_NOTICE, "Executing tid %d, fid %d, vfid %d", task->getTid(), task->getFid(), vfid);
+        try {
+            if (n_workers == 1) { cthread->lock(); }
+            ret_val = functions[task->getFid()]->run(cthread, task->getArgs());
+            cthread->unlock();
+            syslog(LOG_NOTICE, "Executed task with ID %d", task->getTid());
+        } catch (const std::exception &e) {
+            cthread->unlock();      // Unlock in case function execution failed
+            ret_code = 1;
+            syslog(LOG_ERR, "Unknown error executing task with ID %d: %s", task->getTid(), e.what());
         }
-        
-        // Process next task, if there is one
-        if (next_idx != -1) {
-            // If the bitstream is not loaded, reconfigure the vFPGA
-            std::string target_bitstream = functions[tasks[next_idx]->getFid()]->getBitstreamPath();
-            if (current_bitstream != target_bitstream) {
-                if (fcnfg.en_pr) {
-                    try {
-                        syslog(LOG_NOTICE, "Reconfiguring vFPGA %d, with bitstream %s for task with ID %d", vfid, target_bitstream.c_str(), tasks[next_idx]->getTid());
-                        reconfigureBase(functions[tasks[next_idx]->getFid()]->getBitstreamPointer(), vfid);
-                        current_bitstream = target_bitstream;
-                        syslog(LOG_NOTICE, "Reconfiguration complete");
-                    } catch (const std::exception &e) {
-                        syslog(LOG_ERR, "Exception during reconfiguration: %s", e.what());
-                        tasks[next_idx]->setRetCode(1);
-                        tasks[next_idx]->setCompleted(true);
-                    }
-                } else {
-                    syslog(LOG_WARNING, "Partial reconfiguration is not enabled, however, task with ID %d requires a different bitstream, skipping", tasks[next_idx]->getTid());
-                    tasks[next_idx]->setRetCode(1);
-                    tasks[next_idx]->setCompleted(true);
-                }
+
+        lck.lock();
+        func_stats[task->getFid()].running--;
+        n_running--;
+        busy_cthreads.erase(cthread);
+
+        // The next parked task of this cThread can now be dispatched
+        auto p = parked.find(cthread);
+        if (p != parked.end()) {
+            while (!p->second.empty() && queued.find(p->second.front()) == queued.end()) {
+                p->second.pop_front();
             }
-            
-            // Execute the task
-            if (!tasks[next_idx]->isCompleted()) {
-                syslog(LOG_NOTICE, "Executing tid %d, fid %d, vfid %d", tasks[next_idx]->getTid(), functions[tasks[next_idx]->getFid()]->getFid(), vfid);
-                cThread* cthread = tasks[next_idx]->getCThread();
-                try {
-                    cthread->lock();
-                    std::vector<char> ret_val = functions[tasks[next_idx]->getFid()]->run(cthread, tasks[next_idx]->getArgs());
-                    cthread->unlock();
-                    tasks[next_idx]->setRetVal(ret_val);
-                    tasks[next_idx]->setRetCode(0);
-                    tasks[next_idx]->setCompleted(true);
-                    syslog(LOG_NOTICE, "Executed task with ID %d", tasks[next_idx]->getTid());
-                } catch (const std::exception &e) {
-                    cthread->unlock();      // Unlock in case function execution failed
-                    tasks[next_idx]->setRetCode(1);
-                    tasks[next_idx]->setCompleted(true);
-                    syslog(LOG_ERR, "Unknown error executing task with ID %d: %s", tasks[next_idx]->getTid(), e.what());
-                }
+            if (!p->second.empty()) {
+                unparked.push_back(p->second.front());
+                p->second.pop_front();
+            }
+            if (p->second.empty()) {
+                parked.erase(p);
             }
         }
 
-        tlock.unlock();
-        std::this_thread::sleep_for(std::chrono::nanoseconds(DAEMON_PROCESS_REQUESTS_SLEEP));
+        completeTask(task, ret_code, ret_val);
     }
-
-    syslog(LOG_NOTICE, "Stopping scheduler thread for vfid %d", vfid);
 }
 
 void cSched::start() {
+    std::lock_guard<std::mutex> lck(tlock);
     if (scheduler_running) {
         syslog(LOG_NOTICE, "Scheduler thread for vfid %d is already running, not starting again", vfid);
         return;
     }
     scheduler_running = true;
+    {
+        std::lock_guard<std::mutex> cache_lck(cache_lock);
+        prefetch_running = true;
+    }
+    prefetch_thread = std::thread(&cSched::prefetcher, this);
     scheduler_thread = std::thread(&cSched::schedule, this);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        workers.emplace_back(&cSched::worker, this);
+    }
 }
 
 void cSched::stop() {
-    if (!scheduler_running) {
-        syslog(LOG_NOTICE, "Scheduler thread for vfid %d is not running, nothing to stop", vfid);
-        return;
+    {
+        std::lock_guard<std::mutex> lck(tlock);
+        if (!scheduler_running) {
+            syslog(LOG_NOTICE, "Scheduler thread for vfid %d is not running, nothing to stop", vfid);
+            return;
+        }
+        scheduler_running = false;
     }
-    scheduler_running = false;
+    tcv.notify_all();
     if (scheduler_thread.joinable()) {
         scheduler_thread.join();
     }
+
+    // Workers finish the already dispatched tasks
+    wcv.notify_all();
+    for (auto &w : workers) {
+        if (w.joinable()) {
+            w.join();
+        }
+    }
+    workers.clear();
+
+    // An ongoing prefetch is completed; its bitstream stays cached
+    {
+        std::lock_guard<std::mutex> lck(cache_lock);
+        prefetch_running = false;
+        prefetch_path.clear();
+    }
+    cache_cv.notify_all();
+    if (prefetch_thread.joinable()) {
+        prefetch_thread.join();
+    }
+}
+
+void cSched::setWorkers(uint32_t n) {
+    std::lock_guard<std::mutex> lck(tlock);
+    if (scheduler_running) {
+        syslog(LOG_WARNING, "Scheduler for vfid %d is already running, cannot change the number of workers", vfid);
+        return;
+    }
+    if (n < 1 || n > N_CTID_MAX) {
+        syslog(LOG_WARNING, "Invalid number of workers %u for vfid %d, keeping %u", n, vfid, n_workers);
+        return;
+    }
+    n_workers = n;
+}
+
+uint32_t cSched::getWorkers() {
+    std::lock_guard<std::mutex> lck(tlock);
+    return n_workers;
 }
 
 bool cSched::addTask(std::unique_ptr<cTask> task) {
@@ -188,47 +575,142 @@ bool cSched::addTask(std::unique_ptr<cTask> task) {
     }
 
     int32_t tid = task->getTid();
-    if (task_id_map.find(tid) != task_id_map.end()) {
-        syslog(LOG_WARNING, "Task with ID %d already exists in the scheduler", task->getTid());
-        return false;
-    }
-
     if (!isFunctionRegistered(task->getFid())) {
         syslog(LOG_WARNING, "Function for task %d with fid %d is not registered in the scheduler", task->getTid(), task->getFid());
         return false;
     }
+    std::string target_bitstream = functions[task->getFid()]->getBitstreamPath();
+
+    {
+        std::lock_guard<std::mutex> lck(tlock);
+        if (tasks.find(tid) != tasks.end()) {
+            syslog(LOG_WARNING, "Task with ID %d already exists in the scheduler", tid);
+            return false;
+        }
+
+        // IMPORTANT: Due to the move, after the following line, this function has no ownership of the task pointer
+        // Therefore, any operation, such as task->(...), will cause a segmentation fault
+        // Note the use of tid instead of task->getTid() to avoid dereferencing the moved task pointer
+        func_stats[task->getFid()].queued++;
+        tasks.emplace(tid, std::move(task)); 
+        queued.emplace(tid, queuedTask{std::chrono::steady_clock::now(), false});
+        if (reorder) {
+            ready_queues[target_bitstream].push_back(tid);
+        } else {
+            arrival_queue.push_back(tid);
+        }
+        prefetchNext();
+    }
+    tcv.notify_one();
 
-    tlock.lock();
-    // IMPORTANT: Due to the move, after the following line, this function has no ownership of the task pointer
-    // Therefore, any operation, such as task->(...), will cause a segmentation fault
-    // Note the use of tid instead of task->getTid() to avoid dereferencing the moved task pointer
-    tasks.push_back(std::move(task)); 
-    task_id_map.emplace(tid, tasks.size() - 1);
-    tlock.unlock();
     syslog(LOG_NOTICE, "Added task with ID %d to the scheduler", tid);
     return true;
 }
 
-bool cSched::isTaskCompleted(int32_t tid) {
-    tlock.lock();
-    if (!taskChecker(tid)) {
-        tlock.unlock();
+bool cSched::releaseTask(int32_t tid) {
+    std::lock_guard<std::mutex> lck(tlock);
+    auto it = tasks.find(tid);
+    if (it == tasks.end()) {
+        syslog(LOG_WARNING, "Task with ID %d not found in the scheduler, cannot release it", tid);
         return false;
     }
-    bool completed = tasks[task_id_map[tid]]->isCompleted();
-    tlock.unlock();
-    return completed;
+
+    // Queued tasks are cancelled; their queue entries are skipped when they reach the front
+    auto q = queued.find(tid);
+    if (q != queued.end()) {
+        if (q->second.parked) { n_parked--; }
+        queued.erase(q);
+        func_stats[it->second->getFid()].queued--;
+        tasks.erase(it);
+    } else if (it->second->isCompleted()) {
+        tasks.erase(it);
+    } else {
+        orphaned.insert(tid);
+    }
+    return true;
 }
 
-cTask* cSched::getTask(int32_t tid) {
-    tlock.lock();
-    if (!taskChecker(tid)) {
-        tlock.unlock();
-        return nullptr;
+void cSched::setPolicy(schedPolicy policy) {
+    std::lock_guard<std::mutex> lck(tlock);
+    this->policy = policy;
+    rcnfg_cost_us = policy.rcnfg_cost_us;
+}
+
+schedPolicy cSched::getPolicy() {
+    std::lock_guard<std::mutex> lck(tlock);
+    return policy;
+}
+
+double cSched::getRcnfgCost() {
+    std::lock_guard<std::mutex> lck(tlock);
+    return rcnfg_cost_us;
+}
+
+std::string cSched::getCurrentBitstream() {
+    std::lock_guard<std::mutex> lck(tlock);
+    return current_bitstream;
+}
+
+int cSched::getCompletionFd() {
+    std::lock_guard<std::mutex> lck(tlock);
+    if (cmpl_fd == -1) {
+        cmpl_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (cmpl_fd == -1) {
+            throw std::runtime_error("ERROR: Failed to create completion eventfd, vfid: " + std::to_string(vfid));
+        }
+    }
+    return cmpl_fd;
+}
+
+std::vector<int32_t> cSched::takeCompleted() {
+    std::lock_guard<std::mutex> lck(tlock);
+    std::vector<int32_t> tids;
+    tids.swap(completed);
+    return tids;
+}
+
+uint32_t cSched::getLoad(int32_t fid) {
+    std::lock_guard<std::mutex> lck(tlock);
+    if (fid == -1) {
+        return queued.size() + n_running;
     }
-    cTask* task = tasks[task_id_map[tid]].get();
-    tlock.unlock();
-    return task;
+    auto stats = func_stats.find(fid);
+    return stats != func_stats.end() ? stats->second.queued + stats->second.running : 0;
+}
+
+void cSched::setCacheBudget(uint64_t bytes) {
+    std::vector<bitstream_t> evicted;
+    {
+        std::lock_guard<std::mutex> lck(cache_lock);
+        cache_stats.budget = bytes;
+        evicted = evictBitstreams(0);
+    }
+    releaseEvicted(evicted);
+}
+
+bitstreamCacheStats cSched::getCacheStats() {
+    std::lock_guard<std::mutex> lck(cache_lock);
+    bitstreamCacheStats stats = cache_stats;
+    stats.n_cached = bitstream_cache.size();
+    return stats;
+}
+
+std::map<int32_t, schedStats> cSched::getFunctionStats() {
+    std::lock_guard<std::mutex> lck(tlock);
+    return func_stats;
+}
+
+bool cSched::isTaskCompleted(int32_t tid) {
+    std::lock_guard<std::mutex> lck(tlock);
+    auto it = tasks.find(tid);
+    // Don't add print here; as this condition can happen often causing too many prints
+    return it != tasks.end() && it->second->isCompleted();
+}
+
+cTask* cSched::getTask(int32_t tid) {
+    std::lock_guard<std::mutex> lck(tlock);
+    auto it = tasks.find(tid);
+    return it != tasks.end() ? it->second.get() : nullptr;
 }
 
 bool cSched::isFunctionRegistered(int32_t fid) {
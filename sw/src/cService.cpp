@@ -35,8 +35,65 @@ cService::cService(std::string name, bool remote, int32_t vfid, uint32_t device,
     service_id = ("coyote-daemon-dev-" + std::to_string(device) + "-vfid-" + std::to_string(vfid) + "-" + name).c_str();
     socket_name = ("/tmp/" + service_id).c_str();
     sockfd = -1;
+    epfd = -1;
+    cmpl_fd = -1;
     task_counter = 0;
     scheduler = cSched::getInstance(vfid, device, reorder);
+    dev_scheduler = nullptr;
+}
+
+cService::cService(std::string name, bool remote, std::vector<int32_t> vfids, uint32_t device, bool reorder, uint16_t port):
+    is_running(false), remote(remote), vfid(-1), device(device), port(port) {
+    service_id = ("coyote-daemon-dev-" + std::to_string(device) + "-" + name).c_str();
+    socket_name = ("/tmp/" + service_id).c_str();
+    sockfd = -1;
+    epfd = -1;
+    cmpl_fd = -1;
+    task_counter = 0;
+    scheduler = nullptr;
+    dev_scheduler = cDevSched::getInstance(device, vfids, reorder);
+}
+
+bFunc* cService::getFunction(int32_t fid) {
+    if (dev_scheduler != nullptr) {
+        return dev_scheduler->getFunction(fid);
+    }
+    return scheduler->isFunctionRegistered(fid) ? scheduler->getFunction(fid) : nullptr;
+}
+
+bool cService::addTask(std::unique_ptr<cTask> task, pid_t rpid) {
+    if (dev_scheduler != nullptr) {
+        return dev_scheduler->addTask(std::move(task), rpid) != -1;
+    }
+    return scheduler->addTask(std::move(task));
+}
+
+cTask* cService::getTask(int32_t tid) {
+    return dev_scheduler != nullptr ? dev_scheduler->getTask(tid) : scheduler->getTask(tid);
+}
+
+bool cService::releaseTask(int32_t tid) {
+    if (dev_scheduler != nullptr) {
+        dev_scheduler->releaseTask(tid);
+        return dev_scheduler->getTask(tid) != nullptr;
+    }
+    scheduler->releaseTask(tid);
+    return scheduler->getTask(tid) != nullptr;
+}
+
+void cService::releaseClient(pid_t rpid) {
+    if (dev_scheduler == nullptr || rpid == -1) {
+        return;
+    }
+
+    // The Coyote threads are shared by all the connections of a process
+    for (auto &[connfd, conn] : conns) {
+        if (conn->rpid == rpid) { return; }
+    }
+    for (auto &conn : closed_conns) {
+        if (conn->rpid == rpid) { return; }
+    }
+    dev_scheduler->releaseClient(rpid);
 }
 
 void cService::sigHandler(int signum) {
@@ -56,12 +113,22 @@ void cService::daemonSigHandler(int signum) {
     if (signum == SIGTERM || signum == SIGKILL) {
         syslog(LOG_NOTICE, "SIGTERM received, exiting...\n");
 
-        scheduler->stop();
+        if (dev_scheduler != nullptr) {
+            dev_scheduler->stop();
+        } else {
+            scheduler->stop();
+        }
 
-        // TODO: Do we need to add active connection to conns_to_clean?
-        run_cleanup_thread = false;
-        if (cleanup_thread.joinable()) {
-            cleanup_thread.join();
+        // The scheduler has finished all the running tasks, so the connections can be released
+        for (auto &[connfd, conn] : conns) {
+            ::close(connfd);
+        }
+        conns.clear();
+        ring_conns.clear();
+        closed_conns.clear();
+        task_conns.clear();
+        if (epfd != -1) {
+            ::close(epfd);
         }
 
         unlink(socket_name.c_str());
@@ -114,7 +181,7 @@ void cService::initSocket() {
         syslog(LOG_NOTICE, "Initializating socket for remote connections");
 
         // Create the socket and check if it's successful
-        sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
         if (sockfd == -1) {
             syslog(LOG_ERR, "Error creating server socket");
             exit(EXIT_FAILURE);
@@ -139,7 +206,7 @@ void cService::initSocket() {
         syslog(LOG_NOTICE, "Initializating socket for local connections");
 
         // Create a local socket for IPC and check success
-        if ((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+        if ((sockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0)) == -1) {
             syslog(LOG_ERR, "Error creating server socket");
             exit(EXIT_FAILURE);
         }
@@ -166,324 +233,597 @@ void cService::initSocket() {
 
 }
 
-void cService::cleanConns() {
-    syslog(LOG_NOTICE, "Starting cleanConns thread");
-
-    while (run_cleanup_thread) {
-        // Iterate over the connection and release the ones that are stale
-        auto tmp = conns_to_clean.begin();
-        while (tmp != conns_to_clean.end()) {
-            int connfd = (*tmp).first;
-            bool is_stale = (*tmp).second;
-
-            if (is_stale) {
-                syslog(LOG_NOTICE, "Releasing resources for connection %d", connfd);
-                // Join the thread for processing requests and sending responses
-                if (connection_threads.find(connfd) != connection_threads.end()) {
-                    if (connection_threads[connfd].first.joinable()) {
-                        connection_threads[connfd].first.join();
-                    }
-                    if (connection_threads[connfd].second.joinable()) {
-                        connection_threads[connfd].second.join();
+void cService::acceptConnectionsLocal() {
+    while (true) {
+        sockaddr_un client_addr;
+        socklen_t len = sizeof(client_addr); 
+        int connfd = accept4(sockfd, (struct sockaddr *) &client_addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connfd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                syslog(LOG_WARNING, "Failed to accept connection, errno: %d", errno);
+            }
+            return;
+        }
+    
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = connfd;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev) == -1) {
+            syslog(LOG_ERR, "Could not register connfd: %d with epoll, closing connection", connfd);
+            ::close(connfd);
+            continue;
+        }
+
+        /*
+         * Each client is uniquely identified by its connection file descriptor (connfd); at any given time, 
+         * no two clients will have the same value of connfd. However, it's possible that a connfd with the 
+         * same value is opened later (the cService has no control over the connection file descriptors, 
+         * they are assigned by the OS). Therefore, the state is removed from conns as soon as the connection 
+         * is closed, see closeConnection().
+         */
+        std::unique_ptr<connState> conn = std::make_unique<connState>();
+        conn->connfd = connfd;
+        conn->rpid = -1;
+        conns[connfd] = std::move(conn);
+        syslog(LOG_NOTICE, "Accepted local connection, connfd: %d", connfd);
+    }
+}
+
+bool cService::readConnection(connState *conn) {
+    // Drain the socket; it is non-blocking, so read until there is no more data
+    char recv_buff[RECV_BUFF_SIZE];
+    bool closed = false;
+    while (!closed) {
+        // Buffer registrations carry a file descriptor, so the ancillary data must be received as well
+        char ctrl[CMSG_SPACE(4 * sizeof(int))];
+        struct iovec iov = { recv_buff, RECV_BUFF_SIZE };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        ssize_t n = recvmsg(conn->connfd, &msg, MSG_CMSG_CLOEXEC);
+        if (n > 0) {
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                    size_t n_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    for (size_t i = 0; i < n_fds; i++) {
+                        int fd;
+                        memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                        conn->recv_fds.push_back(fd);
                     }
-                    connection_threads.erase(connfd);
-                }
-                
-                // Release the Coyote thread
-                if (coyote_threads.find(connfd) != coyote_threads.end()) {
-                    coyote_threads.erase(connfd);
                 }
+            }
+            conn->recv_buf.insert(conn->recv_buf.end(), recv_buff, recv_buff + n);
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            syslog(LOG_NOTICE, "Client with connfd %d disconnected", conn->connfd);
+            closed = true;
+        }
+    }
 
-                // Delete the task entry and the corresponding lock associated to this client
-                if (tasks.find(connfd) != tasks.end()) {
-                    tasks.erase(connfd);
-                }
+    // Process all the complete requests received so far
+    size_t offset = 0;
+    bool close_requested = false;
+    while (!close_requested && offset < conn->recv_buf.size()) {
+        size_t consumed = processRequest(conn, conn->recv_buf.data() + offset, conn->recv_buf.size() - offset, close_requested);
+        if (consumed == 0) {
+            break;
+        }
+        offset += consumed;
+    }
+    conn->recv_buf.erase(conn->recv_buf.begin(), conn->recv_buf.begin() + offset);
 
-                if (task_locks.find(connfd) != task_locks.end()) {
-                    task_locks.erase(connfd);
-                }
+    if (closed || close_requested) {
+        closeConnection(conn);
+        return false;
+    }
+    return true;
+}
 
-                // Delete the is_stale entry for this confd; done in case there are future connections with the same connfd value. 
-                // See acceptConnectionLocal() function for an explanation when this could happen.
-                tmp = conns_to_clean.erase(tmp);
-                syslog(LOG_NOTICE, "Resources released");
+size_t cService::processRequest(connState *conn, const char *buf, size_t len, bool &closed) {
+    int connfd = conn->connfd;
 
-                if (tmp != conns_to_clean.end()) {
-                    tmp++;
-                }
+    // The first message of each client is its "remote" process ID 
+    if (conn->rpid == -1) {
+        if (len < sizeof(pid_t)) {
+            return 0;
+        }
+
+        pid_t rpid;
+        memcpy(&rpid, buf, sizeof(pid_t));
+        try {
+            if (dev_scheduler == nullptr) {
+                conn->coyote_thread = std::make_unique<cThread>(vfid, rpid, device);
             }
+        } catch (const std::exception &e) {
+            syslog(LOG_ERR, "Failed to create Coyote thread for connfd: %d, pid: %d: %s", connfd, rpid, e.what());
+            closed = true;
+            return sizeof(pid_t);
         }
+        conn->rpid = rpid;
+        syslog(LOG_NOTICE, "Registered pid: %d", rpid);
+        return sizeof(pid_t);
+    }
 
-        std::this_thread::sleep_for(std::chrono::microseconds(DAEMON_CLEAN_CONNS_SLEEP));
+    // Read opcode (DEF_OP_CLOSE_CONN or DEF_OP_SUBMIT_TASK)
+    if (len < 3 * sizeof(int32_t)) {
+        return 0;
     }
-}
+    int32_t request[3];
+    memcpy(&request, buf, 3 * sizeof(int32_t));
+    int32_t opcode = request[0];
+
+    switch (opcode) {
+        case DEF_OP_CLOSE_CONN: {
+            syslog(LOG_NOTICE, "Received close connection request for client with connfd %d", connfd);
+            closed = true;
+            return 3 * sizeof(int32_t);
+        }
 
-void cService::processRequests(int connfd) {
-    bool running = true;
-    syslog(LOG_NOTICE, "Starting connection thread for client with connfd %d", connfd);
-
-    while (running) {
-        char recv_buf[RECV_BUFF_SIZE];
-        if (read(connfd, recv_buf, 3 * sizeof(int32_t)) == 3 * sizeof(int32_t)) {
-            // Read opcode (DEF_OP_CLOSE_CONN or DEF_OP_SUBMIT_TASK)
-            int32_t request[3];
-            memcpy(&request, recv_buf, 3 * sizeof(int32_t));
-            int32_t opcode = request[0];
-
-            switch (opcode) {
-                case DEF_OP_CLOSE_CONN: {
-                    syslog(LOG_NOTICE, "Received close connection request for client with connfd %d", connfd);
-                    close(connfd);
-                    running = false;
-                    break;
-                }
+        case DEF_OP_SUBMIT_TASK: {
+            // Read function and task ID; check if the function ID has been registered with the service; 
+            // If not, return appropriate (error) code and stop function execution
+            int32_t fid = request[1];
+            int32_t client_tid = request[2];
+            
+            // If the function is not found, stop execution
+            bFunc *requested_func = getFunction(fid);
+            if (requested_func == nullptr) {
+                syslog(LOG_WARNING, "Client %d requested unkown function, fid: %d with client_tid: %d, stopping request...", connfd, fid, client_tid);
+                sendResponse(conn, 1, client_tid);
+                return 3 * sizeof(int32_t);
+            }
 
-                case DEF_OP_SUBMIT_TASK: {
-                    // Read function and task ID; check if the function ID has been registered with the service; 
-                    // If not, return appropriate (error) code and stop function execution
-                    int32_t fid = request[1];
-                    int32_t client_tid = request[2];
-                    
-                    // If the function is not found, stop execution
-                    if (!scheduler->isFunctionRegistered(fid)) {
-                        syslog(LOG_WARNING, "Client %d requested unkown function, fid: %d with client_tid: %d, stopping request...", connfd, fid, client_tid);
-                        bool send_buff[RECV_BUFF_SIZE];
-                        int32_t ret_code = 1;
-                        memcpy(send_buff, &ret_code, sizeof(int32_t));
-                        memcpy(send_buff + sizeof(int32_t), &client_tid, sizeof(int32_t));
-                        if (write(connfd, &send_buff, 2 * sizeof(int32_t)) != 2 * sizeof(int32_t)) {
-                            syslog(LOG_ERR, "Return code could not be sent, connfd: %d, client_tid: %d", connfd, client_tid);
-                        } 
-                        break;
-                    }
-                    
-                    // Otherwise, function is found and the task can be submitted to the scheduler
-                    bFunc *requested_func = scheduler->getFunction(fid);
-                    if (requested_func == nullptr) {
-                        syslog(LOG_ERR, "UNEXPECTED BUG: Function with fid: %d marked as registered, but scheduler returned nullptr?!", fid);
-                        continue;
-                    }
-                    syslog(LOG_NOTICE, "Client %d requested function fid: %d with client_tid: %d", connfd, fid, client_tid);
-
-                    // Parse client arguments and store into a vector of char buffers; one for each function argument
-                    int32_t ret_code = 0;
-                    std::vector<std::vector<char>> arguments;     
-                    std::vector<size_t> argument_sizes = requested_func->getArgumentSizes();
-
-                    for (size_t &arg_size: argument_sizes) {
-                        char recv_buff[RECV_BUFF_SIZE];
-                        if (read(connfd, recv_buff, arg_size) == arg_size) {
-                            std::vector<char> arg(recv_buff, recv_buff + arg_size);
-                            arguments.emplace_back(arg);
-                        } else {
-                            // Failed to parse arguments; inform client and stop execution
-                            syslog(LOG_WARNING, "Could not parse function arguments, fid: %d, connfd: %d, returning 1", fid, connfd);
-                            bool send_buff[RECV_BUFF_SIZE];
-                            ret_code = 1;
-                            memcpy(send_buff, &ret_code, sizeof(int32_t));
-                            memcpy(send_buff + sizeof(int32_t), &client_tid, sizeof(int32_t));
-                            if (write(connfd, &send_buff, 2 * sizeof(int32_t)) != 2 * sizeof(int32_t)) {
-                                syslog(LOG_ERR, "Return code could not be sent, connfd: %d, client_tid: %d", connfd, client_tid);
-                            }
-                            break;
-                        }
-                    }
+            // Wait until all the function arguments have been received
+            std::vector<size_t> argument_sizes = requested_func->getArgumentSizes();
+            size_t request_size = 3 * sizeof(int32_t);
+            for (size_t &arg_size: argument_sizes) {
+                request_size += arg_size;
+            }
+            if (len < request_size) {
+                return 0;
+            }
+            syslog(LOG_NOTICE, "Client %d requested function fid: %d with client_tid: %d", connfd, fid, client_tid);
 
-                    // If ret code is not zero, it means that the arguments could not be parsed; stop execution
-                    if (ret_code) { break; }
-
-                    // Check entries for this client connections exist --- they always should as they are created when client connects
-                    // However, double check to avoid segmentation faults that can crash the server
-                    if (tasks.find(connfd) == tasks.end() || task_locks.find(connfd) == task_locks.end()) {
-                        syslog(LOG_ERR, "UNEXPECTED BUG: No task entry found in map for connfd: %d", connfd);
-                        ret_code = 1;
-                        bool send_buff[RECV_BUFF_SIZE];
-                        memcpy(send_buff, &ret_code, sizeof(int32_t));
-                        memcpy(send_buff + sizeof(int32_t), &client_tid, sizeof(int32_t));
-                        if (write(connfd, &send_buff, 2 * sizeof(int32_t)) != 2 * sizeof(int32_t)) {
-                            syslog(LOG_ERR, "Return code could not be sent, connfd: %d, client_tid: %d", connfd, client_tid);
-                        }
-                        break;
-                    }
+            submitTask(conn, requested_func, client_tid, buf + 3 * sizeof(int32_t), false);
+            return request_size;
+        }
 
-                    // Create a new task and add it to the scheduler; if for some reason the task could not be added, return an error code to the client
-                    int32_t server_tid = task_counter++;
-                    task_locks[connfd]->lock();
-                    tasks[connfd].emplace_back(client_tid, server_tid);
-                    task_locks[connfd]->unlock();
-
-                    std::unique_ptr<cTask> task = std::make_unique<cTask>(server_tid, fid,  requested_func->getReturnSize(), coyote_threads[connfd].get(), std::move(arguments));
-                    bool task_added = scheduler->addTask(std::move(task));
-
-                    if (!task_added) {
-                        syslog(
-                            LOG_ERR, 
-                            "Could not add task with server_tid: %d, client_tid: %d, fid: %d, connfd: %d; most likely a server error; returning error code",
-                            server_tid, client_tid, fid, connfd
-                        );
-                        bool send_buff[RECV_BUFF_SIZE];
-                        ret_code = 1;
-                        memcpy(send_buff, &ret_code, sizeof(int32_t));
-                        memcpy(send_buff + sizeof(int32_t), &client_tid, sizeof(int32_t));
-                        if (write(connfd, &send_buff, 2 * sizeof(int32_t)) != 2 * sizeof(int32_t)) {
-                            syslog(LOG_ERR, "Return code could not be sent, connfd: %d, client_tid: %d", connfd, client_tid);
-                        }
-                        break;
-                    }
+        case DEF_OP_SHM_RING: {
+            setupRing(conn, request[2]);
+            return 3 * sizeof(int32_t);
+        }
 
-                    syslog(
-                        LOG_NOTICE, 
-                        "Added task with server_tid: %d, client_tid: %d, fid: %d, connfd: %d to scheduler queue",
-                        server_tid, client_tid, fid, connfd
-                    );
-                    break;
-                    
-                }
-                
-                default: {
-                    syslog(LOG_WARNING, "Received unknown request from client %d with opcode %d, ignoring...", connfd, opcode);
-                    break;
-                }
+        case DEF_OP_REG_BUFFER: {
+            registerRegion(conn, request[1], request[2]);
+            return 3 * sizeof(int32_t);
+        }
+
+        case DEF_OP_UNREG_BUFFER: {
+            // The client only releases a region once none of its tasks use it
+            auto region = conn->regions.find(request[1]);
+            if (region != conn->regions.end()) {
+                munmap(region->second.first, region->second.second);
+                conn->regions.erase(region);
+                sendResponse(conn, 0, request[2]);
+            } else {
+                sendResponse(conn, 1, request[2]);
             }
+            return 3 * sizeof(int32_t);
+        }
+        
+        default: {
+            syslog(LOG_WARNING, "Received unknown request from client %d with opcode %d, ignoring...", connfd, opcode);
+            return 3 * sizeof(int32_t);
+        }
+    }
+}
 
+void cService::submitTask(connState *conn, bFunc *fn, int32_t client_tid, const char *args, bool ring) {
+    int32_t fid = fn->getFid();
+
+    // Parse client arguments and store into a vector of char buffers; one for each function argument
+    // Buffer arguments only hold the location of the buffer, which is translated to the service's mapping (for the CPU)
+    std::vector<std::vector<char>> arguments;     
+    std::vector<size_t> argument_sizes = fn->getArgumentSizes();
+    std::vector<bool> buffer_arguments = fn->getBufferArguments();
+    size_t offset = 0;
+    for (size_t i = 0; i < argument_sizes.size(); i++) {
+        arguments.emplace_back(args + offset, args + offset + argument_sizes[i]);
+        offset += argument_sizes[i];
+
+        if (buffer_arguments[i]) {
+            cBuffer buf;
+            memcpy(&buf, arguments.back().data(), sizeof(cBuffer));
+            if (!resolveBuffer(conn, buf)) {
+                syslog(LOG_WARNING, "Client %d passed an invalid buffer, fid: %d, client_tid: %d, region: %d", conn->connfd, fid, client_tid, buf.region);
+                sendResponse(conn, 1, client_tid, {}, ring);
+                return;
+            }
+            memcpy(arguments.back().data(), &buf, sizeof(cBuffer));
         }
+    }
+
+    // Create a new task and add it to the scheduler; if for some reason the task could not be added, return an error code to the client
+    int32_t server_tid = task_counter++;
+    conn->tasks.emplace(server_tid, connState::connTask{client_tid, ring});
+    task_conns.emplace(server_tid, conn);
+
+    std::unique_ptr<cTask> task = std::make_unique<cTask>(server_tid, fid, fn->getReturnSize(), conn->coyote_thread.get(), std::move(arguments));
+    bool task_added = addTask(std::move(task), conn->rpid);
+
+    if (!task_added) {
+        syslog(
+            LOG_ERR, 
+            "Could not add task with server_tid: %d, client_tid: %d, fid: %d, connfd: %d; most likely a server error; returning error code",
+            server_tid, client_tid, fid, conn->connfd
+        );
+        conn->tasks.erase(server_tid);
+        task_conns.erase(server_tid);
+        sendResponse(conn, 1, client_tid, {}, ring);
+        return;
+    }
+
+    syslog(
+        LOG_NOTICE, 
+        "Added task with server_tid: %d, client_tid: %d, fid: %d, connfd: %d to scheduler queue",
+        server_tid, client_tid, fid, conn->connfd
+    );
+}
 
-        std::this_thread::sleep_for(std::chrono::nanoseconds(DAEMON_PROCESS_REQUESTS_SLEEP));
+void cService::registerRegion(connState *conn, int32_t region, int32_t client_tid) {
+    if (conn->recv_fds.empty()) {
+        syslog(LOG_WARNING, "Client %d registered region %d without a file descriptor", conn->connfd, region);
+        sendResponse(conn, 1, client_tid);
+        return;
+    }
+    int fd = conn->recv_fds.front();
+    conn->recv_fds.pop_front();
+
+    // The size of the region is the size of the file (memfd)
+    struct stat st;
+    void *mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && conn->regions.find(region) == conn->regions.end()) {
+        mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
 
+    if (mem == MAP_FAILED) {
+        syslog(LOG_WARNING, "Could not map region %d of client %d", region, conn->connfd);
+        sendResponse(conn, 1, client_tid);
+        return;
     }
 
-    conns_to_clean.emplace(connfd, true);
-    syslog(LOG_NOTICE, "Connection %d closing ...", connfd);
+    conn->regions.emplace(region, std::make_pair(mem, (size_t) st.st_size));
+    syslog(LOG_NOTICE, "Registered region %d of client %d, size: %ld", region, conn->connfd, (long) st.st_size);
+    sendResponse(conn, 0, client_tid);
+}
+
+bool cService::resolveBuffer(connState *conn, cBuffer &buf) {
+    auto region = conn->regions.find(buf.region);
+    if (region == conn->regions.end() || buf.offset > region->second.second || buf.size > region->second.second - buf.offset) {
+        return false;
+    }
 
+    // The client sends its own address of the buffer, kept for FPGA transfers through its cThread; it can only
+    // point into the client's memory, so it is not checked. The software vFPGA, however, runs in the service process
+#ifndef EN_SOFT_VFPGA
+    buf.client_data = buf.data;
+#else
+    buf.client_data = nullptr;
+#endif
+    buf.data = static_cast<char*>(region->second.first) + buf.offset;
+    return true;
 }
 
-void cService::sendResponses(int connfd) {
-    syslog(LOG_NOTICE, "Starting response thread for client with connfd %d", connfd);
-    bool run_response_thread = true;
+bool cService::exportBuffer(connState *conn, cBuffer &buf) {
+    char *data = static_cast<char*>(buf.data);
+    for (auto &[id, region] : conn->regions) {
+        char *base = static_cast<char*>(region.first);
+        if (data >= base && data <= base + region.second && buf.size <= (size_t) (base + region.second - data)) {
+            buf.region = id;
+            buf.offset = data - base;
+            buf.data = nullptr;
+            buf.client_data = nullptr;
+            return true;
+        }
+    }
+    return false;
+}
+
+void cService::setupRing(connState *conn, int32_t client_tid) {
+    // The file descriptors must not overtake earlier responses, so queues are only set up before any task is submitted
+    std::unique_ptr<cShmRing> ring;
+    if (conn->ring == nullptr && conn->send_buf.empty() && conn->tasks.empty()) {
+        try {
+            ring = std::make_unique<cShmRing>();
+        } catch (const std::exception &e) {
+            syslog(LOG_WARNING, "Could not set up shared memory ring for connfd: %d: %s", conn->connfd, e.what());
+        }
+    }
     
-    while (run_response_thread) {
-        // Move sleep here instead of at the end; in case the following if skips this iteration
-        std::this_thread::sleep_for(std::chrono::nanoseconds(DAEMON_PROCESS_REQUESTS_SLEEP));
-
-        // For completness sake, check if there is an entry for this connection in the tasks map
-        // However, this should always be the case, as the connection thread is started only after the entry is created
-        bool entry_found = tasks.find(connfd) != tasks.end() && task_locks.find(connfd) != task_locks.end() ? true : false;
-        if (!entry_found) {
-            continue;
+    if (ring != nullptr) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = ring->getSubmitFd();
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, ring->getSubmitFd(), &ev) == -1) {
+            syslog(LOG_WARNING, "Could not register shared memory ring of connfd: %d with epoll", conn->connfd);
+            ring.reset();
         }
+    }
 
-        // Lock the mutex and iterate over the tasks for this connection
-        task_locks[connfd]->lock();
-        auto tmp = tasks[connfd].begin();
-        while (tmp != tasks[connfd].end()) {
-            int32_t client_tid = (*tmp).first;
-            int32_t server_tid = (*tmp).second;
-            
-            if (scheduler->isTaskCompleted(server_tid)) {
-                cTask *task = scheduler->getTask(server_tid);
-                if (task == nullptr) {
-                    syslog(LOG_ERR, "UNEXPECTED BUG: Task with server_tid: %d, connfd: %d marked as completed, but scheduler returned nullptr?!", server_tid, connfd);
-                    continue;
-                }
-                
-                // Function completed sucessfully, write success return code and task ID 
-                bool send_buff[RECV_BUFF_SIZE];
-                int32_t ret_code = 0;
-                memcpy(send_buff, &ret_code, sizeof(int32_t));
-                memcpy(send_buff + sizeof(int32_t), &client_tid, sizeof(int32_t));
-                if (write(connfd, &send_buff, 2 * sizeof(int32_t)) != 2 * sizeof(int32_t)) {
-                    syslog(LOG_ERR, "Return code could not be sent, connfd: %d, client_tid: %d", connfd, client_tid);
-                    break;
-                }
-                    
-                size_t return_size = task->getRetValSize();
-                if (write(connfd, task->getRetVal().data(), return_size) != return_size) {
-                    syslog(LOG_ERR, "Return value could not be sent, connfd: %d, client_tid: %d", connfd, client_tid);
-                }
+    if (ring == nullptr) {
+        sendResponse(conn, 1, client_tid);
+        return;
+    }
 
-                // Remove the task from the list to avoid sending the response again
-                tmp = tasks[connfd].erase(tmp);
-                syslog(LOG_NOTICE, "Sent response for task with server_tid: %d, client_tid: %d, connfd: %d", server_tid, client_tid, connfd);
-            
-            }
+    // Response (success, task ID), with the memfd and the event file descriptors attached
+    int32_t resp[2] = { 0, client_tid };
+    struct iovec iov = { resp, sizeof(resp) };
+    int fds[3] = { ring->getMemFd(), ring->getSubmitFd(), ring->getCompletionFd() };
+    char ctrl[CMSG_SPACE(sizeof(fds))];
+    memset(ctrl, 0, sizeof(ctrl));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    if (sendmsg(conn->connfd, &msg, MSG_NOSIGNAL) != sizeof(resp)) {
+        syslog(LOG_ERR, "Shared memory ring could not be sent, connfd: %d", conn->connfd);
+        epoll_ctl(epfd, EPOLL_CTL_DEL, ring->getSubmitFd(), nullptr);
+        return;
+    }
 
-            if (tmp != tasks[connfd].end()) {
-                tmp++;
+    ring_conns[ring->getSubmitFd()] = conn;
+    conn->ring = std::move(ring);
+    syslog(LOG_NOTICE, "Set up shared memory ring for connfd: %d", conn->connfd);
+}
+
+void cService::processSubmissions(connState *conn) {
+    eventfd_t cnt;
+    eventfd_read(conn->ring->getSubmitFd(), &cnt);
+
+    shmRingEntry entry;
+    while (conn->ring->popSubmission(entry)) {
+        int32_t fid = entry.code;
+        int32_t client_tid = entry.tid;
+
+        // Unlike on the socket, the arguments are framed, so their size can be checked
+        bFunc *requested_func = getFunction(fid);
+        size_t args_size = 0;
+        if (requested_func != nullptr) {
+            for (size_t &arg_size: requested_func->getArgumentSizes()) {
+                args_size += arg_size;
             }
         }
-        
-        task_locks[connfd]->unlock();
-        
-        // If the connection has been marked for cleaning, stop the thread
-        // A connection can be marked for cleaning has sent a disconnect request (DEF_OP_CLOSE_CONN in processRequests())
-        if (conns_to_clean.find(connfd) != conns_to_clean.end()) {
-            run_response_thread = !conns_to_clean[connfd];
+        if (requested_func == nullptr || args_size != entry.len) {
+            syslog(LOG_WARNING, "Client %d submitted invalid task, fid: %d with client_tid: %d, stopping request...", conn->connfd, fid, client_tid);
+            sendResponse(conn, 1, client_tid, {}, true);
+            continue;
         }
+
+        syslog(LOG_NOTICE, "Client %d requested function fid: %d with client_tid: %d", conn->connfd, fid, client_tid);
+        submitTask(conn, requested_func, client_tid, entry.data, true);
     }
 }
 
-void cService::acceptConnectionLocal() {
-    sockaddr_un client_addr;
-    socklen_t len = sizeof(client_addr); 
-    int connfd;
-
-    // Try to accept an incoming connection
-    if ((connfd = accept(sockfd, (struct sockaddr *) &client_addr, &len)) != -1) {
-    
-        syslog(LOG_NOTICE, "Accepted local connection, connfd: %d", connfd);
-
-        /**
-         * The service often receives data from the clients (e.g., request opcode, function arguments etc.)
-         * There is a clear sequence of steps, as implemented in processRequests() function, that the service
-         * expects to receive from the client. If the client fails to send data or the correct arguments for the 
-         * function, it can leave the server hanging. Therefore, set a timeout for the connection to prevent this.
-         */
-        if (setsockopt(connfd, SOL_SOCKET, SO_RCVTIMEO, &SERVER_RECV_TIMEOUT, sizeof(SERVER_RECV_TIMEOUT)) < 0) {
-            syslog(LOG_WARNING, "Could not set timeout for connfd: %d", connfd);
+void cService::sendResponse(connState *conn, int32_t ret_code, int32_t client_tid, const std::vector<char> &ret_val, bool ring) {
+    if (ring && conn->ring != nullptr) {
+        size_t len = ret_code == 0 ? ret_val.size() : 0;
+        if (conn->ring->complete(ret_code, client_tid, ret_val.data(), len)) {
+            return;
         }
+    }
 
-        // Read "remote" process ID of the client
-        int n;
-        pid_t rpid;
-        char recv_buf[RECV_BUFF_SIZE];
-        if ((n = read(connfd, recv_buf, sizeof(pid_t))) == sizeof(pid_t)) {
-            memcpy(&rpid, recv_buf, sizeof(pid_t));
-            syslog(LOG_NOTICE, "Registered pid: %d", rpid);
-
-            /*
-             * Set-up resources for this client and start the thread to process incodming requests
-             * Each client is uniquely identified by its connection file descriptor (connfd);
-             * At any given time, no two clients will have the same value of connfd
-             * However, it's possible that a connfd with the same value is opened later (the cService has
-             * no control over the connection file descriptors, they are assigned by the OS). Therefore, 
-             * when a client disconnect, it's important to remove their resources. This is done by the
-             * cleanConns() function, which periodically checks the conns_to_clean map and releases the resources.
-             */ 
-            task_locks.insert({connfd, std::make_unique<std::mutex>()});
-            tasks.insert({connfd, std::vector<std::pair<int32_t, int32_t>>()});
-            coyote_threads.insert({connfd, std::make_unique<cThread>(vfid, rpid, device)});
-            connection_threads.insert({
-                connfd, 
-                std::make_pair<std::thread, std::thread>(                        
-                    std::thread(&cService::processRequests, this, connfd),
-                    std::thread(&cService::sendResponses, this, connfd)
-                )
-            });
-            
+    char hdr[2 * sizeof(int32_t)];
+    memcpy(hdr, &ret_code, sizeof(int32_t));
+    memcpy(hdr + sizeof(int32_t), &client_tid, sizeof(int32_t));
+    conn->send_buf.insert(conn->send_buf.end(), hdr, hdr + 2 * sizeof(int32_t));
+    if (ret_code == 0) {
+        conn->send_buf.insert(conn->send_buf.end(), ret_val.begin(), ret_val.end());
+    }
+    flushConnection(conn);
+}
+
+void cService::flushConnection(connState *conn) {
+    size_t sent = 0;
+    while (sent < conn->send_buf.size()) {
+        ssize_t n = ::send(conn->connfd, conn->send_buf.data() + sent, conn->send_buf.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (n == -1 && errno == EINTR) {
+            continue;
         } else {
-            ::close(connfd);
-            syslog(LOG_WARNING, "Failed to register client, connfd: %d, received: %d", connfd, n);
+            if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                // The peer is gone; the connection is closed once epoll reports the hang-up
+                syslog(LOG_ERR, "Responses could not be sent, connfd: %d, errno: %d", conn->connfd, errno);
+                sent = conn->send_buf.size();
+            }
+            break;
         }
+    }
+    conn->send_buf.erase(conn->send_buf.begin(), conn->send_buf.begin() + sent);
 
+    // Only wait for the socket to become writable while there are pending responses
+    struct epoll_event ev;
+    ev.events = conn->send_buf.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT;
+    ev.data.fd = conn->connfd;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, conn->connfd, &ev);
+}
+
+void cService::processCompletions() {
+    // The device scheduler consumes the completion events of its vFPGAs itself
+    std::vector<int32_t> completed;
+    if (dev_scheduler != nullptr) {
+        completed = dev_scheduler->takeCompleted();
+    } else {
+        eventfd_t cnt;
+        eventfd_read(cmpl_fd, &cnt);
+        completed = scheduler->takeCompleted();
     }
 
-    std::this_thread::sleep_for(std::chrono::microseconds(DAEMON_ACCEPT_CONN_SLEEP));
+    for (int32_t server_tid : completed) {
+        auto it = task_conns.find(server_tid);
+        if (it == task_conns.end()) {
+            continue;
+        }
+        connState *conn = it->second;
+        task_conns.erase(it);
+
+        // Running task of a closed connection; its resources are released once none is left
+        if (conn->connfd == -1) {
+            conn->draining.erase(server_tid);
+            if (conn->draining.empty()) {
+                syslog(LOG_NOTICE, "Releasing resources for closed connection of pid %d", conn->rpid);
+                pid_t rpid = conn->rpid;
+                closed_conns.erase(std::remove_if(
+                    closed_conns.begin(), closed_conns.end(), [&](const std::unique_ptr<connState> &c) { return c.get() == conn; }
+                ), closed_conns.end());
+                releaseClient(rpid);
+            }
+            continue;
+        }
+
+        int32_t client_tid = conn->tasks[server_tid].client_tid;
+        bool ring = conn->tasks[server_tid].ring;
+        conn->tasks.erase(server_tid);
+
+        cTask *task = getTask(server_tid);
+        if (task == nullptr) {
+            syslog(LOG_ERR, "UNEXPECTED BUG: Task with server_tid: %d, connfd: %d marked as completed, but scheduler returned nullptr?!", server_tid, conn->connfd);
+            sendResponse(conn, 1, client_tid, {}, ring);
+            continue;
+        }
+
+        // Returned buffers are sent as their location in one of the client's regions
+        int32_t ret_code = task->getRetCode();
+        std::vector<char> ret_val = task->getRetVal();
+        bFunc *fn = getFunction(task->getFid());
+        if (ret_code == 0 && fn != nullptr && fn->returnsBuffer()) {
+            cBuffer buf;
+            memcpy(&buf, ret_val.data(), sizeof(cBuffer));
+            if (exportBuffer(conn, buf)) {
+                memcpy(ret_val.data(), &buf, sizeof(cBuffer));
+            } else {
+                syslog(LOG_WARNING, "Function %d returned a buffer outside the client's regions, client_tid: %d", task->getFid(), client_tid);
+                ret_code = 1;
+            }
+        }
+
+        // Write return code and task ID, followed by the return value if the function completed sucessfully
+        sendResponse(conn, ret_code, client_tid, ret_val, ring);
+
+        // Let the scheduler reclaim the task
+        releaseTask(server_tid);
+        syslog(LOG_NOTICE, "Sent response for task with server_tid: %d, client_tid: %d, connfd: %d", server_tid, client_tid, conn->connfd);
+    }
 }
 
-void cService::acceptConnectionRemote() {
-    std::this_thread::sleep_for(std::chrono::microseconds(DAEMON_ACCEPT_CONN_SLEEP));
+void cService::closeConnection(connState *conn) {
+    int connfd = conn->connfd;
+    syslog(LOG_NOTICE, "Releasing resources for connection %d", connfd);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, connfd, nullptr);
+    ::close(connfd);
+    if (conn->ring != nullptr) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, conn->ring->getSubmitFd(), nullptr);
+        ring_conns.erase(conn->ring->getSubmitFd());
+        conn->ring.reset();
+    }
+
+    // Tasks without a response sent are released from the scheduler: queued ones are cancelled and completed ones freed,
+    // while the running ones are still using the Coyote thread, so the connection state is kept until they complete
+    for (auto &[server_tid, task] : conn->tasks) {
+        if (releaseTask(server_tid)) {
+            conn->draining.insert(server_tid);
+        } else {
+            task_conns.erase(server_tid);
+        }
+    }
+    conn->tasks.clear();
+
+    std::unique_ptr<connState> state = std::move(conns[connfd]);
+    conns.erase(connfd);
+    state->connfd = -1;
+    if (!state->draining.empty()) {
+        closed_conns.push_back(std::move(state));
+    } else {
+        pid_t rpid = state->rpid;
+        state.reset();
+        releaseClient(rpid);
+    }
+    syslog(LOG_NOTICE, "Connection %d closed", connfd);
 }
 
+void cService::eventLoop() {
+    struct epoll_event ev;
+    if (!remote) {
+        ev.events = EPOLLIN;
+        ev.data.fd = sockfd;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, sockfd, &ev) == -1) {
+            throw std::runtime_error("ERROR: Could not register server socket with epoll");
+        }
+    } else {
+        syslog(LOG_WARNING, "Remote connections are not supported yet; no connections will be accepted");
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.fd = cmpl_fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, cmpl_fd, &ev) == -1) {
+        throw std::runtime_error("ERROR: Could not register completion event with epoll");
+    }
+
+    struct epoll_event events[MAX_NUM_CLIENTS];
+    while (true) {
+        int n = epoll_wait(epfd, events, MAX_NUM_CLIENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR) { continue; }
+            throw std::runtime_error("ERROR: epoll_wait failed, errno: " + std::to_string(errno));
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == sockfd) {
+                acceptConnectionsLocal();
+            } else if (fd == cmpl_fd) {
+                processCompletions();
+            } else {
+                // The connection may have been closed while handling an earlier event of this batch
+                auto rit = ring_conns.find(fd);
+                if (rit != ring_conns.end()) {
+                    processSubmissions(rit->second);
+                    continue;
+                }
+                auto it = conns.find(fd);
+                if (it == conns.end()) {
+                    continue;
+                }
+
+                connState *conn = it->second.get();
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    if (!readConnection(conn)) {
+                        continue;
+                    }
+                }
+                if (events[i].events & EPOLLOUT) {
+                    flushConnection(conn);
+                }
+            }
+        }
+    }
+}
 
 void cService::start() {
     if (is_running) {
@@ -491,23 +831,27 @@ void cService::start() {
         return;
     }
 
-    // Set-up daemon and communication socket; start a thread that periodically release stale connection threads and resources
+    // Set-up daemon, communication socket and the event loop
     is_running = true;
     initDaemon();
     initSocket();
-    run_cleanup_thread = true;
-    std::thread cleanup_thread = std::thread(&cService::cleanConns, this);
-    scheduler->start();
 
-    // Keep accepting connections
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1) {
+        syslog(LOG_ERR, "Error creating epoll instance");
+        exit(EXIT_FAILURE);
+    }
+    if (dev_scheduler != nullptr) {
+        cmpl_fd = dev_scheduler->getCompletionFd();
+        dev_scheduler->start();
+    } else {
+        cmpl_fd = scheduler->getCompletionFd();
+        scheduler->start();
+    }
+
+    // Keep accepting connections and serving requests
     try {
-        while (true) {
-            if (!remote) {
-                acceptConnectionLocal();
-            } else {
-                acceptConnectionRemote();
-            }
-        }
+        eventLoop();
     } catch (const std::exception &e) {
         syslog(LOG_ERR, "Exception in main loop: %s", e.what());
     } catch (...) {
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Coyote <https://github.com/fpgasystems/Coyote>
+ *
+ * MIT Licence
+ * Copyright (c) 2025, Systems Group, ETH Zurich
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <coyote/cShmRing.hpp>
+
+namespace coyote {
+
+cShmRing::cShmRing() : layout(nullptr) {
+    mem_fd = memfd_create("coyote-shm-ring", MFD_CLOEXEC);
+    sq_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    cq_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mem_fd == -1 || sq_fd == -1 || cq_fd == -1 || ftruncate(mem_fd, sizeof(shmRingLayout))) {
+        if (mem_fd != -1) { close(mem_fd); }
+        if (sq_fd != -1) { close(sq_fd); }
+        if (cq_fd != -1) { close(cq_fd); }
+        throw std::runtime_error("ERROR: Failed to allocate shared memory ring");
+    }
+    map(true);
+}
+
+cShmRing::cShmRing(int mem_fd, int sq_fd, int cq_fd) : mem_fd(mem_fd), sq_fd(sq_fd), cq_fd(cq_fd), layout(nullptr) {
+    map(false);
+}
+
+cShmRing::~cShmRing() {
+    if (layout != nullptr) {
+        munmap(layout, sizeof(shmRingLayout));
+    }
+    close(mem_fd);
+    close(sq_fd);
+    close(cq_fd);
+}
+
+void cShmRing::map(bool init) {
+    void *mem = mmap(nullptr, sizeof(shmRingLayout), PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+    if (mem == MAP_FAILED) {
+        close(mem_fd);
+        close(sq_fd);
+        close(cq_fd);
+        throw std::runtime_error("ERROR: Failed to map shared memory ring");
+    }
+    layout = static_cast<shmRingLayout*>(mem);
+
+    // A fresh memfd is zero-filled, so the indices start at 0; the magic is only checked by the client
+    if (init) {
+        layout->depth = SHM_RING_DEPTH;
+        layout->magic = SHM_RING_MAGIC;
+    } else if (layout->magic != SHM_RING_MAGIC || layout->depth != SHM_RING_DEPTH) {
+        munmap(layout, sizeof(shmRingLayout));
+        close(mem_fd);
+        close(sq_fd);
+        close(cq_fd);
+        throw std::runtime_error("ERROR: Shared memory ring was not initialized or has a different depth");
+    }
+}
+
+bool cShmRing::push(shmRingIdx &idx, shmRingEntry *entries, int32_t code, int32_t tid, const void *data, size_t len) {
+    if (len > MAX_DATA_SIZE) {
+        return false;
+    }
+
+    uint32_t tail = idx.tail.load(std::memory_order_relaxed);
+    if (tail - idx.head.load(std::memory_order_acquire) == SHM_RING_DEPTH) {
+        return false;
+    }
+
+    shmRingEntry &entry = entries[tail % SHM_RING_DEPTH];
+    entry.code = code;
+    entry.tid = tid;
+    entry.len = len;
+    memcpy(entry.data, data, len);
+    idx.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool cShmRing::pop(shmRingIdx &idx, shmRingEntry *entries, shmRingEntry &entry) {
+    uint32_t head = idx.head.load(std::memory_order_relaxed);
+    if (head == idx.tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // The length is not trusted, since it was written by the other process
+    const shmRingEntry &src = entries[head % SHM_RING_DEPTH];
+    entry.code = src.code;
+    entry.tid = src.tid;
+    entry.len = std::min<uint32_t>(src.len, MAX_DATA_SIZE);
+    memcpy(entry.data, src.data, entry.len);
+    idx.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool cShmRing::submit(int32_t fid, int32_t tid, const void *args, size_t len, bool kick) {
+    if (!push(layout->sq, layout->sq_entries, fid, tid, args, len)) {
+        return false;
+    }
+    if (kick) {
+        this->kick();
+    }
+    return true;
+}
+
+void cShmRing::kick() {
+    eventfd_write(sq_fd, 1);
+}
+
+bool cShmRing::popSubmission(shmRingEntry &entry) {
+    return pop(layout->sq, layout->sq_entries, entry);
+}
+
+bool cShmRing::complete(int32_t ret_code, int32_t tid, const void *ret_val, size_t len) {
+    if (!push(layout->cq, layout->cq_entries, ret_code, tid, ret_val, len)) {
+        return false;
+    }
+    eventfd_write(cq_fd, 1);
+    return true;
+}
+
+bool cShmRing::popCompletion(shmRingEntry &entry) {
+    return pop(layout->cq, layout->cq_entries, entry);
+}
+
+}
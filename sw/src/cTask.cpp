@@ -51,6 +51,10 @@ cThread* cTask::getCThread() const {
     return cthread;
 }
 
+void cTask::setCThread(cThread* cthread) {
+    this->cthread = cthread;
+}
+
 std::vector<std::vector<char>> cTask::getArgs() const {
     return fn_args;
 }
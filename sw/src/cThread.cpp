@@ -103,6 +103,37 @@ int eventHandler(int fd, int efd, int terminate_efd, std::function<void(int)> ui
 
 static unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
 
+/// Control word of a local (host/card stream) command, as parsed by the vFPGA command FIFO
+static inline uint64_t localCtrlCmd(int32_t ctid, const localSg &sg, bool last) {
+    return
+        ((ctid & CTRL_PID_MASK) << CTRL_PID_OFFS) |
+        ((sg.dest & CTRL_DEST_MASK) << CTRL_DEST_OFFS) |
+        (last ? CTRL_LAST : 0x0) |
+        ((sg.stream & CTRL_STRM_MASK) << CTRL_STRM_OFFS) | 
+        (CTRL_START) | 
+        (static_cast<uint64_t>(sg.len) << CTRL_LEN_OFFS);
+}
+
+/// Faults in all the pages of a newly allocated buffer (see CoyoteAlloc::populate); for THP buffers, huge pages are requested first
+static void populateMem(void *mem, uint64_t size, bool thp) {
+    if (thp) {
+        madvise(mem, size, MADV_HUGEPAGE);
+    }
+
+    #ifdef MADV_POPULATE_WRITE
+    if (madvise(mem, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+    #endif
+
+    // Kernels before 5.14: touch every page, writing back its own value since THP memory from posix_memalign may already be in use
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    volatile char *bytes = static_cast<volatile char*>(mem);
+    for (uint64_t offs = 0; offs < size; offs += page_size) {
+        bytes[offs] = bytes[offs];
+    }
+}
+
 cThread::cThread(int32_t vfid, pid_t hpid, uint32_t device, std::function<void(int)> uisr):
   hpid(hpid), vfid(vfid),
   vlock(boost::interprocess::open_or_create, ("mutex_dev_" + std::to_string(device) + "_vfpa_" + std::to_string(vfid)).c_str()),
@@ -132,29 +163,13 @@ cThread::cThread(int32_t vfid, pid_t hpid, uint32_t device, std::function<void(i
     fcnfg.parseCnfg(tmp[0]);
     fcnfg.parseCtrlReg(tmp[1]);
 
+    // NUMA node of the FPGA, for the placement of host buffers and helper threads
+    numa_node = getDeviceNumaNode(device);
+    DBG1("cThread: FPGA is on NUMA node " << numa_node);
+
     // Register user interrupt service routine (uisr) and start the interrupt processing thread
     if (uisr) {
-        DBG1("cThread: user interrupt service routine provided, trying to create efd and terminate_efd"); 
-        
-		efd = eventfd(0, 0);
-		if (efd == -1) { 
-            throw std::runtime_error("ERROR: cThread could not create eventfd"); 
-        }
-
-		terminate_efd = eventfd(0, 0);
-		if (terminate_efd == -1) { 
-            throw std::runtime_error("ERROR: cThread could not create eventfd"); 
-        }
-
-        event_thread = std::thread(eventHandler, fd, efd, terminate_efd, uisr, ctid);
-
-        tmp[0] = ctid; 
-		tmp[1] = efd;
-		if (ioctl(fd, IOCTL_REGISTER_EVENTFD, &tmp)) {
-			throw std::runtime_error("ERROR: IOCTL_REGISTER_EVENTFD failed");
-        }
-
-        DBG1("cThread: user interrupt service routine registered, thread running..."); 
+        startEventThread(uisr);
     }
 
     // Set the local QP, if RDMA is enabled
@@ -205,10 +220,14 @@ cThread::~cThread() {
 	uint64_t tmp[MAX_USER_ARGS];
     tmp[0] = ctid;
 
-	for(auto& it: mapped_pages) {
-		freeMem(it.first);
+	while (!mapped_pages.empty()) {
+		freeMem(mapped_pages.begin()->start);
 	}
-	mapped_pages.clear();
+
+    // Release the registrations still held by the cache
+    for (uint64_t removed : reg_cache.clear()) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
 	munmapFpga();
 
     // Unregister Coyote thread ID
@@ -229,6 +248,10 @@ cThread::~cThread() {
         ioctl(fd, IOCTL_SET_NOTIFICATION_PROCESSED, &tmp);
 	}
 
+    if (wait_efd != -1) {
+        close(wait_efd);
+    }
+
     // Disable RDMA, if enabled and set-up
     if (fcnfg.en_rdma && is_connected) {
         closeConn();
@@ -237,27 +260,25 @@ cThread::~cThread() {
 	close(fd);
 }
 
-void cThread::postCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
-    DBG1(
-        "cThread: Called postCmd with offsets: " << 
-        std::hex << offs_3 << ", " << offs_2 << ", " << offs_1 << ", " << offs_0 << std::dec
-    );
-
+uint32_t cThread::getCmdCredits() {
     // Check outstanding commands; to avoid oversaturating the command FIFO
-    while (cmd_cnt > (CMD_FIFO_DEPTH - CMD_FIFO_THR)) {
-        #ifdef EN_AVX
-        cmd_cnt = fcnfg.en_avx ? LOW_32(_mm256_extract_epi32(cnfg_reg_avx[static_cast<uint32_t>(CnfgAvxRegs::CTRL_REG)], 0x0)) :
-                                cnfg_reg[static_cast<uint32_t>(CnfgLegRegs::CTRL_REG)];
-        #else
-        cmd_cnt = cnfg_reg[static_cast<uint32_t>(CnfgLegRegs::CTRL_REG)];
-        #endif
-
+    // CTRL_REG is only read back once the software count reaches the threshold
+    waitFor([this]() {
         if (cmd_cnt > (CMD_FIFO_DEPTH - CMD_FIFO_THR)) {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(SLEEP_TIME));
+            #ifdef EN_AVX
+            cmd_cnt = fcnfg.en_avx ? LOW_32(_mm256_extract_epi32(cnfg_reg_avx[static_cast<uint32_t>(CnfgAvxRegs::CTRL_REG)], 0x0)) :
+                                    cnfg_reg[static_cast<uint32_t>(CnfgLegRegs::CTRL_REG)];
+            #else
+            cmd_cnt = cnfg_reg[static_cast<uint32_t>(CnfgLegRegs::CTRL_REG)];
+            #endif
         }
-    }
+        return cmd_cnt <= (CMD_FIFO_DEPTH - CMD_FIFO_THR);
+    }, wait_policy, wait_stats, wait_efd);
 
-    // Send the commands
+    return (CMD_FIFO_DEPTH - CMD_FIFO_THR) - cmd_cnt + 1;
+}
+
+void cThread::writeCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
     #ifdef EN_AVX
     if (fcnfg.en_avx) {
         cnfg_reg_avx[static_cast<uint32_t>(CnfgAvxRegs::CTRL_REG)] = _mm256_set_epi64x(offs_3, offs_2, offs_1, offs_0);
@@ -270,11 +291,60 @@ void cThread::postCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_
     #ifdef EN_AVX
     }
     #endif
+}
+
+void cThread::postCmd(uint64_t offs_3, uint64_t offs_2, uint64_t offs_1, uint64_t offs_0) {
+    DBG1(
+        "cThread: Called postCmd with offsets: " << 
+        std::hex << offs_3 << ", " << offs_2 << ", " << offs_1 << ", " << offs_0 << std::dec
+    );
+
+    getCmdCredits();
+
+    // Send the commands
+    writeCmd(offs_3, offs_2, offs_1, offs_0);
 
     // Increment
     cmd_cnt++;
 }
 
+void cThread::startEventThread(std::function<void(int)> uisr) {
+    DBG1("cThread: creating efd and terminate_efd for the user interrupt thread"); 
+    uint64_t tmp[MAX_USER_ARGS];
+
+    efd = eventfd(0, 0);
+    if (efd == -1) { 
+        throw std::runtime_error("ERROR: cThread could not create eventfd"); 
+    }
+
+    terminate_efd = eventfd(0, 0);
+    if (terminate_efd == -1) { 
+        throw std::runtime_error("ERROR: cThread could not create eventfd"); 
+    }
+
+    // Besides calling the uisr, interrupts wake up blocked waiters, if enabled; wait_efd is set before irq_wakeup
+    auto handler = [this, uisr](int isr_val) {
+        if (uisr) {
+            uisr(isr_val);
+        }
+        if (irq_wakeup.load(std::memory_order_acquire)) {
+            eventfd_write(wait_efd, 1);
+        }
+    };
+    event_thread = std::thread(eventHandler, fd, efd, terminate_efd, handler, ctid);
+    if (numa_affinity && numa_node != -1) {
+        setThreadAffinity(event_thread.native_handle(), getNodeCpus(numa_node));
+    }
+
+    tmp[0] = ctid; 
+    tmp[1] = efd;
+    if (ioctl(fd, IOCTL_REGISTER_EVENTFD, &tmp)) {
+        throw std::runtime_error("ERROR: IOCTL_REGISTER_EVENTFD failed");
+    }
+
+    DBG1("cThread: user interrupt thread running..."); 
+}
+
 void cThread::mmapFpga() {
     DBG1("cThread: Called mmapFpga");
 
@@ -356,8 +426,8 @@ void cThread::munmapFpga() {
 	wback = 0;
 }
 
-void cThread::userMap(void *vaddr, uint32_t len) {
-    DBG1("cThread: Called userMap to map user buffer, vaddr " << vaddr << ", length " << len << " and ctid " << ctid);
+void cThread::mapBuffer(void *vaddr, uint32_t len) {
+    DBG1("cThread: Mapping user buffer in the driver, vaddr " << vaddr << ", length " << len << " and ctid " << ctid);
 
     uint64_t tmp[MAX_USER_ARGS];
 	tmp[0] = reinterpret_cast<uint64_t>(vaddr);
@@ -374,8 +444,8 @@ void cThread::userMap(void *vaddr, uint32_t len) {
     }
 }
 
-void cThread::userUnmap(void *vaddr) {
-    DBG1("cThread: Called userUnmap to unmap user buffers");
+void cThread::unmapBuffer(void *vaddr) {
+    DBG1("cThread: Unmapping user buffer in the driver, vaddr " << vaddr);
 
 	uint64_t tmp[MAX_USER_ARGS];
 	tmp[0] = reinterpret_cast<uint64_t>(vaddr);
@@ -386,6 +456,98 @@ void cThread::userUnmap(void *vaddr) {
     }
 }
 
+void cThread::userMap(void *vaddr, uint32_t len) {
+    DBG1("cThread: Called userMap to map user buffer, vaddr " << vaddr << ", length " << len << " and ctid " << ctid);
+
+    if (!reg_cache.isEnabled()) {
+        mapBuffer(vaddr, len);
+        return;
+    }
+
+    // Registered ranges become a lookup; otherwise, map and cache the new registration, replacing 
+    // an unused shorter one at the same address, since the driver would not extend it
+    if (!reg_cache.acquire(reinterpret_cast<uint64_t>(vaddr), len)) {
+        if (reg_cache.remove(reinterpret_cast<uint64_t>(vaddr))) {
+            unmapBuffer(vaddr);
+        }
+        mapBuffer(vaddr, len);
+        reg_cache.insert(reinterpret_cast<uint64_t>(vaddr), len);
+        for (uint64_t evicted : reg_cache.evict()) {
+            unmapBuffer(reinterpret_cast<void*>(evicted));
+        }
+    }
+}
+
+void cThread::userUnmap(void *vaddr) {
+    DBG1("cThread: Called userUnmap to unmap user buffers");
+
+    // Cached registrations are only released, and unmapped lazily; a disabled cache may still hold registrations in use
+    if (reg_cache.release(reinterpret_cast<uint64_t>(vaddr))) {
+        for (uint64_t evicted : reg_cache.evict()) {
+            unmapBuffer(reinterpret_cast<void*>(evicted));
+        }
+    } else {
+        unmapBuffer(vaddr);
+    }
+}
+
+void cThread::setRegCacheBudget(uint64_t bytes) {
+    reg_cache.setBudget(bytes);
+    for (uint64_t evicted : reg_cache.evict()) {
+        unmapBuffer(reinterpret_cast<void*>(evicted));
+    }
+}
+
+void cThread::invalidateRegCache(void *vaddr, uint64_t len) {
+    for (uint64_t removed : reg_cache.invalidate(reinterpret_cast<uint64_t>(vaddr), len)) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+}
+
+void cThread::flushRegCache() {
+    for (uint64_t removed : reg_cache.flush()) {
+        unmapBuffer(reinterpret_cast<void*>(removed));
+    }
+}
+
+regCacheStats cThread::getRegCacheStats() const { return reg_cache.getStats(); }
+
+void cThread::setNumaPlacement(bool mem_bind, bool thread_affinity) {
+    DBG1("cThread: Called setNumaPlacement with mem_bind " << mem_bind << ", thread_affinity " << thread_affinity);
+    numa_mem = mem_bind;
+    numa_affinity = thread_affinity;
+
+    if (numa_node == -1 || !event_thread.joinable()) {
+        return;
+    }
+
+    if (numa_affinity) {
+        setThreadAffinity(event_thread.native_handle(), getNodeCpus(numa_node));
+    } else {
+        std::vector<int> all_cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            all_cpus.push_back(cpu);
+        }
+        setThreadAffinity(event_thread.native_handle(), all_cpus);
+    }
+}
+
+int32_t cThread::getNumaNode() const { return numa_node; }
+
+std::vector<operStats> cThread::getOperStats() const {
+    #ifdef EN_OPER_STATS
+    return oper_stats.snapshot();
+    #else
+    return {};
+    #endif
+}
+
+void cThread::resetOperStats() {
+    #ifdef EN_OPER_STATS
+    oper_stats.reset();
+    #endif
+}
+
 void* cThread::getMem(CoyoteAlloc&& alloc) {
     DBG1("cThread: Called getMem to obtain memory with size " << alloc.size); 
 
@@ -397,6 +559,12 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
 			case CoyoteAllocType::REG : {
                 DBG1("cThread: Obtain regular memory"); 
                 mem = mmap(NULL, alloc.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (numa_mem && numa_node != -1) {
+                    bindMemToNode(mem, alloc.size, numa_node);
+                }
+                if (alloc.populate) {
+                    populateMem(mem, alloc.size, false);
+                }
 				userMap(mem, alloc.size);
 				break;
             }
@@ -409,6 +577,13 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
                     std::cerr << "ERROR: cThread::getMem() - Failed to allocate transparent hugepages!" << std::endl;;
                     return nullptr;
                 }
+                // posix_memalign may return pages that were already touched, which are moved to the node
+                if (numa_mem && numa_node != -1) {
+                    bindMemToNode(mem, alloc.size, numa_node);
+                }
+                if (alloc.populate) {
+                    populateMem(mem, alloc.size, true);
+                }
                 userMap(mem, alloc.size);
                 break;
             }
@@ -447,6 +622,14 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
 
 
 
+                // Huge pages are only allocated on first touch, i.e., when they are populated or pinned by userMap()
+                if (numa_mem && numa_node != -1) {
+                    bindMemToNode(mem, sz, numa_node);
+                }
+                if (alloc.populate) {
+                    populateMem(mem, sz, false);
+                }
+
                 userMap(mem, sz);
                 break;
             }
@@ -529,7 +712,15 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
 				break;
 		}
         
-        mapped_pages.emplace(mem, alloc);
+        // Interior pointers are resolved to the allocation through mem
+        if (!alloc.mem) {
+            alloc.mem = mem;
+        }
+        // An allocation that cannot be recorded (e.g., overlapping a stale entry) could never be freed, so it's released right away
+        if (!mapped_pages.insert(mem, alloc.size, alloc)) {
+            releaseMem(mem, alloc);
+            throw std::runtime_error("ERROR: cThread::getMem() - allocation overlaps an existing one, at vaddr " + std::to_string(reinterpret_cast<uint64_t>(mem)));
+        }
 		DBG1("Mapped mem at: " << std::hex << reinterpret_cast<uint64_t>(mem) << std::dec);
 
         if (alloc.remote) {
@@ -543,65 +734,83 @@ void* cThread::getMem(CoyoteAlloc&& alloc) {
 	return mem;
 }
 
-void cThread::freeMem(void* vaddr) {
-    DBG1("cThread: Releasing memory at vaddr " << vaddr);
-
-	if (mapped_pages.find(vaddr) != mapped_pages.end()) {
-		auto mapped = mapped_pages[vaddr];
-		
-		switch (mapped.alloc) {
-            case CoyoteAllocType::REG : {
-                userUnmap(vaddr);
-                munmap(vaddr, mapped.size);
-                break;
+void cThread::releaseMem(void *vaddr, const CoyoteAlloc &alloc) {
+	switch (alloc.alloc) {
+        case CoyoteAllocType::REG : {
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            munmap(vaddr, alloc.size);
+            break;
+        }
+        case CoyoteAllocType::THP : { 
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            free(vaddr);
+            break;
+        }
+        case CoyoteAllocType::HPF : {
+            userUnmap(vaddr);
+            invalidateRegCache(vaddr, alloc.size);
+            munmap(vaddr, alloc.size);
+            break;
+        }
+        case CoyoteAllocType::GPU : {
+        #ifdef EN_GPU   
+            // Detach and close the DMABuff
+            uint64_t tmp[MAX_USER_ARGS];
+            tmp[0] = reinterpret_cast<uint64_t>(alloc.mem);
+            tmp[1] = static_cast<uint64_t>(ctid);
+            if (ioctl(fd, IOCTL_UNMAP_DMABUF, &tmp)) {
+                throw std::runtime_error("ERROR: ioctl_unmap_dmabuf() failed");
             }
-            case CoyoteAllocType::THP : { 
-                userUnmap(vaddr);
-                free(vaddr);
-                break;
+
+            hsa_status_t err = hsa_amd_portable_close_dmabuf(alloc.gpu_dmabuf_fd);
+            if (err != HSA_STATUS_SUCCESS) {
+                std::cerr << "ERROR: cThread::getMem() - Exported dmabuf could not be closed!" << std::endl;
             }
-            case CoyoteAllocType::HPF : {
-                userUnmap(vaddr);
-                munmap(vaddr, mapped.size);
-                break;
+            
+            // Release the memory
+            err = hsa_memory_free(alloc.mem);
+            if (err != HSA_STATUS_SUCCESS) {
+                std::cerr << "GPU buffers not freed properly!" << std::endl;
             }
-            case CoyoteAllocType::GPU : {
-            #ifdef EN_GPU   
-                // Detach and close the DMABuff
-                uint64_t tmp[MAX_USER_ARGS];
-                tmp[0] = reinterpret_cast<uint64_t>(mapped.mem);
-                tmp[1] = static_cast<uint64_t>(ctid);
-                if (ioctl(fd, IOCTL_UNMAP_DMABUF, &tmp)) {
-                    throw std::runtime_error("ERROR: ioctl_unmap_dmabuf() failed");
-                }
+        #else
+            throw std::runtime_error("ERROR: GPU support not enabled; please compile the software with DEN_GPU=1");
+        #endif
+            break;
+        }
+        default:
+            break;
+	}
+}
 
-                hsa_status_t err = hsa_amd_portable_close_dmabuf(mapped.gpu_dmabuf_fd);
-                if (err != HSA_STATUS_SUCCESS) {
-                    std::cerr << "ERROR: cThread::getMem() - Exported dmabuf could not be closed!" << std::endl;
-                }
-                
-                // Release the memory
-                err = hsa_memory_free(mapped.mem);
-                if (err != HSA_STATUS_SUCCESS) {
-                    std::cerr << "GPU buffers not freed properly!" << std::endl;
-                }
-            #else
-                throw std::runtime_error("ERROR: GPU support not enabled; please compile the software with DEN_GPU=1");
-            #endif
-                break;
-            }
-            default:
-                break;
-		}
+void cThread::freeMem(void* vaddr) {
+    DBG1("cThread: Releasing memory at vaddr " << vaddr);
+
+	if (mapped_pages.find(vaddr)) {
+		auto mapped = *mapped_pages.find(vaddr);
+		
+		releaseMem(vaddr, mapped);
 
         // Reset QP, if the allocation was remote
         if (mapped.remote) {
             qpair->local.vaddr = 0;
             qpair->local.size =  0;  
         }
+
+        mapped_pages.erase(vaddr);
 	}
 }
 
+const CoyoteAlloc* cThread::findAlloc(const void *addr, uint64_t len) const {
+    auto entry = mapped_pages.findContaining(addr, len);
+    return entry ? &entry->value : nullptr;
+}
+
+bool cThread::isMapped(const void *addr, uint64_t len) const {
+    return mapped_pages.findContaining(addr, len) != nullptr;
+}
+
 void cThread::setCSR(uint64_t val, uint32_t offs) {
     ctrl_reg[offs] = val; 
 }
@@ -649,7 +858,7 @@ void cThread::invoke(CoyoteOper oper, syncSg sg) {
     }
 }
 
-void cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
     // Argument checks
     DBG1("cThread: Call invoke for a one-side local operation with address " << sg.addr << ", length " << sg.len);
 
@@ -696,11 +905,13 @@ void cThread::invoke(CoyoteOper oper, localSg sg, bool last) {
 
     } else {
         std::cerr << "ERROR: cThread::invoke() called with an unsupported operation type; returning..." << std::endl;
-        return;
+        return 0;
     }
+
+    return nextCmplSeq(oper, last, sg.len);
 }
 
-void cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last) {
     // Argument checks
     DBG1(
         "cThread: Call invoke for a two-sided local operation with source address " 
@@ -747,11 +958,95 @@ void cThread::invoke(CoyoteOper oper, localSg src_sg, localSg dst_sg, bool last)
 
     } else {
         std::cerr << "ERROR: cThread::invoke() called with an unsupported operation type; returning..." << std::endl;
-        return;
+        return 0;
+    }
+
+    return nextCmplSeq(oper, last, src_sg.len);
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, const localSgList &sgl) {
+    // Argument checks
+    DBG1("cThread: Call invoke for a one-sided local operation on a list of " << sgl.segs.size() << " segments, total length " << sgl.totalLen());
+
+    if (oper != CoyoteOper::LOCAL_READ && oper != CoyoteOper::LOCAL_WRITE) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with a localSgList, but the operation is not a LOCAL_READ or LOCAL_WRITE; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invoke() called for a local operation, but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    std::vector<localSg> chunks = sgl.chunks();
+    if (chunks.empty()) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with an empty localSgList, exiting...");
+    }
+
+    // Trigger the operation; descriptors are written as long as there are FIFO credits, only the final one is marked last
+    size_t i = 0;
+    while (i < chunks.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < chunks.size(); credits--, i++) {
+            uint64_t ctrl_cmd = localCtrlCmd(ctid, chunks[i], i == chunks.size() - 1);
+            uint64_t addr_cmd = reinterpret_cast<uint64_t>(chunks[i].addr);
+
+            if (oper == CoyoteOper::LOCAL_READ) {
+                writeCmd(0, 0, addr_cmd, ctrl_cmd);
+            } else {
+                writeCmd(addr_cmd, ctrl_cmd, 0, 0);
+            }
+            cmd_cnt++;
+        }
     }
+
+    return nextCmplSeq(oper, true, sgl.totalLen());
 }
 
-void cThread::invoke(CoyoteOper oper, rdmaSg sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, const localSgList &src_sgl, const localSgList &dst_sgl) {
+    // Argument checks
+    DBG1(
+        "cThread: Call invoke for a two-sided local operation on lists with source length " 
+        << src_sgl.totalLen() << " and destination length " << dst_sgl.totalLen()
+    );
+
+    if (oper != CoyoteOper::LOCAL_TRANSFER) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with two localSgLists, but the operation is not a LOCAL_TRANSFER; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invoke() called for a local operation but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    std::vector<localSg> src_chunks = src_sgl.chunks();
+    std::vector<localSg> dst_chunks = dst_sgl.chunks();
+    if (src_chunks.empty() || dst_chunks.empty()) {
+        throw std::runtime_error("ERROR: cThread::invoke() called with an empty localSgList, exiting...");
+    }
+
+    // Trigger the operation; the read and write halves of a command are independent, so a half is left empty once its list is exhausted
+    size_t n = std::max(src_chunks.size(), dst_chunks.size());
+    size_t i = 0;
+    while (i < n) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < n; credits--, i++) {
+            uint64_t addr_cmd_src = 0, ctrl_cmd_src = 0, addr_cmd_dst = 0, ctrl_cmd_dst = 0;
+            if (i < src_chunks.size()) {
+                addr_cmd_src = reinterpret_cast<uint64_t>(src_chunks[i].addr);
+                ctrl_cmd_src = localCtrlCmd(ctid, src_chunks[i], i == src_chunks.size() - 1);
+            }
+            if (i < dst_chunks.size()) {
+                addr_cmd_dst = reinterpret_cast<uint64_t>(dst_chunks[i].addr);
+                ctrl_cmd_dst = localCtrlCmd(ctid, dst_chunks[i], i == dst_chunks.size() - 1);
+            }
+
+            writeCmd(addr_cmd_dst, ctrl_cmd_dst, addr_cmd_src, ctrl_cmd_src);
+            cmd_cnt++;
+        }
+    }
+
+    return nextCmplSeq(oper, true, src_sgl.totalLen());
+}
+
+uint32_t cThread::invoke(CoyoteOper oper, rdmaSg sg, bool last) {
     // Argument checks
     DBG1("cThread: Call invoke for a RDMA operation with length " << sg.len);
 
@@ -775,6 +1070,9 @@ void cThread::invoke(CoyoteOper oper, rdmaSg sg, bool last) {
         void *remote_addr = (void*) ((uint64_t) qpair->remote.vaddr + sg.remote_offs);
         memcpy(remote_addr, local_addr, sg.len);
 
+        // Completed synchronously; the vFPGA never sees the command and doesn't increment the counter
+        return cmpl_seq[getWbackIndex(oper)];
+
     } else {
         // Local command and address
         uint64_t ctrl_cmd_l =
@@ -809,9 +1107,11 @@ void cThread::invoke(CoyoteOper oper, rdmaSg sg, bool last) {
 
         postCmd(addr_cmd_dst, ctrl_cmd_dst, addr_cmd_src, ctrl_cmd_src);
     }
+
+    return nextCmplSeq(oper, last, sg.len);
 }
 
-void cThread::invoke(CoyoteOper oper, tcpSg sg, bool last) {
+uint32_t cThread::invoke(CoyoteOper oper, tcpSg sg, bool last) {
     // Argument checks
     DBG1("cThread: Call invoke for a TCP operation with length " << sg.len);
 
@@ -841,9 +1141,189 @@ void cThread::invoke(CoyoteOper oper, tcpSg sg, bool last) {
     uint64_t addr_cmd_dst = 0;
 
     postCmd(addr_cmd_dst, ctrl_cmd_dst, addr_cmd_src, ctrl_cmd_src);
+
+    return nextCmplSeq(oper, last, sg.len);
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<localSg> &sgs, bool last) {
+    // Argument checks; done for the whole batch upfront, so that an invalid entry doesn't leave a partially issued batch
+    DBG1("cThread: Call invokeBatch for " << sgs.size() << " one-sided local operations");
+
+    if (oper != CoyoteOper::LOCAL_READ && oper != CoyoteOper::LOCAL_WRITE) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called with localSg flags, but the operation is not a LOCAL_READ or LOCAL_WRITE; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called for a local operation, but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    for (const localSg &sg : sgs) {
+        if (sg.len > MAX_TRANSFER_SIZE) {
+            throw std::runtime_error("ERROR: cThread::invokeBatch() - transfers over 128MB are currently not supported in Coyote, exiting...");
+        }
+    }
+
+    // Trigger the operations; credits are only refreshed from CTRL_REG once the current ones are used up
+    size_t i = 0;
+    while (i < sgs.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < sgs.size(); credits--, i++) {
+            uint64_t ctrl_cmd = localCtrlCmd(ctid, sgs[i], last);
+            uint64_t addr_cmd = reinterpret_cast<uint64_t>(sgs[i].addr);
+
+            if (oper == CoyoteOper::LOCAL_READ) {
+                writeCmd(0, 0, addr_cmd, ctrl_cmd);
+            } else {
+                writeCmd(addr_cmd, ctrl_cmd, 0, 0);
+            }
+            cmd_cnt++;
+            nextCmplSeq(oper, last, sgs[i].len);
+        }
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<localSg> &src_sgs, const std::vector<localSg> &dst_sgs, bool last) {
+    // Argument checks
+    DBG1("cThread: Call invokeBatch for " << src_sgs.size() << " two-sided local operations");
+
+    if (oper != CoyoteOper::LOCAL_TRANSFER) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called with two localSg lists, but the operation is not a LOCAL_TRANSFER; exiting...");
+    }
+
+    if (!fcnfg.en_strm && !fcnfg.en_mem) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called for a local operation but the shell was not synthesized with streams from host memory, exiting...");
+    }
+
+    if (src_sgs.size() != dst_sgs.size()) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() - source and destination lists must have the same number of entries, exiting...");
+    }
+
+    for (size_t i = 0; i < src_sgs.size(); i++) {
+        if (src_sgs[i].len > MAX_TRANSFER_SIZE || dst_sgs[i].len > MAX_TRANSFER_SIZE) {
+            throw std::runtime_error("ERROR: cThread::invokeBatch() - transfers over 128MB are currently not supported in Coyote, exiting...");
+        }
+    }
+
+    // Trigger the operations
+    size_t i = 0;
+    while (i < src_sgs.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < src_sgs.size(); credits--, i++) {
+            writeCmd(
+                reinterpret_cast<uint64_t>(dst_sgs[i].addr), localCtrlCmd(ctid, dst_sgs[i], last), 
+                reinterpret_cast<uint64_t>(src_sgs[i].addr), localCtrlCmd(ctid, src_sgs[i], last)
+            );
+            cmd_cnt++;
+            nextCmplSeq(oper, last, src_sgs[i].len);
+        }
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::invokeBatch(CoyoteOper oper, const std::vector<rdmaSg> &sgs, bool last) {
+    // Argument checks
+    DBG1("cThread: Call invokeBatch for " << sgs.size() << " RDMA operations");
+
+    if (!isRemoteRdma(oper)) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called with rdmaSg flags, but the operation is not a REMOTE_READ or REMOTE_WRITE; exiting...");
+    }
+
+    if (!fcnfg.en_rdma) {
+        throw std::runtime_error("ERROR: cThread::invokeBatch() called for an RDMA operation but the shell was not synthesized with RDMA support, exiting...");
+    }
+
+    for (const rdmaSg &sg : sgs) {
+        if (sg.len > MAX_TRANSFER_SIZE) {
+            throw std::runtime_error("ERROR: cThread::invokeBatch() - transfers over 128MB are currently not supported in Coyote, exiting...");
+        }
+    }
+
+    // Same as in invoke(...), identical local and remote node fall back to a memcpy, without touching the command FIFO
+    if (qpair->local.ip_addr == qpair->remote.ip_addr) {
+        DBG1("cThread: remote and local node for RDMA operation are identical; calling memcpy");
+        for (const rdmaSg &sg : sgs) {
+            void *local_addr = (void*) ((uint64_t) qpair->local.vaddr + sg.local_offs);
+            void *remote_addr = (void*) ((uint64_t) qpair->remote.vaddr + sg.remote_offs);
+            memcpy(remote_addr, local_addr, sg.len);
+        }
+        return cmpl_seq[getWbackIndex(oper)];
+    }
+
+    // Trigger the operations
+    uint64_t opcode = ((static_cast<uint64_t>(oper) - REMOTE_OFFS_OPS) & CTRL_OPCODE_MASK) << CTRL_OPCODE_OFFS;
+    size_t i = 0;
+    while (i < sgs.size()) {
+        uint32_t credits = getCmdCredits();
+        for (; credits > 0 && i < sgs.size(); credits--, i++) {
+            const rdmaSg &sg = sgs[i];
+
+            uint64_t ctrl_cmd_l =
+                opcode |
+                ((ctid & CTRL_PID_MASK) << CTRL_PID_OFFS) |
+                ((sg.local_dest & CTRL_DEST_MASK) << CTRL_DEST_OFFS) |
+                (last ? CTRL_LAST : 0x0) |
+                ((sg.local_stream & CTRL_STRM_MASK) << CTRL_STRM_OFFS) | 
+                (static_cast<uint64_t>(sg.len) << CTRL_LEN_OFFS);
+            uint64_t addr_cmd_l = static_cast<uint64_t>((uint64_t) qpair->local.vaddr + sg.local_offs);
+
+            uint64_t ctrl_cmd_r =
+                opcode |
+                ((ctid & CTRL_PID_MASK) << CTRL_PID_OFFS) |
+                ((sg.remote_dest & CTRL_DEST_MASK) << CTRL_DEST_OFFS) |
+                (last ? CTRL_LAST : 0x0) |
+                ((STRM_RDMA & CTRL_STRM_MASK) << CTRL_STRM_OFFS) | 
+                (CTRL_START) |
+                (static_cast<uint64_t>(sg.len) << CTRL_LEN_OFFS);
+            uint64_t addr_cmd_r = static_cast<uint64_t>((uint64_t) qpair->remote.vaddr + sg.remote_offs); 
+
+            if (isRemoteRead(oper)) {
+                writeCmd(addr_cmd_l, ctrl_cmd_l, addr_cmd_r, ctrl_cmd_r);
+            } else {
+                writeCmd(addr_cmd_r, ctrl_cmd_r, addr_cmd_l, ctrl_cmd_l);
+            }
+            cmd_cnt++;
+            nextCmplSeq(oper, last, sgs[i].len);
+        }
+    }
+
+    return cmpl_seq[getWbackIndex(oper)];
+}
+
+uint32_t cThread::nextCmplSeq(CoyoteOper oper, bool last, [[maybe_unused]] uint64_t bytes) {
+    int32_t idx = getWbackIndex(oper);
+    if (idx == -1) {
+        return 0;
+    }
+
+    // LOCAL_TRANSFERs increment both the read and the write counter
+    if (last) {
+        if (isLocalRead(oper) && isLocalWrite(oper)) {
+            cmpl_seq[RD_WBACK]++;
+        }
+        cmpl_seq[idx]++;
+    }
+
+    #ifdef EN_OPER_STATS
+    oper_stats.submit(oper, cmpl_seq[idx], last, bytes);
+    #endif
+
+    return cmpl_seq[idx];
 }
 
 uint32_t cThread::checkCompleted(CoyoteOper coper) const {
+    uint32_t completed = readCompleted(coper);
+
+    #ifdef EN_OPER_STATS
+    oper_stats.observe(getWbackIndex(coper), completed);
+    #endif
+
+    return completed;
+}
+
+uint32_t cThread::readCompleted(CoyoteOper coper) const {
     DBG1("cThread: Called checkCompleted");
     /*
      * The order of these if-else clauses is very important in this function
@@ -902,9 +1382,55 @@ uint32_t cThread::checkCompleted(CoyoteOper coper) const {
     }
 }
 
+bool cThread::isCompleted(CoyoteOper oper, uint32_t seq) const {
+    return static_cast<int32_t>(checkCompleted(oper) - seq) >= 0;
+}
+
+void cThread::waitCompleted(CoyoteOper oper, uint32_t seq) {
+    waitFor([&]() { return isCompleted(oper, seq); }, wait_policy, wait_stats, wait_efd);
+}
+
+void cThread::setWaitPolicy(waitPolicy policy) {
+    if (policy.irq_wakeup && policy.mode != CoyoteWait::SPIN_BLOCK) {
+        throw std::runtime_error("ERROR: cThread::setWaitPolicy() - irq_wakeup requires the CoyoteWait::SPIN_BLOCK mode");
+    }
+
+    if (policy.mode == CoyoteWait::SPIN_BLOCK && wait_efd == -1) {
+        wait_efd = eventfd(0, EFD_NONBLOCK);
+        if (wait_efd == -1) {
+            throw std::runtime_error("ERROR: cThread could not create eventfd");
+        }
+    }
+
+    if (policy.irq_wakeup && efd == -1) {
+        startEventThread(nullptr);
+    }
+
+    wait_policy = policy;
+    irq_wakeup.store(policy.irq_wakeup, std::memory_order_release);
+}
+
+waitPolicy cThread::getWaitPolicy() const { return wait_policy; }
+
+waitStats cThread::getWaitStats() const { return wait_stats; }
+
+void cThread::wakeWaiters() {
+    if (wait_efd != -1) {
+        eventfd_write(wait_efd, 1);
+    }
+}
+
 void cThread::clearCompleted() {
     DBG1("cThread: Called clearCompleted"); 
-    
+
+    for (uint32_t i = 0; i < N_WBACKS; i++) {
+        cmpl_seq[i] = 0;
+    }
+
+    #ifdef EN_OPER_STATS
+    oper_stats.discardInFlight();
+    #endif
+
     if (fcnfg.en_wb) {
         for (int i = 0; i < N_WBACKS; i++) {
             wback[ctid + i * N_CTID_MAX] = 0;
@@ -923,7 +1449,7 @@ void cThread::clearCompleted() {
     #endif
 }
 
-void cThread::doArpLookup(uint32_t ip_addr) {
+void cThread::doArpLookup(uint32_t ip_addr, bool wait) {
     DBG3("cThread: Called doArpLookup for IP address " << ip_addr); 
 
     #ifdef EN_AVX
@@ -936,7 +1462,9 @@ void cThread::doArpLookup(uint32_t ip_addr) {
     }
     #endif
 
-	usleep(SLEEP_TIME);
+    if (wait) {
+        usleep(SLEEP_TIME);
+    }
 }
 
 void cThread::writeQpContext(uint32_t port) {
@@ -1252,6 +1780,15 @@ void cThread::printDebug() const {
 	}
     #endif
 
+    std::cout << std::setw(35) << "NUMA node: \t" << numa_node << std::endl;
+    std::cout << std::setw(35) << "Waits (spin/yield/block): \t" << wait_stats.n_waits << " (" << wait_stats.spin_hits << "/" << wait_stats.yield_hits << "/" << wait_stats.block_hits << ")" << std::endl;
+
+    for (const operStats &stats : getOperStats()) {
+        std::cout << std::setw(35) << std::string(operName(stats.oper)) + " (p50/p99/p999 us): \t" 
+                  << stats.p50_us << "/" << stats.p99_us << "/" << stats.p999_us << ", " << stats.count << " ops, " 
+                  << stats.throughput_gbps << " GB/s" << std::endl;
+    }
+
 	std::cout << std::endl;
 }
 